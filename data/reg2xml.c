@@ -78,6 +78,11 @@ _parse(const gchar *filename,
 			in_entry = TRUE;
 		} else {
 			if (!in_entry) {
+				if (strncmp(buffer, "File-Date: ", 11) == 0) {
+					xmlNewProp(root,
+						   (const xmlChar *)"file-date",
+						   (const xmlChar *)&buffer[11]);
+				}
 				/* ignore it */
 				continue;
 			}
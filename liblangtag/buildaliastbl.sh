@@ -62,17 +62,21 @@ G_BEGIN_DECLS
 typedef struct _lt_localealias_t	lt_localealias_t;
 
 struct _lt_localealias_t {
-	gchar *alias;
-	gchar *locale;
+	const gchar *alias;
+	const gchar *locale;
 };
 
-static lt_localealias_t __lt_localealias_tables[] = {
+/* sorted by the lowercased aliases for the binary search */
+static const lt_localealias_t __lt_localealias_tables[] = {
 EOF
 
-iconv -f iso8859-1 -t utf-8 $1 | sed -e '/^#.*/{d};/^$/{d};' -e 's/^\([^ \t]*\)[ \t]*\([^ \t]*\)$/\t{"\1", "\2"},/'
+# the first entry wins for the duplicate aliases, as the linear search did
+iconv -f iso8859-1 -t utf-8 $1 | \
+    LC_ALL=C awk '!/^#/ && NF == 2 { printf("%s\t%s\n", tolower($1), $2) }' | \
+    LC_ALL=C sort -s -u -t '	' -k 1,1 | \
+    LC_ALL=C awk -F '\t' '{ printf("\t{\"%s\", \"%s\"},\n", $1, $2) }'
 
 cat<<EOF
-	{NULL, NULL}
 };
 
 G_END_DECLS
@@ -26,7 +26,12 @@
 #include <liblangtag/lt-database.h>
 #include <liblangtag/lt-ext-module.h>
 #include <liblangtag/lt-extension.h>
+#include <liblangtag/lt-fallback-iter.h>
+#include <liblangtag/lt-lookup-table.h>
+#include <liblangtag/lt-matcher.h>
 #include <liblangtag/lt-tag.h>
+#include <liblangtag/lt-tag-completion.h>
+#include <liblangtag/lt-tag-map.h>
 #undef __LANGTAG_H__INSIDE
 
 #endif /* __LANGTAG_H__ */
@@ -0,0 +1,40 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-database-private.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __LT_DATABASE_PRIVATE_H__
+#define __LT_DATABASE_PRIVATE_H__
+
+#include <glib.h>
+#include "lt-database.h"
+#include "lt-xml.h"
+
+G_BEGIN_DECLS
+
+lt_db_snapshot_t *lt_db_ref_snapshot    (void);
+lt_xml_t         *lt_db_snapshot_get_xml(lt_db_snapshot_t *snapshot);
+gpointer          lt_db_share_entry     (xmlNodePtr        node,
+                                         gpointer          entry);
+lt_db_snapshot_t *lt_db_pin_snapshot    (void);
+void              lt_db_unpin_snapshot  (lt_db_snapshot_t *snapshot);
+
+G_END_DECLS
+
+#endif /* __LT_DATABASE_PRIVATE_H__ */
@@ -23,12 +23,25 @@
 #include "config.h"
 #endif
 
+#include <errno.h>
 #include <string.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
+#include "lt-error.h"
 #include "lt-mem.h"
 #include "lt-ext-module.h"
 #include "lt-utils.h"
+#include "lt-match-data.h"
+#include "lt-subtag-index.h"
+#include "lt-tag-dfa.h"
+#include "lt-tag-private.h"
+#include "lt-xml.h"
 #include "lt-database.h"
+#include "lt-database-private.h"
 
 
 /**
@@ -37,7 +50,39 @@
  * @Title: Database
  *
  * This section describes convenient functions to obtain the database instance.
+ *
+ * The databases are shared in the process and loaded from the directory
+ * given by lt_db_set_datadir() by default. #lt_db_snapshot_t holds
+ * another set of the databases loaded from the different directory, which
+ * can be used in a thread with lt_db_set_snapshot() at the same time.
+ *
+ * lt_db_reload() replaces the process-wide databases with the new ones
+ * loaded from the same directory. the threads in the middle of parsing
+ * keep using the old ones until they finish, and the new ones are loaded
+ * without blocking them. lt_db_enable_auto_reload() does it whenever
+ * the files in the directory are updated.
  */
+struct _lt_db_snapshot_t {
+	lt_mem_t               parent;
+	gboolean               loading;
+	gchar                 *datadir;
+	lt_xml_t              *xml;
+	lt_lang_db_t          *lang;
+	lt_extlang_db_t       *extlang;
+	lt_script_db_t        *script;
+	lt_region_db_t        *region;
+	lt_variant_db_t       *variant;
+	lt_grandfathered_db_t *grandfathered;
+	lt_redundant_db_t     *redundant;
+	lt_subtag_index_t     *subtag_index;
+	lt_tag_dfa_t          *tag_dfa;
+	lt_match_data_t       *match_data;
+};
+typedef struct _lt_db_watcher_t {
+	GThread *thread;
+	gint     fd;
+	gint     wakeup[2];
+} lt_db_watcher_t;
 
 static lt_lang_db_t          *__db_lang = NULL;
 static lt_extlang_db_t       *__db_extlang = NULL;
@@ -46,11 +91,205 @@ static lt_region_db_t        *__db_region = NULL;
 static lt_variant_db_t       *__db_variant = NULL;
 static lt_grandfathered_db_t *__db_grandfathered = NULL;
 static lt_redundant_db_t     *__db_redundant = NULL;
+static lt_subtag_index_t     *__db_subtag_index = NULL;
+static lt_tag_dfa_t          *__db_tag_dfa = NULL;
+static lt_match_data_t       *__db_match_data = NULL;
 
 static gchar __lt_db_datadir[LT_PATH_MAX] = { 0 };
+static GPrivate __lt_db_snapshot = G_PRIVATE_INIT ((GDestroyNotify)lt_db_snapshot_unref);
+/* the subtag entries shared between the snapshots, keyed by the XML records */
+static GHashTable *__lt_db_entry_pool = NULL;
+/* the databases published by lt_db_reload(), and the number of threads
+ * taking a reference to them.
+ */
+static lt_db_snapshot_t *__lt_db_published = NULL;
+static gint __lt_db_readers = 0;
+static lt_db_watcher_t *__lt_db_watcher = NULL;
+
+G_LOCK_DEFINE_STATIC (lt_db_lang);
+G_LOCK_DEFINE_STATIC (lt_db_extlang);
+G_LOCK_DEFINE_STATIC (lt_db_script);
+G_LOCK_DEFINE_STATIC (lt_db_region);
+G_LOCK_DEFINE_STATIC (lt_db_variant);
+G_LOCK_DEFINE_STATIC (lt_db_grandfathered);
+G_LOCK_DEFINE_STATIC (lt_db_redundant);
+G_LOCK_DEFINE_STATIC (lt_db_subtag_index);
+G_LOCK_DEFINE_STATIC (lt_db_tag_dfa);
+G_LOCK_DEFINE_STATIC (lt_db_match_data);
+G_LOCK_DEFINE_STATIC (lt_db_entry_pool);
+G_LOCK_DEFINE_STATIC (lt_db_reload);
+G_LOCK_DEFINE_STATIC (lt_db_watcher);
+
+#define LT_DB_RELOAD_DELAY	500
 
 
 /*< private >*/
+static gboolean
+_lt_db_entry_is_unused(gpointer key,
+		       gpointer value,
+		       gpointer user_data)
+{
+	return g_atomic_int_get(&((lt_mem_t *)value)->ref_count) == 1;
+}
+
+static void
+_lt_db_entry_pool_prune(void)
+{
+	G_LOCK (lt_db_entry_pool);
+
+	if (__lt_db_entry_pool) {
+		g_hash_table_foreach_remove(__lt_db_entry_pool,
+					    _lt_db_entry_is_unused,
+					    NULL);
+		if (g_hash_table_size(__lt_db_entry_pool) == 0) {
+			g_hash_table_destroy(__lt_db_entry_pool);
+			__lt_db_entry_pool = NULL;
+		}
+	}
+
+	G_UNLOCK (lt_db_entry_pool);
+}
+
+static lt_db_snapshot_t *
+_lt_db_ref_published(void)
+{
+	lt_db_snapshot_t *retval;
+
+	g_atomic_int_inc(&__lt_db_readers);
+	retval = g_atomic_pointer_get(&__lt_db_published);
+	if (retval)
+		lt_db_snapshot_ref(retval);
+	g_atomic_int_add(&__lt_db_readers, -1);
+
+	return retval;
+}
+
+/* Replace the published databases and return the previous ones.
+ * the callers have to hold the lock for lt_db_reload(). the previous ones
+ * can be unref'd safely once nobody is in the middle of
+ * _lt_db_ref_published(), which only takes a reference.
+ */
+static lt_db_snapshot_t *
+_lt_db_publish(lt_db_snapshot_t *snapshot)
+{
+	lt_db_snapshot_t *retval = g_atomic_pointer_get(&__lt_db_published);
+
+	g_atomic_pointer_set(&__lt_db_published, snapshot);
+	while (g_atomic_int_get(&__lt_db_readers) > 0)
+		g_thread_yield();
+
+	return retval;
+}
+
+static const gchar *
+_lt_db_get_default_datadir(void)
+{
+	static const gchar *__builtin_datadir = REGDATADIR;
+
+	if (*__lt_db_datadir != 0)
+		return __lt_db_datadir;
+	return __builtin_datadir;
+}
+
+static lt_db_snapshot_t *
+_lt_db_get_loading_snapshot(void)
+{
+	lt_db_snapshot_t *snapshot = g_private_get(&__lt_db_snapshot);
+
+	return snapshot && snapshot->loading ? snapshot : NULL;
+}
+
+/* the databases of the snapshot are loaded once while it's being created */
+#define DEFUNC_GET_SNAPSHOT_INSTANCE(__type__, __name__)		\
+	G_INLINE_FUNC __type__ ## _t *					\
+	lt_db_snapshot_get_ ##__name__ (lt_db_snapshot_t *snapshot)	\
+	{								\
+		if (!snapshot->__name__ && snapshot->loading) {		\
+			snapshot->__name__ = __type__ ## _new();	\
+			if (snapshot->__name__)				\
+				lt_mem_add_ref(&snapshot->parent,	\
+					       snapshot->__name__,	\
+					       (lt_destroy_func_t)__type__ ## _unref); \
+		}							\
+									\
+		return snapshot->__name__ ? __type__ ## _ref(snapshot->__name__) : NULL; \
+	}
+
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_lang_db, lang)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_extlang_db, extlang)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_script_db, script)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_region_db, region)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_variant_db, variant)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_grandfathered_db, grandfathered)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_redundant_db, redundant)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_subtag_index, subtag_index)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_tag_dfa, tag_dfa)
+DEFUNC_GET_SNAPSHOT_INSTANCE (lt_match_data, match_data)
+
+#undef DEFUNC_GET_SNAPSHOT_INSTANCE
+
+/*< protected >*/
+/* the snapshot in the calling thread, or the published one */
+lt_db_snapshot_t *
+lt_db_ref_snapshot(void)
+{
+	lt_db_snapshot_t *retval = g_private_get(&__lt_db_snapshot);
+
+	if (retval)
+		return lt_db_snapshot_ref(retval);
+
+	return _lt_db_ref_published();
+}
+
+lt_xml_t *
+lt_db_snapshot_get_xml(lt_db_snapshot_t *snapshot)
+{
+	g_return_val_if_fail (snapshot != NULL, NULL);
+
+	return snapshot->xml ? lt_xml_ref(snapshot->xml) : NULL;
+}
+
+gpointer
+lt_db_share_entry(xmlNodePtr node,
+		  gpointer   entry)
+{
+	xmlBufferPtr buffer;
+	gchar *key;
+	gpointer retval;
+
+	/* the process-wide databases don't pay for the pool */
+	if (!node || !entry || !_lt_db_get_loading_snapshot())
+		return entry;
+	buffer = xmlBufferCreate();
+	if (!buffer)
+		return entry;
+	xmlNodeDump(buffer, node->doc, node, 0, 0);
+	key = g_strndup((const gchar *)xmlBufferContent(buffer),
+			xmlBufferLength(buffer));
+	xmlBufferFree(buffer);
+
+	G_LOCK (lt_db_entry_pool);
+
+	if (!__lt_db_entry_pool) {
+		__lt_db_entry_pool = g_hash_table_new_full(g_str_hash,
+							   g_str_equal,
+							   g_free,
+							   (GDestroyNotify)lt_mem_unref);
+	}
+	retval = g_hash_table_lookup(__lt_db_entry_pool, key);
+	if (retval) {
+		lt_mem_ref(retval);
+		lt_mem_unref(entry);
+		g_free(key);
+	} else {
+		retval = entry;
+		g_hash_table_insert(__lt_db_entry_pool, key, lt_mem_ref(entry));
+	}
+
+	G_UNLOCK (lt_db_entry_pool);
+
+	return retval;
+}
 
 /*< public >*/
 /**
@@ -75,18 +314,19 @@ lt_db_set_datadir(const gchar *path)
 /**
  * lt_db_get_datadir:
  *
- * Obtain the directory where database files are installed.
+ * Obtain the directory where database files are installed. this is
+ * the directory of #lt_db_snapshot_t if it's used in the calling thread.
  *
  * Returns: the directory name.
  */
 const gchar *
 lt_db_get_datadir(void)
 {
-	static const gchar *__builtin_datadir = REGDATADIR;
+	lt_db_snapshot_t *snapshot = g_private_get(&__lt_db_snapshot);
 
-	if (*__lt_db_datadir != 0)
-		return __lt_db_datadir;
-	return __builtin_datadir;
+	if (snapshot)
+		return snapshot->datadir;
+	return _lt_db_get_default_datadir();
 }
 
 /**
@@ -97,13 +337,14 @@ lt_db_get_datadir(void)
 void
 lt_db_initialize(void)
 {
-	lt_db_get_lang();
-	lt_db_get_extlang();
-	lt_db_get_script();
-	lt_db_get_region();
-	lt_db_get_variant();
-	lt_db_get_grandfathered();
-	lt_db_get_redundant();
+	lt_lang_db_unref(lt_db_get_lang());
+	lt_extlang_db_unref(lt_db_get_extlang());
+	lt_script_db_unref(lt_db_get_script());
+	lt_region_db_unref(lt_db_get_region());
+	lt_variant_db_unref(lt_db_get_variant());
+	lt_grandfathered_db_unref(lt_db_get_grandfathered());
+	lt_redundant_db_unref(lt_db_get_redundant());
+	lt_subtag_index_unref(lt_db_get_subtag_index());
 	lt_ext_modules_load();
 }
 
@@ -111,34 +352,479 @@ lt_db_initialize(void)
  * lt_db_finalize:
  *
  * Decreases the reference count of the language tags database, which was
- * increased with lt_db_initialize().
+ * increased with lt_db_initialize() or at the first use. this also stops
+ * lt_db_enable_auto_reload() and drops the databases published by
+ * lt_db_reload().
  */
 void
 lt_db_finalize(void)
 {
-	lt_lang_db_unref(__db_lang);
-	lt_extlang_db_unref(__db_extlang);
-	lt_script_db_unref(__db_script);
-	lt_region_db_unref(__db_region);
-	lt_variant_db_unref(__db_variant);
-	lt_grandfathered_db_unref(__db_grandfathered);
-	lt_redundant_db_unref(__db_redundant);
+	lt_db_snapshot_t *published;
+
+	lt_db_disable_auto_reload();
+
+	G_LOCK (lt_db_reload);
+
+	published = _lt_db_publish(NULL);
+
+	G_UNLOCK (lt_db_reload);
+
+	lt_db_snapshot_unref(published);
+#define RELEASE(__type__, __name__)			\
+	G_LOCK (lt_db_ ##__name__);			\
+	__type__ ## _unref(__db_ ##__name__);		\
+	__db_ ##__name__ = NULL;			\
+	G_UNLOCK (lt_db_ ##__name__);
+	RELEASE (lt_lang_db, lang);
+	RELEASE (lt_extlang_db, extlang);
+	RELEASE (lt_script_db, script);
+	RELEASE (lt_region_db, region);
+	RELEASE (lt_variant_db, variant);
+	RELEASE (lt_grandfathered_db, grandfathered);
+	RELEASE (lt_redundant_db, redundant);
+	RELEASE (lt_subtag_index, subtag_index);
+	RELEASE (lt_tag_dfa, tag_dfa);
+	RELEASE (lt_match_data, match_data);
+#undef RELEASE
+	lt_tag_intern_clear();
+	lt_tag_parser_clear();
+	lt_tag_locale_cache_clear();
 	lt_ext_modules_unload();
+	_lt_db_entry_pool_prune();
+}
+
+/**
+ * lt_db_snapshot_new:
+ * @datadir: the directory where database files are installed.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Create a new set of the language tags database loaded from @datadir.
+ * This is independent from the process-wide databases and the other
+ * snapshots, but the identical subtag entries are shared with the other
+ * snapshots to save the memory. Use lt_db_set_snapshot() to parse,
+ * canonicalize or match the tags against it.
+ *
+ * Returns: (transfer full): a new instance of #lt_db_snapshot_t or %NULL
+ *          if fails.
+ */
+lt_db_snapshot_t *
+lt_db_snapshot_new(const gchar  *datadir,
+		   GError      **error)
+{
+	lt_db_snapshot_t *retval, *previous;
+	GError *err = NULL;
+	gpointer db;
+
+	g_return_val_if_fail (datadir != NULL, NULL);
+
+	retval = lt_mem_alloc_object(sizeof (lt_db_snapshot_t));
+	if (!retval) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to allocate memory for lt_db_snapshot_t.");
+		goto bail;
+	}
+	retval->datadir = g_strdup(datadir);
+	lt_mem_add_ref(&retval->parent, retval->datadir,
+		       (lt_destroy_func_t)g_free);
+
+	/* load everything with @retval in use, so that the databases
+	 * depending on the others refer to the ones in @retval.
+	 */
+	previous = g_private_get(&__lt_db_snapshot);
+	if (previous)
+		lt_db_snapshot_ref(previous);
+	g_private_replace(&__lt_db_snapshot, lt_db_snapshot_ref(retval));
+	retval->loading = TRUE;
+	retval->xml = lt_xml_load(&err);
+	if (retval->xml) {
+		lt_mem_add_ref(&retval->parent, retval->xml,
+			       (lt_destroy_func_t)lt_xml_unref);
+#define LOAD(__type__, __name__)					\
+		if (!err) {						\
+			db = lt_db_snapshot_get_ ##__name__ (retval);	\
+			if (!db)					\
+				g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML, \
+					    "Unable to load the %s database from %s", \
+					    #__name__, datadir);	\
+			__type__ ## _unref(db);				\
+		}
+		LOAD (lt_lang_db, lang);
+		LOAD (lt_extlang_db, extlang);
+		LOAD (lt_script_db, script);
+		LOAD (lt_region_db, region);
+		LOAD (lt_variant_db, variant);
+		LOAD (lt_grandfathered_db, grandfathered);
+		LOAD (lt_redundant_db, redundant);
+		LOAD (lt_subtag_index, subtag_index);
+		LOAD (lt_match_data, match_data);
+#undef LOAD
+		/* the parser falls back to the state machine without it */
+		if (!err)
+			lt_tag_dfa_unref(lt_db_snapshot_get_tag_dfa(retval));
+	}
+	retval->loading = FALSE;
+	g_private_replace(&__lt_db_snapshot, previous);
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		lt_db_snapshot_unref(retval);
+		retval = NULL;
+	}
+
+	return retval;
+}
+
+/**
+ * lt_db_snapshot_ref:
+ * @snapshot: a #lt_db_snapshot_t.
+ *
+ * Increases the reference count of @snapshot.
+ *
+ * Returns: (transfer none): the same @snapshot object.
+ */
+lt_db_snapshot_t *
+lt_db_snapshot_ref(lt_db_snapshot_t *snapshot)
+{
+	g_return_val_if_fail (snapshot != NULL, NULL);
+
+	return lt_mem_ref(&snapshot->parent);
+}
+
+/**
+ * lt_db_snapshot_unref:
+ * @snapshot: a #lt_db_snapshot_t.
+ *
+ * Decreases the reference count of @snapshot. when its reference count
+ * drops to 0, the object is finalized (i.e. its memory is freed).
+ */
+void
+lt_db_snapshot_unref(lt_db_snapshot_t *snapshot)
+{
+	if (snapshot) {
+		gboolean last = g_atomic_int_get(&snapshot->parent.ref_count) == 1;
+
+		lt_mem_unref(&snapshot->parent);
+		/* release the entries which nobody else refers to */
+		if (last)
+			_lt_db_entry_pool_prune();
+	}
+}
+
+/**
+ * lt_db_snapshot_get_datadir:
+ * @snapshot: a #lt_db_snapshot_t.
+ *
+ * Obtain the directory which @snapshot was loaded from.
+ *
+ * Returns: the directory name.
+ */
+const gchar *
+lt_db_snapshot_get_datadir(const lt_db_snapshot_t *snapshot)
+{
+	g_return_val_if_fail (snapshot != NULL, NULL);
+
+	return snapshot->datadir;
+}
+
+/**
+ * lt_db_set_snapshot:
+ * @snapshot: (allow-none): a #lt_db_snapshot_t or %NULL.
+ *
+ * Use @snapshot as the language tags database in the calling thread.
+ * all of the functions obtaining the database instance refer to @snapshot
+ * from now on. %NULL goes back to the process-wide databases.
+ * The objects created before, such as #lt_tag_t, keep referring to
+ * the database which was in use at that time.
+ */
+void
+lt_db_set_snapshot(lt_db_snapshot_t *snapshot)
+{
+	g_private_replace(&__lt_db_snapshot,
+			  snapshot ? lt_db_snapshot_ref(snapshot) : NULL);
+}
+
+/**
+ * lt_db_get_snapshot:
+ *
+ * Obtain #lt_db_snapshot_t in use in the calling thread.
+ *
+ * Returns: (transfer none): a #lt_db_snapshot_t or %NULL if
+ *          the process-wide databases are in use.
+ */
+lt_db_snapshot_t *
+lt_db_get_snapshot(void)
+{
+	return g_private_get(&__lt_db_snapshot);
+}
+
+/**
+ * lt_db_reload:
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Load the language tags database again from the directory given by
+ * lt_db_set_datadir() and replace the process-wide databases with them.
+ * The databases are loaded in the calling thread and the other threads
+ * aren't blocked meanwhile, and they don't take any locks to get
+ * the databases. The threads in the middle of parsing keep using
+ * the previous databases until they finish. The previous databases
+ * are still used if loading fails.
+ *
+ * Returns: %TRUE if the databases are replaced, otherwise %FALSE.
+ */
+gboolean
+lt_db_reload(GError **error)
+{
+	lt_db_snapshot_t *snapshot, *previous;
+	GError *err = NULL;
+
+	/* only the callers of this function wait for each other */
+	G_LOCK (lt_db_reload);
+
+	snapshot = lt_db_snapshot_new(_lt_db_get_default_datadir(), &err);
+	if (snapshot) {
+		previous = _lt_db_publish(snapshot);
+		/* the caches refer to the previous databases */
+		lt_tag_intern_clear();
+		lt_tag_parser_clear();
+		lt_tag_locale_cache_clear();
+		lt_db_snapshot_unref(previous);
+	}
+
+	G_UNLOCK (lt_db_reload);
+
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+#ifdef HAVE_SYS_INOTIFY_H
+static gpointer
+_lt_db_watcher_thread(gpointer data)
+{
+	lt_db_watcher_t *watcher = data;
+	struct pollfd fds[2];
+	gchar buffer[4096];
+	gboolean pending = FALSE;
+	int n;
+
+	fds[0].fd = watcher->fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = watcher->wakeup[0];
+	fds[1].events = POLLIN;
+	while (1) {
+		/* wait for the files being settled down before reloading */
+		n = poll(fds, 2, pending ? LT_DB_RELOAD_DELAY : -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			g_warning("Unable to watch the database: %s",
+				  g_strerror(errno));
+			break;
+		}
+		if (fds[1].revents != 0)
+			break;
+		if (n == 0) {
+			pending = FALSE;
+			lt_db_reload(NULL);
+		} else if ((fds[0].revents & POLLIN) != 0) {
+			/* no need to see what is updated */
+			while (read(watcher->fd, buffer, sizeof (buffer)) > 0);
+			pending = TRUE;
+		}
+	}
+
+	return NULL;
 }
 
-#define DEFUNC_GET_INSTANCE(__type__)					\
-	lt_ ##__type__## _db_t *					\
-	lt_db_get_ ##__type__ (void)					\
+static void
+_lt_db_watcher_free(lt_db_watcher_t *watcher)
+{
+	if (watcher->fd >= 0)
+		close(watcher->fd);
+	if (watcher->wakeup[0] >= 0)
+		close(watcher->wakeup[0]);
+	if (watcher->wakeup[1] >= 0)
+		close(watcher->wakeup[1]);
+	g_free(watcher);
+}
+#endif
+
+/**
+ * lt_db_enable_auto_reload:
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Watch the directory given by lt_db_set_datadir() and call lt_db_reload()
+ * in the background thread whenever the database files are updated.
+ * This is only available on the platform supporting inotify.
+ *
+ * Returns: %TRUE if the directory is being watched, otherwise %FALSE.
+ */
+gboolean
+lt_db_enable_auto_reload(GError **error)
+{
+	GError *err = NULL;
+
+	G_LOCK (lt_db_watcher);
+
+	if (!__lt_db_watcher) {
+#ifdef HAVE_SYS_INOTIFY_H
+		static const gchar *subdirs[] = {
+			"",
+			"common/bcp47",
+			"common/supplemental",
+			NULL
+		};
+		const gchar *datadir = _lt_db_get_default_datadir();
+		lt_db_watcher_t *watcher = g_new0(lt_db_watcher_t, 1);
+		gint i;
+
+		watcher->wakeup[0] = watcher->wakeup[1] = -1;
+		watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (watcher->fd < 0 || pipe(watcher->wakeup) < 0) {
+			g_set_error(&err, LT_ERROR, LT_ERR_UNKNOWN,
+				    "Unable to watch %s: %s",
+				    datadir, g_strerror(errno));
+			goto bail;
+		}
+		for (i = 0; subdirs[i] != NULL; i++) {
+			gchar *path = g_build_filename(datadir, subdirs[i], NULL);
+			int wd;
+
+			wd = inotify_add_watch(watcher->fd, path,
+					       IN_CLOSE_WRITE | IN_CREATE |
+					       IN_DELETE | IN_MOVED_FROM |
+					       IN_MOVED_TO);
+			if (wd < 0) {
+				g_set_error(&err, LT_ERROR, LT_ERR_UNKNOWN,
+					    "Unable to watch %s: %s",
+					    path, g_strerror(errno));
+				g_free(path);
+				goto bail;
+			}
+			g_free(path);
+		}
+		watcher->thread = g_thread_try_new("lt-db-reload",
+						   _lt_db_watcher_thread,
+						   watcher,
+						   &err);
+	  bail:
+		if (err)
+			_lt_db_watcher_free(watcher);
+		else
+			__lt_db_watcher = watcher;
+#else
+		g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+			    "Watching the database isn't supported on this platform.");
+#endif
+	}
+
+	G_UNLOCK (lt_db_watcher);
+
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * lt_db_disable_auto_reload:
+ *
+ * Stop watching the directory started by lt_db_enable_auto_reload().
+ * This waits for the reloading in progress in the background thread.
+ */
+void
+lt_db_disable_auto_reload(void)
+{
+	G_LOCK (lt_db_watcher);
+
+#ifdef HAVE_SYS_INOTIFY_H
+	if (__lt_db_watcher) {
+		ssize_t G_GNUC_UNUSED ret;
+
+		ret = write(__lt_db_watcher->wakeup[1], "", 1);
+		g_thread_join(__lt_db_watcher->thread);
+		_lt_db_watcher_free(__lt_db_watcher);
+		__lt_db_watcher = NULL;
+	}
+#endif
+
+	G_UNLOCK (lt_db_watcher);
+}
+
+/*< protected >*/
+/*
+ * Make the published databases current in the calling thread until
+ * lt_db_unpin_snapshot(), so that lt_db_reload() doesn't replace them
+ * in the middle of the operation.
+ */
+lt_db_snapshot_t *
+lt_db_pin_snapshot(void)
+{
+	lt_db_snapshot_t *retval;
+
+	if (g_private_get(&__lt_db_snapshot))
+		return NULL;
+	retval = _lt_db_ref_published();
+	if (retval)
+		g_private_set(&__lt_db_snapshot, retval);
+
+	return retval;
+}
+
+void
+lt_db_unpin_snapshot(lt_db_snapshot_t *snapshot)
+{
+	if (snapshot)
+		g_private_replace(&__lt_db_snapshot, NULL);
+}
+
+/* the process-wide instances are kept until lt_db_finalize().
+ * the lock is only taken to create them.
+ */
+#define DEFUNC_GET_INSTANCE(__type__, __name__)				\
+	__type__ ## _t *						\
+	lt_db_get_ ##__name__ (void)					\
 	{								\
-		if (!__db_ ##__type__) {				\
-			__db_ ##__type__ = lt_ ##__type__## _db_new();	\
-			lt_mem_add_weak_pointer((lt_mem_t *)__db_ ##__type__, \
-						(gpointer *)&__db_ ##__type__);	\
-		} else {						\
-			lt_ ##__type__## _db_ref(__db_ ##__type__);	\
+		lt_db_snapshot_t *snapshot = lt_db_ref_snapshot();	\
+		__type__ ## _t *retval;					\
+									\
+		if (snapshot) {						\
+			retval = lt_db_snapshot_get_ ##__name__ (snapshot); \
+			lt_db_snapshot_unref(snapshot);			\
+									\
+			return retval;					\
+		}							\
+		retval = g_atomic_pointer_get(&__db_ ##__name__);	\
+		if (!retval) {						\
+			G_LOCK (lt_db_ ##__name__);			\
+			retval = __db_ ##__name__;			\
+			if (!retval) {					\
+				retval = __type__ ## _new();		\
+				g_atomic_pointer_set(&__db_ ##__name__, retval); \
+			}						\
+			G_UNLOCK (lt_db_ ##__name__);			\
 		}							\
 									\
-		return __db_ ##__type__;				\
+		return retval ? __type__ ## _ref(retval) : NULL;	\
 	}
 
 /**
@@ -146,68 +832,73 @@ lt_db_finalize(void)
  *
  * Obtains the instance of #lt_lang_db_t. This still allows to use without
  * lt_db_initialize(). but it will takes some time to load the database on
- * the memory every time.
+ * the memory at the first use.
  *
  * Returns: The instance of #lt_lang_db_t.
  */
-DEFUNC_GET_INSTANCE(lang)
+DEFUNC_GET_INSTANCE(lt_lang_db, lang)
 /**
  * lt_db_get_extlang:
  *
  * Obtains the instance of #lt_extlang_db_t. This still allows to use without
  * lt_db_initialize(). but it will takes some time to load the database on
- * the memory every time.
+ * the memory at the first use.
  *
  * Returns: The instance of #lt_extlang_db_t.
  */
-DEFUNC_GET_INSTANCE(extlang)
+DEFUNC_GET_INSTANCE(lt_extlang_db, extlang)
 /**
  * lt_db_get_grandfathered:
  *
  * Obtains the instance of #lt_grandfathered_db_t. This still allows to use
  * without lt_db_initialize(). but it will takes some time to load the database
- * on the memory every time.
+ * on the memory at the first use.
  *
  * Returns: The instance of #lt_grandfathered_db_t.
  */
-DEFUNC_GET_INSTANCE(grandfathered)
+DEFUNC_GET_INSTANCE(lt_grandfathered_db, grandfathered)
 /**
  * lt_db_get_redundant:
  *
  * Obtains the instance of #lt_redundant_db_t. This still allows to use
  * without lt_db_initialize(). but it will takes some time to load the database
- * on the memory every time.
+ * on the memory at the first use.
  *
  * Returns: The instance of #lt_redundant_db_t.
  */
-DEFUNC_GET_INSTANCE(redundant)
+DEFUNC_GET_INSTANCE(lt_redundant_db, redundant)
 /**
  * lt_db_get_region:
  *
  * Obtains the instance of #lt_region_db_t. This still allows to use without
  * lt_db_initialize(). but it will takes some time to load the database on
- * the memory every time.
+ * the memory at the first use.
  *
  * Returns: The instance of #lt_region_db_t.
  */
-DEFUNC_GET_INSTANCE(region)
+DEFUNC_GET_INSTANCE(lt_region_db, region)
 /**
  * lt_db_get_script:
  *
  * Obtains the instance of #lt_script_db_t. This still allows to use without
  * lt_db_initialize(). but it will takes some time to load the database on
- * the memory every time.
+ * the memory at the first use.
  *
  * Returns: The instance of #lt_script_db_t.
  */
-DEFUNC_GET_INSTANCE(script)
+DEFUNC_GET_INSTANCE(lt_script_db, script)
 /**
  * lt_db_get_variant:
  *
  * Obtains the instance of #lt_variant_db_t. This still allows to use without
  * lt_db_initialize(). but it will takes some time to load the database on
- * the memory every time.
+ * the memory at the first use.
  *
  * Returns: The instance of #lt_variant_db_t.
  */
-DEFUNC_GET_INSTANCE(variant)
+DEFUNC_GET_INSTANCE(lt_variant_db, variant)
+
+/*< protected >*/
+DEFUNC_GET_INSTANCE(lt_subtag_index, subtag_index)
+DEFUNC_GET_INSTANCE(lt_tag_dfa, tag_dfa)
+DEFUNC_GET_INSTANCE(lt_match_data, match_data)
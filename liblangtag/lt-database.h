@@ -37,17 +37,35 @@
 
 G_BEGIN_DECLS
 
-void                   lt_db_set_datadir      (const gchar *path);
-const gchar           *lt_db_get_datadir      (void);
-void                   lt_db_initialize       (void);
-void                   lt_db_finalize         (void);
-lt_lang_db_t          *lt_db_get_lang         (void);
-lt_extlang_db_t       *lt_db_get_extlang      (void);
-lt_script_db_t        *lt_db_get_script       (void);
-lt_region_db_t        *lt_db_get_region       (void);
-lt_variant_db_t       *lt_db_get_variant      (void);
-lt_grandfathered_db_t *lt_db_get_grandfathered(void);
-lt_redundant_db_t     *lt_db_get_redundant    (void);
+/**
+ * lt_db_snapshot_t:
+ *
+ * All the fields in the <structname>lt_db_snapshot_t</structname>
+ * structure are private to the #lt_db_snapshot_t implementation.
+ */
+typedef struct _lt_db_snapshot_t	lt_db_snapshot_t;
+
+void                   lt_db_set_datadir         (const gchar             *path);
+const gchar           *lt_db_get_datadir         (void);
+void                   lt_db_initialize          (void);
+void                   lt_db_finalize            (void);
+lt_lang_db_t          *lt_db_get_lang            (void);
+lt_extlang_db_t       *lt_db_get_extlang         (void);
+lt_script_db_t        *lt_db_get_script          (void);
+lt_region_db_t        *lt_db_get_region          (void);
+lt_variant_db_t       *lt_db_get_variant         (void);
+lt_grandfathered_db_t *lt_db_get_grandfathered   (void);
+lt_redundant_db_t     *lt_db_get_redundant       (void);
+lt_db_snapshot_t      *lt_db_snapshot_new        (const gchar             *datadir,
+                                                  GError                 **error);
+lt_db_snapshot_t      *lt_db_snapshot_ref        (lt_db_snapshot_t        *snapshot);
+void                   lt_db_snapshot_unref      (lt_db_snapshot_t        *snapshot);
+const gchar           *lt_db_snapshot_get_datadir(const lt_db_snapshot_t  *snapshot);
+void                   lt_db_set_snapshot        (lt_db_snapshot_t        *snapshot);
+lt_db_snapshot_t      *lt_db_get_snapshot        (void);
+gboolean               lt_db_reload              (GError                 **error);
+gboolean               lt_db_enable_auto_reload  (GError                 **error);
+void                   lt_db_disable_auto_reload (void);
 
 G_END_DECLS
 
@@ -0,0 +1,394 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-description-index.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <libxml/xpath.h>
+#include "lt-error.h"
+#include "lt-mem.h"
+#include "lt-description-index.h"
+
+
+/*
+ * This class is an inverted index from the words in the descriptions to
+ * the subtags, which are registered under /registry/<element>. all of
+ * the descriptions for an entry are indexed, not only the first one.
+ * the words are case-folded and kept in the sorted array, so that
+ * the words starting with the query can be found with the binary search.
+ */
+typedef struct _lt_description_index_token_t {
+	guint offset;
+	guint description;
+} lt_description_index_token_t;
+
+struct _lt_description_index_t {
+	lt_mem_t   parent;
+	GPtrArray *subtags;
+	GArray    *descriptions;
+	GString   *pool;
+	GArray    *tokens;
+};
+
+#define LT_DESCRIPTION_INDEX_IS_WORD_CHAR(_c_)			\
+	(g_ascii_isalnum(_c_) || ((guchar)(_c_)) >= 0x80)
+
+/*< private >*/
+static const gchar *
+_lt_description_index_next_word(const gchar *string,
+				gsize       *length)
+{
+	const gchar *p = string, *start;
+
+	while (*p && !LT_DESCRIPTION_INDEX_IS_WORD_CHAR (*p))
+		p++;
+	for (start = p; *p && LT_DESCRIPTION_INDEX_IS_WORD_CHAR (*p); p++);
+	*length = p - start;
+
+	return *length > 0 ? start : NULL;
+}
+
+static void
+_lt_description_index_add(lt_description_index_t *idx,
+			  const gchar            *description)
+{
+	gchar *s = g_utf8_casefold(description, -1);
+	const gchar *p;
+	gsize len;
+	guint entry = idx->subtags->len - 1;
+
+	for (p = _lt_description_index_next_word(s, &len);
+	     p != NULL;
+	     p = _lt_description_index_next_word(p + len, &len)) {
+		lt_description_index_token_t t;
+
+		t.offset = idx->pool->len;
+		t.description = idx->descriptions->len;
+		g_string_append_len(idx->pool, p, len);
+		g_string_append_c(idx->pool, 0);
+		g_array_append_val(idx->tokens, t);
+	}
+	g_free(s);
+	g_array_append_val(idx->descriptions, entry);
+}
+
+static gint
+_lt_description_index_token_compare(gconstpointer a,
+				    gconstpointer b,
+				    gpointer      data)
+{
+	const lt_description_index_token_t *t1 = a, *t2 = b;
+	const gchar *pool = data;
+	gint retval = strcmp(&pool[t1->offset], &pool[t2->offset]);
+
+	if (retval == 0)
+		retval = t1->description - t2->description;
+
+	return retval;
+}
+
+static gint
+_lt_description_index_uint_compare(gconstpointer a,
+				   gconstpointer b)
+{
+	const guint *v1 = a, *v2 = b;
+
+	return *v1 < *v2 ? -1 : *v1 > *v2;
+}
+
+static gboolean
+lt_description_index_parse(lt_description_index_t  *idx,
+			   lt_xml_t                *xml,
+			   const gchar             *element,
+			   GError                 **error)
+{
+	gboolean retval = TRUE;
+	xmlDocPtr doc = NULL;
+	xmlXPathContextPtr xctxt = NULL;
+	xmlXPathObjectPtr xobj = NULL;
+	GError *err = NULL;
+	gchar *xpath;
+	int i, n;
+
+	doc = lt_xml_get_subtag_registry(xml);
+	xctxt = xmlXPathNewContext(doc);
+	if (!xctxt) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to create an instance of xmlXPathContextPtr.");
+		goto bail;
+	}
+	xpath = g_strdup_printf("/registry/%s", element);
+	xobj = xmlXPathEvalExpression((const xmlChar *)xpath, xctxt);
+	g_free(xpath);
+	if (!xobj) {
+		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+			    "No valid elements for %s",
+			    doc->name);
+		goto bail;
+	}
+	n = xmlXPathNodeSetGetLength(xobj->nodesetval);
+
+	for (i = 0; i < n; i++) {
+		xmlNodePtr ent = xmlXPathNodeSetItem(xobj->nodesetval, i);
+		xmlNodePtr cnode;
+		xmlChar *subtag = NULL, *desc;
+
+		if (!ent) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "Unable to obtain the xml node via XPath.");
+			goto bail;
+		}
+		for (cnode = ent->children; cnode != NULL; cnode = cnode->next) {
+			if (!subtag &&
+			    (xmlStrcmp(cnode->name, (const xmlChar *)"subtag") == 0 ||
+			     xmlStrcmp(cnode->name, (const xmlChar *)"tag") == 0)) {
+				subtag = xmlNodeGetContent(cnode);
+				g_ptr_array_add(idx->subtags,
+						g_strdup((const gchar *)subtag));
+			}
+		}
+		if (!subtag)
+			continue;
+		for (cnode = ent->children; cnode != NULL; cnode = cnode->next) {
+			if (xmlStrcmp(cnode->name, (const xmlChar *)"description") == 0) {
+				desc = xmlNodeGetContent(cnode);
+				if (desc) {
+					_lt_description_index_add(idx, (const gchar *)desc);
+					xmlFree(desc);
+				}
+			}
+		}
+		xmlFree(subtag);
+	}
+	g_array_sort_with_data(idx->tokens,
+			       _lt_description_index_token_compare,
+			       idx->pool->str);
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	if (xobj)
+		xmlXPathFreeObject(xobj);
+	if (xctxt)
+		xmlXPathFreeContext(xctxt);
+
+	return retval;
+}
+
+static void
+_lt_description_index_free_subtags(GPtrArray *array)
+{
+	guint i;
+
+	for (i = 0; i < array->len; i++)
+		g_free(g_ptr_array_index(array, i));
+	g_ptr_array_free(array, TRUE);
+}
+
+static void
+_lt_description_index_array_free(GArray *array)
+{
+	g_array_free(array, TRUE);
+}
+
+/*
+ * Returns the sorted ids of the descriptions that have the word
+ * matching with @word.
+ */
+static GArray *
+_lt_description_index_find(lt_description_index_t *idx,
+			   const gchar            *word,
+			   gsize                   length,
+			   gboolean                prefix)
+{
+	const lt_description_index_token_t *tokens = (const lt_description_index_token_t *)idx->tokens->data;
+	const gchar *pool = idx->pool->str;
+	guint lo = 0, hi = idx->tokens->len, m, i, j;
+	GArray *retval;
+	gint r;
+
+	/* the first token not less than @word */
+	while (lo < hi) {
+		m = lo + (hi - lo) / 2;
+		r = strncmp(&pool[tokens[m].offset], word, length);
+		if (r < 0)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	/* and the tokens that start with @word follow it */
+	for (hi = lo; hi < idx->tokens->len; hi++) {
+		const gchar *t = &pool[tokens[hi].offset];
+
+		if (strncmp(t, word, length) != 0)
+			break;
+	}
+	retval = g_array_sized_new(FALSE, FALSE, sizeof (guint), hi - lo);
+	for (i = lo; i < hi; i++) {
+		if (!prefix && pool[tokens[i].offset + length] != 0)
+			continue;
+		g_array_append_val(retval, tokens[i].description);
+	}
+	g_array_sort(retval, _lt_description_index_uint_compare);
+	for (i = 0, j = 0; i < retval->len; i++) {
+		if (j == 0 ||
+		    g_array_index(retval, guint, j - 1) != g_array_index(retval, guint, i))
+			g_array_index(retval, guint, j++) = g_array_index(retval, guint, i);
+	}
+	g_array_set_size(retval, j);
+
+	return retval;
+}
+
+/*< public >*/
+lt_description_index_t *
+lt_description_index_new(lt_xml_t    *xml,
+			 const gchar *element)
+{
+	lt_description_index_t *retval;
+
+	g_return_val_if_fail (xml != NULL, NULL);
+	g_return_val_if_fail (element != NULL, NULL);
+
+	retval = lt_mem_alloc_object(sizeof (lt_description_index_t));
+	if (retval) {
+		GError *err = NULL;
+
+		retval->subtags = g_ptr_array_new();
+		lt_mem_add_ref(&retval->parent, retval->subtags,
+			       (lt_destroy_func_t)_lt_description_index_free_subtags);
+		retval->descriptions = g_array_new(FALSE, FALSE, sizeof (guint));
+		lt_mem_add_ref(&retval->parent, retval->descriptions,
+			       (lt_destroy_func_t)_lt_description_index_array_free);
+		retval->pool = g_string_new(NULL);
+		lt_mem_add_ref(&retval->parent, retval->pool,
+			       (lt_destroy_func_t)lt_mem_gstring_free);
+		retval->tokens = g_array_new(FALSE, FALSE, sizeof (lt_description_index_token_t));
+		lt_mem_add_ref(&retval->parent, retval->tokens,
+			       (lt_destroy_func_t)_lt_description_index_array_free);
+
+		lt_description_index_parse(retval, xml, element, &err);
+		if (err) {
+			g_printerr(err->message);
+			lt_description_index_unref(retval);
+			retval = NULL;
+			g_error_free(err);
+		}
+	}
+
+	return retval;
+}
+
+lt_description_index_t *
+lt_description_index_ref(lt_description_index_t *idx)
+{
+	g_return_val_if_fail (idx != NULL, NULL);
+
+	return lt_mem_ref(&idx->parent);
+}
+
+void
+lt_description_index_unref(lt_description_index_t *idx)
+{
+	if (idx)
+		lt_mem_unref(&idx->parent);
+}
+
+/*
+ * Returns the list of the objects in @entries, which is keyed by
+ * the subtags, for the descriptions having all of the words in @query.
+ * the objects are ref'd and in the order of the registry.
+ */
+GList *
+lt_description_index_search(lt_description_index_t *idx,
+			    const gchar            *query,
+			    gboolean                prefix,
+			    GHashTable             *entries)
+{
+	GArray *result = NULL, *ids;
+	GList *retval = NULL;
+	gchar *q;
+	const gchar *p;
+	gsize len;
+	guint i, j, k, last = G_MAXUINT;
+
+	g_return_val_if_fail (idx != NULL, NULL);
+	g_return_val_if_fail (query != NULL, NULL);
+	g_return_val_if_fail (entries != NULL, NULL);
+
+	q = g_utf8_casefold(query, -1);
+	for (p = _lt_description_index_next_word(q, &len);
+	     p != NULL;
+	     p = _lt_description_index_next_word(p + len, &len)) {
+		ids = _lt_description_index_find(idx, p, len, prefix);
+		if (!result) {
+			result = ids;
+		} else {
+			/* intersect the sorted ids */
+			for (i = 0, j = 0, k = 0; i < result->len && j < ids->len; ) {
+				guint v1 = g_array_index(result, guint, i);
+				guint v2 = g_array_index(ids, guint, j);
+
+				if (v1 < v2) {
+					i++;
+				} else if (v1 > v2) {
+					j++;
+				} else {
+					g_array_index(result, guint, k++) = v1;
+					i++;
+					j++;
+				}
+			}
+			g_array_set_size(result, k);
+			g_array_free(ids, TRUE);
+		}
+		if (result->len == 0)
+			break;
+	}
+	g_free(q);
+	if (!result)
+		return NULL;
+	for (i = 0; i < result->len; i++) {
+		guint entry = g_array_index(idx->descriptions, guint,
+					    g_array_index(result, guint, i));
+		gpointer obj;
+
+		/* the descriptions for an entry are contiguous */
+		if (entry == last)
+			continue;
+		last = entry;
+		obj = g_hash_table_lookup(entries,
+					  g_ptr_array_index(idx->subtags, entry));
+		if (obj)
+			retval = g_list_prepend(retval, lt_mem_ref(obj));
+	}
+	g_array_free(result, TRUE);
+
+	return g_list_reverse(retval);
+}
@@ -0,0 +1,43 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-description-index.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __LT_DESCRIPTION_INDEX_H__
+#define __LT_DESCRIPTION_INDEX_H__
+
+#include <glib.h>
+#include "lt-xml.h"
+
+G_BEGIN_DECLS
+
+typedef struct _lt_description_index_t	lt_description_index_t;
+
+lt_description_index_t *lt_description_index_new   (lt_xml_t               *xml,
+                                                    const gchar            *element);
+lt_description_index_t *lt_description_index_ref   (lt_description_index_t *idx);
+void                    lt_description_index_unref (lt_description_index_t *idx);
+GList                  *lt_description_index_search(lt_description_index_t *idx,
+                                                    const gchar            *query,
+                                                    gboolean                prefix,
+                                                    GHashTable             *entries);
+
+G_END_DECLS
+
+#endif /* __LT_DESCRIPTION_INDEX_H__ */
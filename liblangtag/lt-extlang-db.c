@@ -24,6 +24,8 @@
 #endif
 
 #include <libxml/xpath.h>
+#include "lt-database-private.h"
+#include "lt-description-index.h"
 #include "lt-error.h"
 #include "lt-extlang.h"
 #include "lt-extlang-private.h"
@@ -42,11 +44,15 @@
  * registered as ISO 639 code.
  */
 struct _lt_extlang_db_t {
-	lt_mem_t    parent;
-	lt_xml_t   *xml;
-	GHashTable *extlang_entries;
+	lt_mem_t                parent;
+	lt_xml_t               *xml;
+	GHashTable             *extlang_entries;
+	GHashTable             *prefix_extlangs;
+	lt_description_index_t *search_index;
 };
 
+G_LOCK_DEFINE_STATIC (lt_extlang_db_search);
+
 /*< private >*/
 static gboolean
 lt_extlang_db_parse(lt_extlang_db_t  *extlangdb,
@@ -156,10 +162,15 @@ lt_extlang_db_parse(lt_extlang_db_t  *extlangdb,
 		if (prefix)
 			lt_extlang_add_prefix(le, (const gchar *)prefix);
 
+		le = lt_db_share_entry(ent, le);
 		s = g_strdup(lt_extlang_get_tag(le));
 		g_hash_table_replace(extlangdb->extlang_entries,
 				     lt_strlower(s),
 				     lt_extlang_ref(le));
+		if (prefix)
+			lt_multimap_prepend(extlangdb->prefix_extlangs,
+					    (const gchar *)prefix,
+					    lt_extlang_ref(le));
 	  bail1:
 		if (subtag)
 			xmlFree(subtag);
@@ -173,6 +184,7 @@ lt_extlang_db_parse(lt_extlang_db_t  *extlangdb,
 			xmlFree(prefix);
 		lt_extlang_unref(le);
 	}
+	lt_multimap_reverse(extlangdb->prefix_extlangs);
   bail:
 	if (err) {
 		if (error)
@@ -208,12 +220,18 @@ lt_extlang_db_new(void)
 		GError *err = NULL;
 		lt_extlang_t *le;
 
-		retval->extlang_entries = g_hash_table_new_full(g_str_hash,
-								g_str_equal,
+		retval->extlang_entries = g_hash_table_new_full(lt_strcase_hash,
+								lt_strcase_equal,
 								g_free,
 								(GDestroyNotify)lt_extlang_unref);
 		lt_mem_add_ref(&retval->parent, retval->extlang_entries,
 			       (lt_destroy_func_t)g_hash_table_destroy);
+		retval->prefix_extlangs = g_hash_table_new_full(lt_strcase_hash,
+								lt_strcase_equal,
+								g_free,
+								(GDestroyNotify)lt_mem_object_list_free);
+		lt_mem_add_ref(&retval->parent, retval->prefix_extlangs,
+			       (lt_destroy_func_t)g_hash_table_destroy);
 
 		le = lt_extlang_create();
 		lt_extlang_set_tag(le, "*");
@@ -294,17 +312,74 @@ lt_extlang_db_lookup(lt_extlang_db_t *extlangdb,
 		     const gchar     *subtag)
 {
 	lt_extlang_t *retval;
-	gchar *s;
 
 	g_return_val_if_fail (extlangdb != NULL, NULL);
 	g_return_val_if_fail (subtag != NULL, NULL);
 
-	s = g_strdup(subtag);
-	retval = g_hash_table_lookup(extlangdb->extlang_entries,
-				     lt_strlower(s));
-	g_free(s);
+	retval = g_hash_table_lookup(extlangdb->extlang_entries, subtag);
 	if (retval)
 		return lt_extlang_ref(retval);
 
 	return NULL;
 }
+
+/**
+ * lt_extlang_db_lookup_by_prefix:
+ * @extlangdb: a #lt_extlang_db_t.
+ * @prefix: a language subtag, such as "zh".
+ *
+ * Obtains the extlangs that have @prefix as Prefix field.
+ *
+ * Returns: (element-type lt_extlang_t) (transfer none): a list of
+ *          #lt_extlang_t in the order of the registry, or %NULL if nothing
+ *          is registered. the list is built when @extlangdb is loaded and
+ *          owned by @extlangdb. it must not be modified or freed.
+ */
+const GList *
+lt_extlang_db_lookup_by_prefix(lt_extlang_db_t *extlangdb,
+			       const gchar     *prefix)
+{
+	g_return_val_if_fail (extlangdb != NULL, NULL);
+	g_return_val_if_fail (prefix != NULL, NULL);
+
+	return g_hash_table_lookup(extlangdb->prefix_extlangs, prefix);
+}
+
+/**
+ * lt_extlang_db_search:
+ * @extlangdb: a #lt_extlang_db_t.
+ * @query: the words to search for in the descriptions, such as "Cantonese".
+ * @prefix: %TRUE to match the words starting with the words in @query,
+ *          otherwise only the whole words match.
+ *
+ * Search #lt_extlang_t whose description contains all of the words in @query.
+ * the words are compared case-insensitively. the index for the search is
+ * built from the database at the first call.
+ *
+ * Returns: (element-type lt_extlang_t) (transfer full): a list of #lt_extlang_t
+ *          in the order of the registry, or %NULL if nothing matched.
+ *          the elements have to be freed with lt_extlang_unref() and
+ *          the list with g_list_free().
+ */
+GList *
+lt_extlang_db_search(lt_extlang_db_t *extlangdb,
+		     const gchar     *query,
+		     gboolean         prefix)
+{
+	g_return_val_if_fail (extlangdb != NULL, NULL);
+	g_return_val_if_fail (query != NULL, NULL);
+
+	G_LOCK (lt_extlang_db_search);
+	if (!extlangdb->search_index) {
+		extlangdb->search_index = lt_description_index_new(extlangdb->xml, "extlang");
+		if (extlangdb->search_index)
+			lt_mem_add_ref(&extlangdb->parent, extlangdb->search_index,
+				       (lt_destroy_func_t)lt_description_index_unref);
+	}
+	G_UNLOCK (lt_extlang_db_search);
+	if (!extlangdb->search_index)
+		return NULL;
+
+	return lt_description_index_search(extlangdb->search_index, query, prefix,
+					   extlangdb->extlang_entries);
+}
@@ -40,11 +40,16 @@ G_BEGIN_DECLS
 typedef struct _lt_extlang_db_t	lt_extlang_db_t;
 
 
-lt_extlang_db_t *lt_extlang_db_new   (void);
-lt_extlang_db_t *lt_extlang_db_ref   (lt_extlang_db_t *extlangdb);
-void             lt_extlang_db_unref (lt_extlang_db_t *extlangdb);
-lt_extlang_t    *lt_extlang_db_lookup(lt_extlang_db_t *extlangdb,
-                                      const gchar     *subtag);
+lt_extlang_db_t *lt_extlang_db_new             (void);
+lt_extlang_db_t *lt_extlang_db_ref             (lt_extlang_db_t *extlangdb);
+void             lt_extlang_db_unref           (lt_extlang_db_t *extlangdb);
+lt_extlang_t    *lt_extlang_db_lookup          (lt_extlang_db_t *extlangdb,
+                                                const gchar     *subtag);
+const GList     *lt_extlang_db_lookup_by_prefix(lt_extlang_db_t *extlangdb,
+                                                const gchar     *prefix);
+GList           *lt_extlang_db_search          (lt_extlang_db_t *extlangdb,
+                                                const gchar     *query,
+                                                gboolean         prefix);
 
 G_END_DECLS
 
@@ -0,0 +1,158 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-fallback-iter.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "lt-match-data.h"
+#include "lt-fallback-iter.h"
+
+
+/**
+ * SECTION: lt-fallback-iter
+ * @Short_Description: An iterator over the fallback chain of Language tag
+ * @Title: Container - Fallback Iterator
+ *
+ * This iterator walks the fallback chain of the language tag to look up
+ * the resources, such as "zh-Hant-HK", "zh-Hant" and "root". the parent
+ * of each step is taken from parentLocales in CLDR if it's listed there,
+ * otherwise the last subtag is truncated. so "pt-AO" falls back to "pt-PT"
+ * and then "pt", and "zh-Hant" goes to "root" directly rather than "zh".
+ *
+ * The extensions and the private use subtags are dropped at first.
+ * the iterator is allocated by the caller, and the steps are written
+ * into the buffer in it. so no memory is allocated while iterating.
+ * The parentLocales data is loaded at the first use and kept until
+ * lt_db_finalize(), and the iterator holds a reference to it.
+ */
+enum {
+	FALLBACK_ITER_BEGIN = 0,
+	FALLBACK_ITER_NEXT,
+	FALLBACK_ITER_END
+};
+
+/*< public >*/
+/**
+ * lt_fallback_iter_init:
+ * @iter: a #lt_fallback_iter_t.
+ * @tag_string: a language tag, such as "zh-Hant-HK". the underscore is
+ *              accepted as the separator as well.
+ *
+ * Initialize @iter to walk the fallback chain from @tag_string.
+ * lt_fallback_iter_finish() has to be called when it's no longer needed.
+ */
+void
+lt_fallback_iter_init(lt_fallback_iter_t *iter,
+		      const gchar        *tag_string)
+{
+	gsize i, start, len;
+
+	g_return_if_fail (iter != NULL);
+	g_return_if_fail (tag_string != NULL);
+
+	iter->data = lt_db_get_match_data();
+	iter->state = FALLBACK_ITER_BEGIN;
+	iter->buffer[0] = 0;
+	for (i = 0, start = 0; ; i++) {
+		gchar c = tag_string[i];
+
+		if (c != 0 && c != '-' && c != '_')
+			continue;
+		len = i - start;
+		/* stop at the singleton for the extensions or the private use */
+		if (len == 0 || (len == 1 && start > 0) ||
+		    i >= LT_FALLBACK_ITER_MAX_LENGTH)
+			break;
+		if (start > 0)
+			iter->buffer[start - 1] = '-';
+		memcpy(&iter->buffer[start], &tag_string[start], len);
+		iter->buffer[i] = 0;
+		if (c == 0)
+			break;
+		start = i + 1;
+	}
+	if (iter->buffer[0] == 0)
+		strcpy(iter->buffer, "root");
+}
+
+/**
+ * lt_fallback_iter_next:
+ * @iter: a #lt_fallback_iter_t.
+ *
+ * Obtains the next step in the fallback chain. the first step is
+ * the language tag given to lt_fallback_iter_init() and the last one
+ * is always "root".
+ *
+ * Returns: a language tag separated by hyphen, or %NULL if no more steps.
+ *          the string is owned by @iter and valid until the next call.
+ */
+const gchar *
+lt_fallback_iter_next(lt_fallback_iter_t *iter)
+{
+	const gchar *parent = NULL;
+	gchar *p;
+
+	g_return_val_if_fail (iter != NULL, NULL);
+
+	switch (iter->state) {
+	    case FALLBACK_ITER_BEGIN:
+		    iter->state = FALLBACK_ITER_NEXT;
+		    break;
+	    case FALLBACK_ITER_NEXT:
+		    if (g_ascii_strcasecmp(iter->buffer, "root") == 0) {
+			    iter->state = FALLBACK_ITER_END;
+			    return NULL;
+		    }
+		    if (iter->data)
+			    parent = lt_match_data_get_parent(iter->data, iter->buffer);
+		    if (parent)
+			    g_strlcpy(iter->buffer, parent, LT_FALLBACK_ITER_MAX_LENGTH);
+		    else if ((p = strrchr(iter->buffer, '-')) != NULL)
+			    *p = 0;
+		    else
+			    strcpy(iter->buffer, "root");
+		    break;
+	    default:
+		    return NULL;
+	}
+
+	return iter->buffer;
+}
+
+/**
+ * lt_fallback_iter_finish:
+ * @iter: a #lt_fallback_iter_t.
+ *
+ * Release the resources held by @iter.
+ */
+void
+lt_fallback_iter_finish(lt_fallback_iter_t *iter)
+{
+	g_return_if_fail (iter != NULL);
+
+	if (iter->data) {
+		lt_match_data_unref(iter->data);
+		iter->data = NULL;
+	}
+	iter->state = FALLBACK_ITER_END;
+}
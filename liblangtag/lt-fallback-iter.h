@@ -0,0 +1,65 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-fallback-iter.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__LANGTAG_H__INSIDE) && !defined (__LANGTAG_COMPILATION)
+#error "Only <liblangtag/langtag.h> can be included directly."
+#endif
+
+#ifndef __LT_FALLBACK_ITER_H__
+#define __LT_FALLBACK_ITER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * LT_FALLBACK_ITER_MAX_LENGTH:
+ *
+ * The size of the buffer in #lt_fallback_iter_t. the longer language tags
+ * are truncated to fit in at the start.
+ */
+#define LT_FALLBACK_ITER_MAX_LENGTH	64
+
+typedef struct _lt_fallback_iter_t	lt_fallback_iter_t;
+
+/**
+ * lt_fallback_iter_t:
+ *
+ * The structure to iterate the fallback chain of the language tag.
+ * this is intended to be allocated on the stack. all the fields
+ * are private.
+ */
+struct _lt_fallback_iter_t {
+	/*< private >*/
+	gpointer data;
+	gint     state;
+	gchar    buffer[LT_FALLBACK_ITER_MAX_LENGTH];
+};
+
+
+void         lt_fallback_iter_init  (lt_fallback_iter_t *iter,
+                                     const gchar        *tag_string);
+const gchar *lt_fallback_iter_next  (lt_fallback_iter_t *iter);
+void         lt_fallback_iter_finish(lt_fallback_iter_t *iter);
+
+G_END_DECLS
+
+#endif /* __LT_FALLBACK_ITER_H__ */
@@ -24,6 +24,7 @@
 #endif
 
 #include <libxml/xpath.h>
+#include "lt-database-private.h"
 #include "lt-error.h"
 #include "lt-grandfathered.h"
 #include "lt-grandfathered-private.h"
@@ -139,6 +140,7 @@ lt_grandfathered_db_parse(lt_grandfathered_db_t  *grandfathereddb,
 		if (preferred)
 			lt_grandfathered_set_preferred_tag(le, (const gchar *)preferred);
 
+		le = lt_db_share_entry(ent, le);
 		s = g_strdup(lt_grandfathered_get_tag(le));
 		g_hash_table_replace(grandfathereddb->grandfathered_entries,
 				     lt_strlower(s),
@@ -186,8 +188,8 @@ lt_grandfathered_db_new(void)
 	if (retval) {
 		GError *err = NULL;
 
-		retval->grandfathered_entries = g_hash_table_new_full(g_str_hash,
-								      g_str_equal,
+		retval->grandfathered_entries = g_hash_table_new_full(lt_strcase_hash,
+								      lt_strcase_equal,
 								      g_free,
 								      (GDestroyNotify)lt_grandfathered_unref);
 		lt_mem_add_ref(&retval->parent, retval->grandfathered_entries,
@@ -260,15 +262,11 @@ lt_grandfathered_db_lookup(lt_grandfathered_db_t *grandfathereddb,
 			   const gchar           *tag)
 {
 	lt_grandfathered_t *retval;
-	gchar *s;
 
 	g_return_val_if_fail (grandfathereddb != NULL, NULL);
 	g_return_val_if_fail (tag != NULL, NULL);
 
-	s = g_strdup(tag);
-	retval = g_hash_table_lookup(grandfathereddb->grandfathered_entries,
-				     lt_strlower(s));
-	g_free(s);
+	retval = g_hash_table_lookup(grandfathereddb->grandfathered_entries, tag);
 	if (retval)
 		return lt_grandfathered_ref(retval);
 
@@ -24,6 +24,8 @@
 #endif
 
 #include <libxml/xpath.h>
+#include "lt-database-private.h"
+#include "lt-description-index.h"
 #include "lt-error.h"
 #include "lt-mem.h"
 #include "lt-utils.h"
@@ -41,11 +43,16 @@
  * registered as ISO 639 code.
  */
 struct _lt_lang_db_t {
-	lt_mem_t    parent;
-	lt_xml_t   *xml;
-	GHashTable *lang_entries;
+	lt_mem_t                parent;
+	lt_xml_t               *xml;
+	GHashTable             *lang_entries;
+	GHashTable             *macrolang_members;
+	GHashTable             *suppress_script_langs;
+	lt_description_index_t *search_index;
 };
 
+G_LOCK_DEFINE_STATIC (lt_lang_db_search);
+
 /*< private >*/
 static gboolean
 lt_lang_db_parse(lt_lang_db_t  *langdb,
@@ -167,10 +174,19 @@ lt_lang_db_parse(lt_lang_db_t  *langdb,
 		if (suppress)
 			lt_lang_set_suppress_script(le, (const gchar *)suppress);
 
+		le = lt_db_share_entry(ent, le);
 		s = g_strdup(lt_lang_get_tag(le));
 		g_hash_table_replace(langdb->lang_entries,
 				     lt_strlower(s),
 				     lt_lang_ref(le));
+		if (macrolang)
+			lt_multimap_prepend(langdb->macrolang_members,
+					    (const gchar *)macrolang,
+					    lt_lang_ref(le));
+		if (suppress)
+			lt_multimap_prepend(langdb->suppress_script_langs,
+					    (const gchar *)suppress,
+					    lt_lang_ref(le));
 	  bail1:
 		if (subtag)
 			xmlFree(subtag);
@@ -186,6 +202,8 @@ lt_lang_db_parse(lt_lang_db_t  *langdb,
 			xmlFree(suppress);
 		lt_lang_unref(le);
 	}
+	lt_multimap_reverse(langdb->macrolang_members);
+	lt_multimap_reverse(langdb->suppress_script_langs);
   bail:
 	if (err) {
 		if (error)
@@ -221,12 +239,24 @@ lt_lang_db_new(void)
 		GError *err = NULL;
 		lt_lang_t *le;
 
-		retval->lang_entries = g_hash_table_new_full(g_str_hash,
-							     g_str_equal,
+		retval->lang_entries = g_hash_table_new_full(lt_strcase_hash,
+							     lt_strcase_equal,
 							     g_free,
 							     (GDestroyNotify)lt_lang_unref);
 		lt_mem_add_ref(&retval->parent, retval->lang_entries,
 			       (lt_destroy_func_t)g_hash_table_destroy);
+		retval->macrolang_members = g_hash_table_new_full(lt_strcase_hash,
+								  lt_strcase_equal,
+								  g_free,
+								  (GDestroyNotify)lt_mem_object_list_free);
+		lt_mem_add_ref(&retval->parent, retval->macrolang_members,
+			       (lt_destroy_func_t)g_hash_table_destroy);
+		retval->suppress_script_langs = g_hash_table_new_full(lt_strcase_hash,
+								      lt_strcase_equal,
+								      g_free,
+								      (GDestroyNotify)lt_mem_object_list_free);
+		lt_mem_add_ref(&retval->parent, retval->suppress_script_langs,
+			       (lt_destroy_func_t)g_hash_table_destroy);
 
 		le = lt_lang_create();
 		lt_lang_set_tag(le, "*");
@@ -302,16 +332,96 @@ lt_lang_db_lookup(lt_lang_db_t *langdb,
 		  const gchar  *subtag)
 {
 	lt_lang_t *retval;
-	gchar *s;
 
 	g_return_val_if_fail (langdb != NULL, NULL);
 	g_return_val_if_fail (subtag != NULL, NULL);
 
-	s = g_strdup(subtag);
-	retval = g_hash_table_lookup(langdb->lang_entries, lt_strlower(s));
-	g_free(s);
+	retval = g_hash_table_lookup(langdb->lang_entries, subtag);
 	if (retval)
 		return lt_lang_ref(retval);
 
 	return NULL;
 }
+
+/**
+ * lt_lang_db_lookup_macrolanguage_members:
+ * @langdb: a #lt_lang_db_t.
+ * @macrolanguage: a subtag of the macrolanguage, such as "zh".
+ *
+ * Obtains the languages that have @macrolanguage as Macrolanguage field.
+ *
+ * Returns: (element-type lt_lang_t) (transfer none): a list of #lt_lang_t
+ *          in the order of the registry, or %NULL if nothing is registered.
+ *          the list is built when @langdb is loaded and owned by @langdb.
+ *          it must not be modified or freed.
+ */
+const GList *
+lt_lang_db_lookup_macrolanguage_members(lt_lang_db_t *langdb,
+					const gchar  *macrolanguage)
+{
+	g_return_val_if_fail (langdb != NULL, NULL);
+	g_return_val_if_fail (macrolanguage != NULL, NULL);
+
+	return g_hash_table_lookup(langdb->macrolang_members, macrolanguage);
+}
+
+/**
+ * lt_lang_db_lookup_by_suppress_script:
+ * @langdb: a #lt_lang_db_t.
+ * @script: a script subtag, such as "Latn".
+ *
+ * Obtains the languages that have @script as Suppress-Script field.
+ *
+ * Returns: (element-type lt_lang_t) (transfer none): a list of #lt_lang_t
+ *          in the order of the registry, or %NULL if nothing is registered.
+ *          the list is built when @langdb is loaded and owned by @langdb.
+ *          it must not be modified or freed.
+ */
+const GList *
+lt_lang_db_lookup_by_suppress_script(lt_lang_db_t *langdb,
+				     const gchar  *script)
+{
+	g_return_val_if_fail (langdb != NULL, NULL);
+	g_return_val_if_fail (script != NULL, NULL);
+
+	return g_hash_table_lookup(langdb->suppress_script_langs, script);
+}
+
+/**
+ * lt_lang_db_search:
+ * @langdb: a #lt_lang_db_t.
+ * @query: the words to search for in the descriptions, such as "Swiss German".
+ * @prefix: %TRUE to match the words starting with the words in @query,
+ *          otherwise only the whole words match.
+ *
+ * Search #lt_lang_t whose description contains all of the words in @query.
+ * the words are compared case-insensitively. the index for the search is
+ * built from the database at the first call.
+ *
+ * Returns: (element-type lt_lang_t) (transfer full): a list of #lt_lang_t
+ *          in the order of the registry, or %NULL if nothing matched.
+ *          the elements have to be freed with lt_lang_unref() and
+ *          the list with g_list_free().
+ */
+GList *
+lt_lang_db_search(lt_lang_db_t *langdb,
+		  const gchar  *query,
+		  gboolean      prefix)
+{
+	g_return_val_if_fail (langdb != NULL, NULL);
+	g_return_val_if_fail (query != NULL, NULL);
+
+	G_LOCK (lt_lang_db_search);
+	if (!langdb->search_index) {
+		langdb->search_index = lt_description_index_new(langdb->xml, "language");
+		if (langdb->search_index)
+			lt_mem_add_ref(&langdb->parent, langdb->search_index,
+				       (lt_destroy_func_t)lt_description_index_unref);
+	}
+	G_UNLOCK (lt_lang_db_search);
+	if (!langdb->search_index)
+		return NULL;
+
+	return lt_description_index_search(langdb->search_index, query, prefix,
+					   langdb->lang_entries);
+}
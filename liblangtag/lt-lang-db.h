@@ -40,11 +40,18 @@ G_BEGIN_DECLS
 typedef struct _lt_lang_db_t		lt_lang_db_t;
 
 
-lt_lang_db_t *lt_lang_db_new   (void);
-lt_lang_db_t *lt_lang_db_ref   (lt_lang_db_t *langdb);
-void          lt_lang_db_unref (lt_lang_db_t *langdb);
-lt_lang_t    *lt_lang_db_lookup(lt_lang_db_t *langdb,
-                                const gchar  *subtag);
+lt_lang_db_t *lt_lang_db_new                          (void);
+lt_lang_db_t *lt_lang_db_ref                          (lt_lang_db_t *langdb);
+void          lt_lang_db_unref                        (lt_lang_db_t *langdb);
+lt_lang_t    *lt_lang_db_lookup                       (lt_lang_db_t *langdb,
+                                                       const gchar  *subtag);
+const GList  *lt_lang_db_lookup_macrolanguage_members (lt_lang_db_t *langdb,
+                                                       const gchar  *macrolanguage);
+const GList  *lt_lang_db_lookup_by_suppress_script    (lt_lang_db_t *langdb,
+                                                       const gchar  *script);
+GList        *lt_lang_db_search                       (lt_lang_db_t *langdb,
+                                                       const gchar  *query,
+                                                       gboolean      prefix);
 
 G_END_DECLS
 
@@ -0,0 +1,387 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-lookup-table.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "lt-error.h"
+#include "lt-mem.h"
+#include "lt-tag.h"
+#include "lt-utils.h"
+#include "lt-lookup-table.h"
+
+/* the canonicalized ranges longer than this are looked up as they are */
+#define LT_LOOKUP_TABLE_BUFSIZE	256
+
+
+/**
+ * SECTION: lt-lookup-table
+ * @Short_Description: A container class for the Lookup scheme in RFC 4647
+ * @Title: Container - Lookup Table
+ *
+ * This container class holds the set of the supported language tags and
+ * finds the one for the prioritized list of the language ranges, according
+ * to the Lookup scheme in RFC 4647. each range is truncated from the end
+ * progressively until it matches any of the supported tags, and the next
+ * range is tried if nothing matches, then the default value is used at last.
+ *
+ * The supported tags are canonicalized and hashed in the case-insensitive
+ * manner when they are added. the ranges are canonicalized in the same way
+ * before the lookup, so that "iw" is found for "he-IL" and "en-Latn-US" is
+ * found for "en-US". the hash of every prefix of the ranges is computed
+ * in one pass from left to right, so that the lookup doesn't build
+ * the truncated ranges.
+ */
+struct _lt_lookup_table_t {
+	lt_mem_t   parent;
+	GPtrArray *tags;
+	GPtrArray *keys;
+	GArray    *entries;
+	GArray    *buckets;
+	gsize      max_length;
+};
+
+typedef struct _lt_lookup_table_entry_t {
+	guint hash;
+	gsize length;
+} lt_lookup_table_entry_t;
+
+/*< private >*/
+static void
+_lt_lookup_table_tags_free(GPtrArray *array)
+{
+	guint i;
+
+	for (i = 0; i < array->len; i++)
+		g_free(g_ptr_array_index(array, i));
+	g_ptr_array_free(array, TRUE);
+}
+
+static void
+_lt_lookup_table_array_free(GArray *array)
+{
+	g_array_free(array, TRUE);
+}
+
+static guint
+_lt_lookup_table_find(lt_lookup_table_t *table,
+		      const gchar       *string,
+		      gsize              length,
+		      guint              hash)
+{
+	const lt_lookup_table_entry_t *entries;
+	const guint *buckets;
+	guint mask, i, b;
+
+	if (table->buckets->len == 0)
+		return 0;
+	entries = (const lt_lookup_table_entry_t *)table->entries->data;
+	buckets = (const guint *)table->buckets->data;
+	mask = table->buckets->len - 1;
+	for (i = hash & mask; (b = buckets[i]) != 0; i = (i + 1) & mask) {
+		const lt_lookup_table_entry_t *e = &entries[b - 1];
+
+		if (e->hash == hash && e->length == length &&
+		    g_ascii_strncasecmp(g_ptr_array_index(table->keys, b - 1),
+					string, length) == 0)
+			return b;
+	}
+
+	return 0;
+}
+
+static void
+_lt_lookup_table_insert(lt_lookup_table_t *table,
+			guint              hash,
+			guint              index)
+{
+	guint *buckets = (guint *)table->buckets->data;
+	guint mask = table->buckets->len - 1, i;
+
+	for (i = hash & mask; buckets[i] != 0; i = (i + 1) & mask);
+	buckets[i] = index + 1;
+}
+
+static void
+_lt_lookup_table_reserve(lt_lookup_table_t *table,
+			 guint              n)
+{
+	const lt_lookup_table_entry_t *entries;
+	guint i, size = MAX (table->buckets->len * 2, 16);
+
+	/* keep the load factor under 1/2 */
+	if (n * 2 <= table->buckets->len)
+		return;
+	g_array_set_size(table->buckets, 0);
+	g_array_set_size(table->buckets, size);
+	memset(table->buckets->data, 0, sizeof (guint) * size);
+	entries = (const lt_lookup_table_entry_t *)table->entries->data;
+	for (i = 0; i < table->entries->len; i++)
+		_lt_lookup_table_insert(table, entries[i].hash, i);
+}
+
+/* Canonicalize @range up to the wildcard into @buffer if possible.
+ * the ranges which can't be parsed as a tag are looked up as they are.
+ */
+static const gchar *
+_lt_lookup_table_canonicalize(lt_tag_t    *tag,
+			      const gchar *range,
+			      gchar       *buffer,
+			      gsize        size)
+{
+	GError *err = NULL;
+	gsize len;
+
+	for (len = 0; range[len] != 0; len++) {
+		if (range[len] == '*' &&
+		    (range[len + 1] == 0 || range[len + 1] == '-'))
+			break;
+	}
+	if (len > 0 && range[len] == '*')
+		len--;
+	if (len == 0)
+		return range;
+	lt_tag_clear(tag);
+	if (!lt_tag_parse_len(tag, range, len, &err) ||
+	    !lt_tag_canonicalize_to_buf(tag, buffer, size, NULL, &err)) {
+		if (err)
+			g_error_free(err);
+		return range;
+	}
+
+	return buffer;
+}
+
+/*< public >*/
+/**
+ * lt_lookup_table_new:
+ *
+ * Create a new instance of #lt_lookup_table_t. the supported language tags
+ * have to be added with lt_lookup_table_add().
+ *
+ * Returns: (transfer full): a new instance of #lt_lookup_table_t.
+ */
+lt_lookup_table_t *
+lt_lookup_table_new(void)
+{
+	lt_lookup_table_t *retval = lt_mem_alloc_object(sizeof (lt_lookup_table_t));
+
+	if (retval) {
+		retval->tags = g_ptr_array_new();
+		lt_mem_add_ref(&retval->parent, retval->tags,
+			       (lt_destroy_func_t)_lt_lookup_table_tags_free);
+		retval->keys = g_ptr_array_new();
+		lt_mem_add_ref(&retval->parent, retval->keys,
+			       (lt_destroy_func_t)_lt_lookup_table_tags_free);
+		retval->entries = g_array_new(FALSE, FALSE, sizeof (lt_lookup_table_entry_t));
+		lt_mem_add_ref(&retval->parent, retval->entries,
+			       (lt_destroy_func_t)_lt_lookup_table_array_free);
+		retval->buckets = g_array_new(FALSE, TRUE, sizeof (guint));
+		lt_mem_add_ref(&retval->parent, retval->buckets,
+			       (lt_destroy_func_t)_lt_lookup_table_array_free);
+	}
+
+	return retval;
+}
+
+/**
+ * lt_lookup_table_ref:
+ * @table: a #lt_lookup_table_t.
+ *
+ * Increases the reference count of @table.
+ *
+ * Returns: (transfer none): the same @table object.
+ */
+lt_lookup_table_t *
+lt_lookup_table_ref(lt_lookup_table_t *table)
+{
+	g_return_val_if_fail (table != NULL, NULL);
+
+	return lt_mem_ref(&table->parent);
+}
+
+/**
+ * lt_lookup_table_unref:
+ * @table: a #lt_lookup_table_t.
+ *
+ * Decreases the reference count of @table. when its reference count
+ * drops to 0, the object is finalized (i.e. its memory is freed).
+ */
+void
+lt_lookup_table_unref(lt_lookup_table_t *table)
+{
+	if (table)
+		lt_mem_unref(&table->parent);
+}
+
+/**
+ * lt_lookup_table_add:
+ * @table: a #lt_lookup_table_t.
+ * @tag_string: a language tag to be supported, such as "zh-Hant-TW".
+ * @error: (allow-none): a #GError.
+ *
+ * Add @tag_string to the supported language tags. the tags which are
+ * canonicalized to the same one are regarded as the same and the first one
+ * is kept.
+ * this isn't thread-safe. all of the supported tags have to be added
+ * before @table is shared.
+ *
+ * Returns: %TRUE if @tag_string is valid, otherwise %FALSE.
+ */
+gboolean
+lt_lookup_table_add(lt_lookup_table_t  *table,
+		    const gchar        *tag_string,
+		    GError            **error)
+{
+	lt_lookup_table_entry_t e;
+	lt_tag_t *tag;
+	gchar *key = NULL;
+	GError *err = NULL;
+
+	g_return_val_if_fail (table != NULL, FALSE);
+	g_return_val_if_fail (tag_string != NULL, FALSE);
+
+	tag = lt_tag_new();
+	if (lt_tag_parse(tag, tag_string, &err))
+		key = lt_tag_canonicalize(tag, &err);
+	lt_tag_unref(tag);
+	if (err)
+		goto bail;
+	e.length = strlen(key);
+	e.hash = lt_strcase_hash_update(5381, key, e.length);
+	if (_lt_lookup_table_find(table, key, e.length, e.hash) != 0)
+		goto bail;
+	_lt_lookup_table_reserve(table, table->entries->len + 1);
+	g_ptr_array_add(table->tags, g_strdup(tag_string));
+	g_ptr_array_add(table->keys, key);
+	key = NULL;
+	g_array_append_val(table->entries, e);
+	_lt_lookup_table_insert(table, e.hash, table->entries->len - 1);
+	table->max_length = MAX (table->max_length, e.length);
+  bail:
+	g_free(key);
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * lt_lookup_table_size:
+ * @table: a #lt_lookup_table_t.
+ *
+ * Obtains the number of the supported language tags in @table.
+ *
+ * Returns: the number of the tags.
+ */
+guint
+lt_lookup_table_size(lt_lookup_table_t *table)
+{
+	g_return_val_if_fail (table != NULL, 0);
+
+	return table->tags->len;
+}
+
+/**
+ * lt_lookup_table_lookup:
+ * @table: a #lt_lookup_table_t.
+ * @ranges: a %NULL-terminated array of the language ranges, such as
+ *          "zh-Hant-CN-x-private1", in the order of the priority.
+ * @default_value: (allow-none): the value to be returned if nothing matches.
+ *
+ * Find the supported language tag for @ranges with the Lookup scheme
+ * in RFC 4647. when a range is truncated, the singleton left at the end is
+ * removed together. the wildcard "*" as a range is ignored, and the subtags
+ * from the wildcard in a range are dropped before the lookup. the ranges
+ * are canonicalized as the supported tags are.
+ * this takes the time proportional to the length of @ranges and is safe
+ * to call from multiple threads at the same time.
+ *
+ * Returns: the supported language tag that matches first, which is owned by
+ *          @table, or @default_value.
+ */
+const gchar *
+lt_lookup_table_lookup(lt_lookup_table_t   *table,
+		       const gchar * const *ranges,
+		       const gchar         *default_value)
+{
+	guint hashes[LT_LOOKUP_TABLE_MAX_SUBTAGS];
+	gsize ends[LT_LOOKUP_TABLE_MAX_SUBTAGS];
+	gboolean singletons[LT_LOOKUP_TABLE_MAX_SUBTAGS];
+	gchar buffer[LT_LOOKUP_TABLE_BUFSIZE];
+	const gchar *retval = default_value;
+	lt_tag_t *tag;
+	gint i;
+
+	g_return_val_if_fail (table != NULL, default_value);
+	g_return_val_if_fail (ranges != NULL, default_value);
+
+	if (table->entries->len == 0)
+		return default_value;
+	tag = lt_tag_new();
+	for (i = 0; ranges[i] != NULL; i++) {
+		const gchar *range = _lt_lookup_table_canonicalize(tag, ranges[i],
+								   buffer,
+								   sizeof (buffer));
+		guint hash = 5381, n = 0, b;
+		gsize j, start = 0, len;
+
+		for (j = 0; n < LT_LOOKUP_TABLE_MAX_SUBTAGS; j++) {
+			if (range[j] != 0 && range[j] != '-')
+				continue;
+			len = j - start;
+			if (len == 0 || j > table->max_length ||
+			    (len == 1 && range[start] == '*'))
+				break;
+			hash = lt_strcase_hash_update(hash, &range[start], len);
+			hashes[n] = hash;
+			ends[n] = j;
+			singletons[n] = len == 1;
+			n++;
+			if (range[j] == 0)
+				break;
+			hash = lt_strcase_hash_update(hash, "-", 1);
+			start = j + 1;
+		}
+		for (; n > 0; n--) {
+			if (singletons[n - 1])
+				continue;
+			b = _lt_lookup_table_find(table, range, ends[n - 1], hashes[n - 1]);
+			if (b != 0) {
+				retval = g_ptr_array_index(table->tags, b - 1);
+				goto bail;
+			}
+		}
+	}
+  bail:
+	lt_tag_unref(tag);
+
+	return retval;
+}
@@ -0,0 +1,63 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-lookup-table.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__LANGTAG_H__INSIDE) && !defined (__LANGTAG_COMPILATION)
+#error "Only <liblangtag/langtag.h> can be included directly."
+#endif
+
+#ifndef __LT_LOOKUP_TABLE_H__
+#define __LT_LOOKUP_TABLE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * LT_LOOKUP_TABLE_MAX_SUBTAGS:
+ *
+ * The maximum number of the subtags in a language range to be truncated
+ * by lt_lookup_table_lookup().
+ */
+#define LT_LOOKUP_TABLE_MAX_SUBTAGS	32
+
+/**
+ * lt_lookup_table_t:
+ *
+ * All the fields in the <structname>lt_lookup_table_t</structname>
+ * structure are private to the #lt_lookup_table_t implementation.
+ */
+typedef struct _lt_lookup_table_t	lt_lookup_table_t;
+
+
+lt_lookup_table_t *lt_lookup_table_new   (void);
+lt_lookup_table_t *lt_lookup_table_ref   (lt_lookup_table_t    *table);
+void               lt_lookup_table_unref (lt_lookup_table_t    *table);
+gboolean           lt_lookup_table_add   (lt_lookup_table_t    *table,
+                                          const gchar          *tag_string,
+                                          GError              **error);
+guint              lt_lookup_table_size  (lt_lookup_table_t    *table);
+const gchar       *lt_lookup_table_lookup(lt_lookup_table_t    *table,
+                                          const gchar * const  *ranges,
+                                          const gchar          *default_value);
+
+G_END_DECLS
+
+#endif /* __LT_LOOKUP_TABLE_H__ */
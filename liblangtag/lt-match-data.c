@@ -0,0 +1,806 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-match-data.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <libxml/xpath.h>
+#include "lt-database.h"
+#include "lt-error.h"
+#include "lt-mem.h"
+#include "lt-subtag-index.h"
+#include "lt-utils.h"
+#include "lt-xml.h"
+#include "lt-match-data.h"
+
+
+/*
+ * This class holds the tables to compute the distance between locales
+ * according to the languageMatching in CLDR, to add the likely subtags
+ * and to find the parent locales for the fallback.
+ * everything is read from the xml files at once when the instance is
+ * created. the subtags are identified by the ids in lt_subtag_index_t,
+ * so that the lookups afterwards are done on the integers only, except
+ * the regions in the match variables, which are resolved through
+ * the territory containment in lt_region_db_t.
+ */
+typedef struct _lt_match_data_rule_t {
+	guint16  desired[3];
+	guint16  supported[3];
+	gint     desired_set;
+	gint     supported_set;
+	guint    level;
+	gboolean oneway;
+	guint    distance;
+	guint    index;
+} lt_match_data_rule_t;
+
+struct _lt_match_data_t {
+	lt_mem_t           parent;
+	lt_subtag_index_t *subtag_index;
+	lt_region_db_t    *regiondb;
+	guint16            und;
+	GHashTable        *likely;
+	GArray            *likely_subtags;
+	GHashTable        *distances;
+	GArray            *rules[3];
+	GPtrArray         *region_sets;
+	guint              defaults[3];
+	GHashTable        *parents;
+};
+
+#define LT_MATCH_DATA_PACK(_l_,_s_,_r_)					\
+	((gint64)(((guint64)(_l_) << 32) | ((guint64)(_s_) << 16) |	\
+		  (guint64)(_r_)))
+#define LT_MATCH_DATA_PAIR(_l1_,_s1_,_l2_,_s2_)				\
+	((gint64)(((guint64)(_l1_) << 48) | ((guint64)(_s1_) << 32) |	\
+		  ((guint64)(_l2_) << 16) | (guint64)(_s2_)))
+#define LT_MATCH_DATA_ENTRY(_i_,_d_)					\
+	(((guint64)(_i_) << 32) | (guint64)(_d_))
+#define LT_MATCH_DATA_ENTRY_INDEX(_e_)		((guint)((_e_) >> 32))
+#define LT_MATCH_DATA_ENTRY_DISTANCE(_e_)	((guint)((_e_) & 0xffffffff))
+
+/*< private >*/
+static void
+_lt_match_data_array_free(GArray *array)
+{
+	g_array_free(array, TRUE);
+}
+
+static void
+_lt_match_data_sets_free(GPtrArray *array)
+{
+	guint i;
+
+	for (i = 0; i < array->len; i++)
+		g_strfreev(g_ptr_array_index(array, i));
+	g_ptr_array_free(array, TRUE);
+}
+
+static void
+_lt_match_data_insert(GHashTable *table,
+		      gint64      key,
+		      guint       value)
+{
+	gint64 *k;
+
+	/* the earlier entries take precedence as the rules are ordered */
+	if (g_hash_table_lookup(table, &key))
+		return;
+	k = g_new(gint64, 1);
+	*k = key;
+	g_hash_table_insert(table, k, GUINT_TO_POINTER (value + 1));
+}
+
+/* the rules without wildcards are stored with the index in the document,
+ * because the first rule matched in the document order takes precedence
+ * over the rules with wildcards too.
+ */
+static void
+_lt_match_data_insert_distance(GHashTable *table,
+			       gint64      key,
+			       guint       index,
+			       guint       distance)
+{
+	gint64 *k;
+	guint64 *v;
+
+	if (g_hash_table_lookup(table, &key))
+		return;
+	k = g_new(gint64, 1);
+	*k = key;
+	v = g_new(guint64, 1);
+	*v = LT_MATCH_DATA_ENTRY (index, distance);
+	g_hash_table_insert(table, k, v);
+}
+
+static gboolean
+_lt_match_data_region_in_set(lt_match_data_t *data,
+			     gint             set,
+			     guint16          region)
+{
+	const gchar *code;
+	gchar **codes;
+	gboolean negate = set < 0, retval = FALSE;
+	gint i;
+
+	codes = g_ptr_array_index(data->region_sets, ABS (set) - 1);
+	code = lt_subtag_index_get_subtag(data->subtag_index, region);
+	if (code) {
+		for (i = 0; codes[i] != NULL; i++) {
+			if (lt_region_db_contains(data->regiondb, codes[i], code)) {
+				retval = TRUE;
+				break;
+			}
+		}
+	}
+
+	return retval != negate;
+}
+
+static gboolean
+_lt_match_data_match_pattern(lt_match_data_t         *data,
+			     const guint16           *pattern,
+			     gint                     set,
+			     guint                    level,
+			     const lt_match_locale_t *locale)
+{
+	if (pattern[0] && pattern[0] != locale->language)
+		return FALSE;
+	if (level > 1 && pattern[1] && pattern[1] != locale->script)
+		return FALSE;
+	if (level > 2) {
+		if (set != 0)
+			return _lt_match_data_region_in_set(data, set, locale->region);
+		if (pattern[2] && pattern[2] != locale->region)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static guint
+_lt_match_data_lookup(lt_match_data_t         *data,
+		      guint                    level,
+		      const lt_match_locale_t *desired,
+		      const lt_match_locale_t *supported)
+{
+	const lt_match_data_rule_t *rules;
+	const guint64 *entry = NULL;
+	gint64 key;
+	guint i;
+
+	if (level < 3) {
+		key = LT_MATCH_DATA_PAIR (desired->language,
+					  level > 1 ? desired->script : 0,
+					  supported->language,
+					  level > 1 ? supported->script : 0);
+		entry = g_hash_table_lookup(data->distances, &key);
+	}
+	rules = (const lt_match_data_rule_t *)data->rules[level - 1]->data;
+	for (i = 0; i < data->rules[level - 1]->len; i++) {
+		const lt_match_data_rule_t *r = &rules[i];
+
+		if (entry && r->index > LT_MATCH_DATA_ENTRY_INDEX (*entry))
+			break;
+		if (_lt_match_data_match_pattern(data, r->desired, r->desired_set, level, desired) &&
+		    _lt_match_data_match_pattern(data, r->supported, r->supported_set, level, supported))
+			return r->distance;
+		if (!r->oneway &&
+		    _lt_match_data_match_pattern(data, r->desired, r->desired_set, level, supported) &&
+		    _lt_match_data_match_pattern(data, r->supported, r->supported_set, level, desired))
+			return r->distance;
+	}
+	if (entry)
+		return LT_MATCH_DATA_ENTRY_DISTANCE (*entry);
+
+	return data->defaults[level - 1];
+}
+
+static gboolean
+_lt_match_data_parse_pattern(lt_match_data_t  *data,
+			     GHashTable       *variables,
+			     const gchar      *pattern,
+			     guint16          *subtags,
+			     gint             *set,
+			     guint            *level)
+{
+	gchar **fields = g_strsplit(pattern, "_", -1);
+	gboolean retval = TRUE;
+	guint i;
+
+	*set = 0;
+	for (i = 0; fields[i] != NULL && retval; i++) {
+		if (i >= 3) {
+			retval = FALSE;
+		} else if (strcmp(fields[i], "*") == 0) {
+			subtags[i] = 0;
+		} else if (i == 2 && fields[i][0] == '$') {
+			gboolean negate = fields[i][1] == '!';
+			gint n = GPOINTER_TO_INT (g_hash_table_lookup(variables,
+								      &fields[i][negate ? 2 : 1]));
+
+			subtags[i] = 0;
+			*set = negate ? -n : n;
+			retval = n != 0;
+		} else {
+			subtags[i] = lt_subtag_index_lookup(data->subtag_index, fields[i]);
+			/* the rules for the subtags not in the registry never match */
+			retval = subtags[i] != 0;
+		}
+	}
+	*level = i;
+	g_strfreev(fields);
+
+	return retval && *level > 0;
+}
+
+static gchar **
+_lt_match_data_expand_variable(lt_match_data_t *data,
+			       GHashTable      *variables,
+			       const gchar     *value)
+{
+	gchar **tokens = g_strsplit(value, "+", -1);
+	GPtrArray *codes = g_ptr_array_new();
+	gint i, j;
+
+	for (i = 0; tokens[i] != NULL; i++) {
+		if (tokens[i][0] == '$') {
+			gint n = GPOINTER_TO_INT (g_hash_table_lookup(variables, &tokens[i][1]));
+
+			if (n > 0) {
+				gchar **refs = g_ptr_array_index(data->region_sets, n - 1);
+
+				for (j = 0; refs[j] != NULL; j++)
+					g_ptr_array_add(codes, g_strdup(refs[j]));
+			}
+		} else if (tokens[i][0] != 0) {
+			g_ptr_array_add(codes, g_strdup(tokens[i]));
+		}
+	}
+	g_ptr_array_add(codes, NULL);
+	g_strfreev(tokens);
+
+	return (gchar **)g_ptr_array_free(codes, FALSE);
+}
+
+static gboolean
+lt_match_data_parse_likely_subtags(lt_match_data_t  *data,
+				   lt_xml_t         *xml,
+				   GError          **error)
+{
+	gboolean retval = TRUE;
+	xmlDocPtr doc = NULL;
+	xmlXPathContextPtr xctxt = NULL;
+	xmlXPathObjectPtr xobj = NULL;
+	GError *err = NULL;
+	int i, n;
+
+	doc = lt_xml_get_cldr(xml, LT_XML_CLDR_SUPPLEMENTAL_LIKELY_SUBTAGS);
+	xctxt = xmlXPathNewContext(doc);
+	if (!xctxt) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to create an instance of xmlXPathContextPtr.");
+		goto bail;
+	}
+	xobj = xmlXPathEvalExpression((const xmlChar *)"/supplementalData/likelySubtags/likelySubtag", xctxt);
+	if (!xobj) {
+		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+			    "No valid elements for %s",
+			    doc->name);
+		goto bail;
+	}
+	n = xmlXPathNodeSetGetLength(xobj->nodesetval);
+
+	for (i = 0; i < n; i++) {
+		xmlNodePtr ent = xmlXPathNodeSetItem(xobj->nodesetval, i);
+		xmlChar *from, *to;
+		lt_match_locale_t f, t;
+
+		if (!ent) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "Unable to obtain the xml node via XPath.");
+			goto bail;
+		}
+		from = xmlGetProp(ent, (const xmlChar *)"from");
+		to = xmlGetProp(ent, (const xmlChar *)"to");
+		if (from && to &&
+		    lt_match_data_parse_locale(data, (const gchar *)from,
+					       strlen((const gchar *)from), &f) &&
+		    lt_match_data_parse_locale(data, (const gchar *)to,
+					       strlen((const gchar *)to), &t)) {
+			g_array_append_val(data->likely_subtags, t);
+			_lt_match_data_insert(data->likely,
+					      LT_MATCH_DATA_PACK (f.language, f.script, f.region),
+					      data->likely_subtags->len - 1);
+		}
+		if (from)
+			xmlFree(from);
+		if (to)
+			xmlFree(to);
+	}
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	if (xobj)
+		xmlXPathFreeObject(xobj);
+	if (xctxt)
+		xmlXPathFreeContext(xctxt);
+
+	return retval;
+}
+
+static gboolean
+lt_match_data_parse_language_matching(lt_match_data_t  *data,
+				      lt_xml_t         *xml,
+				      GError          **error)
+{
+	gboolean retval = TRUE;
+	xmlDocPtr doc = NULL;
+	xmlXPathContextPtr xctxt = NULL;
+	xmlXPathObjectPtr xobj = NULL;
+	GError *err = NULL;
+	GHashTable *variables;
+	int i, n;
+
+	variables = g_hash_table_new_full(g_str_hash, g_str_equal,
+					  g_free, NULL);
+	doc = lt_xml_get_cldr(xml, LT_XML_CLDR_SUPPLEMENTAL_LANGUAGE_INFO);
+	xctxt = xmlXPathNewContext(doc);
+	if (!xctxt) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to create an instance of xmlXPathContextPtr.");
+		goto bail;
+	}
+	xobj = xmlXPathEvalExpression((const xmlChar *)"/supplementalData/languageMatching/languageMatches[@type = 'written_new']/*", xctxt);
+	if (!xobj) {
+		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+			    "No valid elements for %s",
+			    doc->name);
+		goto bail;
+	}
+	n = xmlXPathNodeSetGetLength(xobj->nodesetval);
+
+	for (i = 0; i < n; i++) {
+		xmlNodePtr ent = xmlXPathNodeSetItem(xobj->nodesetval, i);
+
+		if (!ent) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "Unable to obtain the xml node via XPath.");
+			goto bail;
+		}
+		if (xmlStrcmp(ent->name, (const xmlChar *)"matchVariable") == 0) {
+			xmlChar *id = xmlGetProp(ent, (const xmlChar *)"id");
+			xmlChar *value = xmlGetProp(ent, (const xmlChar *)"value");
+
+			if (id && value && id[0] == '$') {
+				g_ptr_array_add(data->region_sets,
+						_lt_match_data_expand_variable(data, variables,
+									       (const gchar *)value));
+				g_hash_table_replace(variables,
+						     g_strdup((const gchar *)&id[1]),
+						     GINT_TO_POINTER (data->region_sets->len));
+			}
+			if (id)
+				xmlFree(id);
+			if (value)
+				xmlFree(value);
+		} else if (xmlStrcmp(ent->name, (const xmlChar *)"languageMatch") == 0) {
+			xmlChar *desired = xmlGetProp(ent, (const xmlChar *)"desired");
+			xmlChar *supported = xmlGetProp(ent, (const xmlChar *)"supported");
+			xmlChar *distance = xmlGetProp(ent, (const xmlChar *)"distance");
+			xmlChar *oneway = xmlGetProp(ent, (const xmlChar *)"oneway");
+			lt_match_data_rule_t r;
+			guint level;
+
+			memset(&r, 0, sizeof (lt_match_data_rule_t));
+			if (desired && supported && distance &&
+			    _lt_match_data_parse_pattern(data, variables,
+							 (const gchar *)desired,
+							 r.desired, &r.desired_set, &r.level) &&
+			    _lt_match_data_parse_pattern(data, variables,
+							 (const gchar *)supported,
+							 r.supported, &r.supported_set, &level) &&
+			    r.level == level) {
+				r.distance = strtoul((const char *)distance, NULL, 10);
+				r.oneway = oneway && xmlStrcmp(oneway, (const xmlChar *)"true") == 0;
+				r.index = i;
+				if (r.level < 3 &&
+				    r.desired[0] && r.supported[0] &&
+				    (r.level == 1 || (r.desired[1] && r.supported[1]))) {
+					/* no wildcards. put it into the table */
+					_lt_match_data_insert_distance(data->distances,
+								       LT_MATCH_DATA_PAIR (r.desired[0], r.desired[1],
+											   r.supported[0], r.supported[1]),
+								       r.index, r.distance);
+					if (!r.oneway)
+						_lt_match_data_insert_distance(data->distances,
+									       LT_MATCH_DATA_PAIR (r.supported[0], r.supported[1],
+												   r.desired[0], r.desired[1]),
+									       r.index, r.distance);
+				} else {
+					g_array_append_val(data->rules[r.level - 1], r);
+				}
+			}
+			if (desired)
+				xmlFree(desired);
+			if (supported)
+				xmlFree(supported);
+			if (distance)
+				xmlFree(distance);
+			if (oneway)
+				xmlFree(oneway);
+		}
+	}
+  bail:
+	g_hash_table_destroy(variables);
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	if (xobj)
+		xmlXPathFreeObject(xobj);
+	if (xctxt)
+		xmlXPathFreeContext(xctxt);
+
+	return retval;
+}
+
+static gchar *
+_lt_match_data_strdup_bcp47(const gchar *string,
+			    gsize        length)
+{
+	gchar *retval = g_strndup(string, length);
+	gsize i;
+
+	for (i = 0; i < length; i++) {
+		if (retval[i] == '_')
+			retval[i] = '-';
+	}
+
+	return retval;
+}
+
+static gboolean
+lt_match_data_parse_parent_locales(lt_match_data_t  *data,
+				   lt_xml_t         *xml,
+				   GError          **error)
+{
+	gboolean retval = TRUE;
+	xmlDocPtr doc = NULL;
+	xmlXPathContextPtr xctxt = NULL;
+	xmlXPathObjectPtr xobj = NULL;
+	GError *err = NULL;
+	int i, n;
+
+	doc = lt_xml_get_cldr(xml, LT_XML_CLDR_SUPPLEMENTAL_DATA);
+	/* the tags are simply truncated without supplementalData.xml */
+	if (!doc)
+		return TRUE;
+	xctxt = xmlXPathNewContext(doc);
+	if (!xctxt) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to create an instance of xmlXPathContextPtr.");
+		goto bail;
+	}
+	/* the ones with the component attribute are for the particular data */
+	xobj = xmlXPathEvalExpression((const xmlChar *)"/supplementalData/parentLocales[not(@component)]/parentLocale", xctxt);
+	if (!xobj) {
+		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+			    "No valid elements for %s",
+			    doc->name);
+		goto bail;
+	}
+	n = xmlXPathNodeSetGetLength(xobj->nodesetval);
+
+	for (i = 0; i < n; i++) {
+		xmlNodePtr ent = xmlXPathNodeSetItem(xobj->nodesetval, i);
+		xmlChar *parent, *locales;
+		const gchar *p, *e;
+
+		if (!ent) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "Unable to obtain the xml node via XPath.");
+			goto bail;
+		}
+		parent = xmlGetProp(ent, (const xmlChar *)"parent");
+		locales = xmlGetProp(ent, (const xmlChar *)"locales");
+		if (parent && locales) {
+			for (p = (const gchar *)locales; *p; p = e) {
+				while (*p == ' ')
+					p++;
+				for (e = p; *e && *e != ' '; e++);
+				if (e == p)
+					break;
+				g_hash_table_replace(data->parents,
+						     _lt_match_data_strdup_bcp47(p, e - p),
+						     _lt_match_data_strdup_bcp47((const gchar *)parent,
+										 strlen((const gchar *)parent)));
+			}
+		}
+		if (parent)
+			xmlFree(parent);
+		if (locales)
+			xmlFree(locales);
+	}
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	if (xobj)
+		xmlXPathFreeObject(xobj);
+	if (xctxt)
+		xmlXPathFreeContext(xctxt);
+
+	return retval;
+}
+
+/*< protected >*/
+lt_match_data_t *
+lt_match_data_new(void)
+{
+	lt_match_data_t *retval = lt_mem_alloc_object(sizeof (lt_match_data_t));
+
+	if (retval) {
+		GError *err = NULL;
+		lt_xml_t *xml;
+		gint i;
+
+		retval->subtag_index = lt_db_get_subtag_index();
+		lt_mem_add_ref(&retval->parent, retval->subtag_index,
+			       (lt_destroy_func_t)lt_subtag_index_unref);
+		retval->regiondb = lt_db_get_region();
+		lt_mem_add_ref(&retval->parent, retval->regiondb,
+			       (lt_destroy_func_t)lt_region_db_unref);
+		retval->und = lt_subtag_index_lookup(retval->subtag_index, "und");
+		retval->likely = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+						       g_free, NULL);
+		lt_mem_add_ref(&retval->parent, retval->likely,
+			       (lt_destroy_func_t)g_hash_table_destroy);
+		retval->likely_subtags = g_array_new(FALSE, FALSE, sizeof (lt_match_locale_t));
+		lt_mem_add_ref(&retval->parent, retval->likely_subtags,
+			       (lt_destroy_func_t)_lt_match_data_array_free);
+		retval->distances = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+							  g_free, g_free);
+		lt_mem_add_ref(&retval->parent, retval->distances,
+			       (lt_destroy_func_t)g_hash_table_destroy);
+		for (i = 0; i < 3; i++) {
+			retval->rules[i] = g_array_new(FALSE, FALSE, sizeof (lt_match_data_rule_t));
+			lt_mem_add_ref(&retval->parent, retval->rules[i],
+				       (lt_destroy_func_t)_lt_match_data_array_free);
+		}
+		retval->region_sets = g_ptr_array_new();
+		lt_mem_add_ref(&retval->parent, retval->region_sets,
+			       (lt_destroy_func_t)_lt_match_data_sets_free);
+		retval->defaults[0] = LT_MATCH_DATA_LANGUAGE_DISTANCE;
+		retval->defaults[1] = LT_MATCH_DATA_SCRIPT_DISTANCE;
+		retval->defaults[2] = LT_MATCH_DATA_REGION_DISTANCE;
+		retval->parents = g_hash_table_new_full(lt_strcase_hash,
+							lt_strcase_equal,
+							g_free, g_free);
+		lt_mem_add_ref(&retval->parent, retval->parents,
+			       (lt_destroy_func_t)g_hash_table_destroy);
+
+		/* the xml files are not needed once the tables are built */
+		xml = lt_xml_new();
+		if (!xml) {
+			lt_match_data_unref(retval);
+			retval = NULL;
+			goto bail;
+		}
+		if (lt_match_data_parse_likely_subtags(retval, xml, &err) &&
+		    lt_match_data_parse_language_matching(retval, xml, &err))
+			lt_match_data_parse_parent_locales(retval, xml, &err);
+		lt_xml_unref(xml);
+		if (err) {
+			g_printerr(err->message);
+			lt_match_data_unref(retval);
+			retval = NULL;
+			g_error_free(err);
+		}
+	}
+  bail:
+
+	return retval;
+}
+
+lt_match_data_t *
+lt_match_data_ref(lt_match_data_t *data)
+{
+	g_return_val_if_fail (data != NULL, NULL);
+
+	return lt_mem_ref(&data->parent);
+}
+
+void
+lt_match_data_unref(lt_match_data_t *data)
+{
+	if (data)
+		lt_mem_unref(&data->parent);
+}
+
+/*
+ * Identify the language, the script and the region in @string, which
+ * may be separated by either hyphen or underscore. the rest of @string
+ * from the variants are ignored. Returns FALSE if the language isn't
+ * in the registry.
+ */
+gboolean
+lt_match_data_parse_locale(lt_match_data_t   *data,
+			   const gchar       *string,
+			   gsize              length,
+			   lt_match_locale_t *locale)
+{
+	const gchar *p = string, *end = string + length, *s;
+	gchar buffer[9];
+	gsize len;
+	guint n;
+
+	g_return_val_if_fail (data != NULL, FALSE);
+	g_return_val_if_fail (string != NULL, FALSE);
+	g_return_val_if_fail (locale != NULL, FALSE);
+
+	memset(locale, 0, sizeof (lt_match_locale_t));
+	for (n = 0; p < end; n++) {
+		for (s = p; s < end && *s != '-' && *s != '_'; s++);
+		len = s - p;
+		if (len == 0 || len >= sizeof (buffer))
+			break;
+		memcpy(buffer, p, len);
+		buffer[len] = 0;
+		if (n == 0) {
+			/* "root" is the same as "und" in CLDR */
+			if (g_ascii_strcasecmp(buffer, "root") == 0)
+				locale->language = data->und;
+			else if (len == 2 || len == 3)
+				locale->language = lt_subtag_index_lookup(data->subtag_index, buffer);
+			if (locale->language == 0)
+				return FALSE;
+		} else if (n == 1 && len == 3 && g_ascii_isalpha(buffer[0])) {
+			/* the extended language subtag is the primary language */
+			guint extlang = lt_subtag_index_lookup(data->subtag_index, buffer);
+
+			if (extlang == 0)
+				break;
+			locale->language = extlang;
+		} else if (len == 4 && g_ascii_isalpha(buffer[0]) &&
+			   locale->script == 0 && locale->region == 0) {
+			locale->script = lt_subtag_index_lookup(data->subtag_index, buffer);
+		} else if (((len == 2 && g_ascii_isalpha(buffer[0])) ||
+			    (len == 3 && g_ascii_isdigit(buffer[0]))) &&
+			   locale->region == 0) {
+			locale->region = lt_subtag_index_lookup(data->subtag_index, buffer);
+		} else {
+			break;
+		}
+		if (s == end)
+			break;
+		p = s + 1;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Fill the missing subtags in @locale with the likely subtags,
+ * following "Add Likely Subtags" in UTS #35.
+ */
+void
+lt_match_data_maximize(lt_match_data_t   *data,
+		       lt_match_locale_t *locale)
+{
+	gint64 keys[5];
+	gpointer p = NULL;
+	guint i, n = 0;
+
+	g_return_if_fail (data != NULL);
+	g_return_if_fail (locale != NULL);
+
+	if (locale->language != data->und && locale->script && locale->region)
+		return;
+	if (locale->script && locale->region)
+		keys[n++] = LT_MATCH_DATA_PACK (locale->language, locale->script, locale->region);
+	if (locale->region)
+		keys[n++] = LT_MATCH_DATA_PACK (locale->language, 0, locale->region);
+	if (locale->script)
+		keys[n++] = LT_MATCH_DATA_PACK (locale->language, locale->script, 0);
+	keys[n++] = LT_MATCH_DATA_PACK (locale->language, 0, 0);
+	if (locale->script && locale->language != data->und)
+		keys[n++] = LT_MATCH_DATA_PACK (data->und, locale->script, 0);
+	for (i = 0; i < n; i++) {
+		if ((p = g_hash_table_lookup(data->likely, &keys[i])) != NULL) {
+			const lt_match_locale_t *l = &g_array_index(data->likely_subtags,
+								    lt_match_locale_t,
+								    GPOINTER_TO_UINT (p) - 1);
+
+			if (locale->language == data->und)
+				locale->language = l->language;
+			if (locale->script == 0)
+				locale->script = l->script;
+			if (locale->region == 0)
+				locale->region = l->region;
+			break;
+		}
+	}
+}
+
+/*
+ * Compute the distance from @desired to @supported, which should be
+ * maximized. that is the sum of the distances of the language, the script
+ * and the region. the equal subtags are always 0, otherwise the first
+ * rule in CLDR which matches both is taken.
+ */
+guint
+lt_match_data_get_distance(lt_match_data_t         *data,
+			   const lt_match_locale_t *desired,
+			   const lt_match_locale_t *supported)
+{
+	guint retval = 0;
+
+	g_return_val_if_fail (data != NULL, G_MAXUINT);
+	g_return_val_if_fail (desired != NULL, G_MAXUINT);
+	g_return_val_if_fail (supported != NULL, G_MAXUINT);
+
+	if (desired->language != supported->language)
+		retval += _lt_match_data_lookup(data, 1, desired, supported);
+	if (desired->script != supported->script)
+		retval += _lt_match_data_lookup(data, 2, desired, supported);
+	if (desired->region != supported->region)
+		retval += _lt_match_data_lookup(data, 3, desired, supported);
+
+	return retval;
+}
+
+/*
+ * Look up the parent locales in CLDR for @locale, which has to be
+ * separated by hyphen. Returns the parent locale separated by hyphen,
+ * or NULL if the parent is given by truncating @locale.
+ */
+const gchar *
+lt_match_data_get_parent(lt_match_data_t *data,
+			 const gchar     *locale)
+{
+	g_return_val_if_fail (data != NULL, NULL);
+	g_return_val_if_fail (locale != NULL, NULL);
+
+	return g_hash_table_lookup(data->parents, locale);
+}
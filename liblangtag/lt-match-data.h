@@ -0,0 +1,62 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-match-data.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __LT_MATCH_DATA_H__
+#define __LT_MATCH_DATA_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* the distances used when no rules in CLDR covers the subtags */
+#define LT_MATCH_DATA_LANGUAGE_DISTANCE	80
+#define LT_MATCH_DATA_SCRIPT_DISTANCE	50
+#define LT_MATCH_DATA_REGION_DISTANCE	4
+
+typedef struct _lt_match_data_t		lt_match_data_t;
+typedef struct _lt_match_locale_t	lt_match_locale_t;
+
+/* the ids are given by lt_subtag_index_t. 0 means the subtag is missing */
+struct _lt_match_locale_t {
+	guint16 language;
+	guint16 script;
+	guint16 region;
+};
+
+lt_match_data_t *lt_match_data_new         (void);
+lt_match_data_t *lt_match_data_ref         (lt_match_data_t         *data);
+void             lt_match_data_unref       (lt_match_data_t         *data);
+gboolean         lt_match_data_parse_locale(lt_match_data_t         *data,
+                                            const gchar             *string,
+                                            gsize                    length,
+                                            lt_match_locale_t       *locale);
+void             lt_match_data_maximize    (lt_match_data_t         *data,
+                                            lt_match_locale_t       *locale);
+guint            lt_match_data_get_distance(lt_match_data_t         *data,
+                                            const lt_match_locale_t *desired,
+                                            const lt_match_locale_t *supported);
+const gchar     *lt_match_data_get_parent  (lt_match_data_t         *data,
+                                            const gchar             *locale);
+lt_match_data_t *lt_db_get_match_data      (void);
+
+G_END_DECLS
+
+#endif /* __LT_MATCH_DATA_H__ */
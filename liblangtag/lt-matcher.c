@@ -0,0 +1,321 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-matcher.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "lt-error.h"
+#include "lt-mem.h"
+#include "lt-match-data.h"
+#include "lt-matcher.h"
+
+
+/**
+ * SECTION: lt-matcher
+ * @Short_Description: A container class to find the best fit of Language tags
+ * @Title: Container - Matcher
+ *
+ * This container class finds the closest language tag in the supported
+ * languages to the languages that the user desires, based on the distances
+ * defined as languageMatching in CLDR. for example, "en-AU" is closer to
+ * "en-GB" than "en-US", and "nb" is close enough to "no".
+ *
+ * The tags are maximized with the likely subtags in CLDR and compared in
+ * the language, the script and the region. everything needed is read from
+ * the xml files when the first instance is created and shared afterwards,
+ * so that lt_matcher_get_best_match() only looks up the tables in memory.
+ * the paradigm locales in CLDR aren't taken into account.
+ */
+struct _lt_matcher_t {
+	lt_mem_t         parent;
+	lt_match_data_t *data;
+	GPtrArray       *tags;
+	GArray          *locales;
+	guint            threshold;
+};
+
+/* the distance added per the position in the list of the desired languages */
+#define LT_MATCHER_DEMOTION	5
+
+/*< private >*/
+static void
+_lt_matcher_tags_free(GPtrArray *array)
+{
+	guint i;
+
+	for (i = 0; i < array->len; i++)
+		g_free(g_ptr_array_index(array, i));
+	g_ptr_array_free(array, TRUE);
+}
+
+static void
+_lt_matcher_array_free(GArray *array)
+{
+	g_array_free(array, TRUE);
+}
+
+static gboolean
+_lt_matcher_parse(lt_matcher_t      *matcher,
+		  const gchar       *tag_string,
+		  lt_match_locale_t *locale)
+{
+	if (!lt_match_data_parse_locale(matcher->data, tag_string,
+					strlen(tag_string), locale))
+		return FALSE;
+	lt_match_data_maximize(matcher->data, locale);
+
+	return TRUE;
+}
+
+/*< public >*/
+/**
+ * lt_matcher_new:
+ *
+ * Create a new instance of #lt_matcher_t. the supported languages have to be
+ * added with lt_matcher_add_supported().
+ *
+ * Returns: (transfer full): a new instance of #lt_matcher_t, or %NULL if
+ *          the data in CLDR isn't available.
+ */
+lt_matcher_t *
+lt_matcher_new(void)
+{
+	lt_matcher_t *retval = lt_mem_alloc_object(sizeof (lt_matcher_t));
+
+	if (retval) {
+		retval->data = lt_db_get_match_data();
+		if (!retval->data) {
+			lt_matcher_unref(retval);
+			retval = NULL;
+			goto bail;
+		}
+		lt_mem_add_ref(&retval->parent, retval->data,
+			       (lt_destroy_func_t)lt_match_data_unref);
+		retval->tags = g_ptr_array_new();
+		lt_mem_add_ref(&retval->parent, retval->tags,
+			       (lt_destroy_func_t)_lt_matcher_tags_free);
+		retval->locales = g_array_new(FALSE, FALSE, sizeof (lt_match_locale_t));
+		lt_mem_add_ref(&retval->parent, retval->locales,
+			       (lt_destroy_func_t)_lt_matcher_array_free);
+		retval->threshold = LT_MATCHER_DEFAULT_THRESHOLD;
+	}
+  bail:
+
+	return retval;
+}
+
+/**
+ * lt_matcher_ref:
+ * @matcher: a #lt_matcher_t.
+ *
+ * Increases the reference count of @matcher.
+ *
+ * Returns: (transfer none): the same @matcher object.
+ */
+lt_matcher_t *
+lt_matcher_ref(lt_matcher_t *matcher)
+{
+	g_return_val_if_fail (matcher != NULL, NULL);
+
+	return lt_mem_ref(&matcher->parent);
+}
+
+/**
+ * lt_matcher_unref:
+ * @matcher: a #lt_matcher_t.
+ *
+ * Decreases the reference count of @matcher. when its reference count
+ * drops to 0, the object is finalized (i.e. its memory is freed).
+ */
+void
+lt_matcher_unref(lt_matcher_t *matcher)
+{
+	if (matcher)
+		lt_mem_unref(&matcher->parent);
+}
+
+/**
+ * lt_matcher_add_supported:
+ * @matcher: a #lt_matcher_t.
+ * @tag_string: a language tag to be supported, such as "en-GB".
+ * @error: (allow-none): a #GError.
+ *
+ * Add @tag_string to the supported languages. the earlier one is preferred
+ * when the distances are the same. this isn't thread-safe. all of the supported
+ * languages have to be added before @matcher is shared.
+ *
+ * Returns: %TRUE if @tag_string is added, or %FALSE if the language in
+ *          @tag_string isn't registered.
+ */
+gboolean
+lt_matcher_add_supported(lt_matcher_t  *matcher,
+			 const gchar   *tag_string,
+			 GError       **error)
+{
+	lt_match_locale_t locale;
+	GError *err = NULL;
+
+	g_return_val_if_fail (matcher != NULL, FALSE);
+	g_return_val_if_fail (tag_string != NULL, FALSE);
+
+	if (!_lt_matcher_parse(matcher, tag_string, &locale)) {
+		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "Unknown language in the tag: %s",
+			    tag_string);
+		goto bail;
+	}
+	g_ptr_array_add(matcher->tags, g_strdup(tag_string));
+	g_array_append_val(matcher->locales, locale);
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * lt_matcher_set_threshold:
+ * @matcher: a #lt_matcher_t.
+ * @threshold: the distance.
+ *
+ * Set the threshold of the distance to find the best match. the supported
+ * languages at @threshold or further are never chosen. the default value
+ * is %LT_MATCHER_DEFAULT_THRESHOLD.
+ */
+void
+lt_matcher_set_threshold(lt_matcher_t *matcher,
+			 guint         threshold)
+{
+	g_return_if_fail (matcher != NULL);
+
+	matcher->threshold = threshold;
+}
+
+/**
+ * lt_matcher_get_threshold:
+ * @matcher: a #lt_matcher_t.
+ *
+ * Obtains the threshold of the distance to find the best match.
+ *
+ * Returns: the distance.
+ */
+guint
+lt_matcher_get_threshold(lt_matcher_t *matcher)
+{
+	g_return_val_if_fail (matcher != NULL, 0);
+
+	return matcher->threshold;
+}
+
+/**
+ * lt_matcher_get_distance:
+ * @matcher: a #lt_matcher_t.
+ * @desired: a language tag that the user desires.
+ * @supported: a language tag to be compared with.
+ *
+ * Compute the distance from @desired to @supported. 0 means they are
+ * equivalent after adding the likely subtags, such as "en" and "en-Latn-US".
+ * the distance may not be symmetric.
+ *
+ * Returns: the distance, or %G_MAXUINT if the language of either one
+ *          isn't registered.
+ */
+guint
+lt_matcher_get_distance(lt_matcher_t *matcher,
+			const gchar  *desired,
+			const gchar  *supported)
+{
+	lt_match_locale_t d, s;
+
+	g_return_val_if_fail (matcher != NULL, G_MAXUINT);
+	g_return_val_if_fail (desired != NULL, G_MAXUINT);
+	g_return_val_if_fail (supported != NULL, G_MAXUINT);
+
+	if (!_lt_matcher_parse(matcher, desired, &d) ||
+	    !_lt_matcher_parse(matcher, supported, &s))
+		return G_MAXUINT;
+
+	return lt_match_data_get_distance(matcher->data, &d, &s);
+}
+
+/**
+ * lt_matcher_get_best_match:
+ * @matcher: a #lt_matcher_t.
+ * @desired: a %NULL-terminated array of the language tags that the user
+ *           desires, in the order of the preference.
+ * @distance: (out) (allow-none): the location to store the distance of
+ *            the best match.
+ *
+ * Find the closest one in the supported languages to @desired. the distance
+ * is increased by 5 per the position in @desired, so that the later ones
+ * are chosen only when they are close enough. this doesn't allocate any
+ * memory and is safe to call from multiple threads at the same time.
+ *
+ * Returns: the supported language tag that is the best match, or %NULL if
+ *          all of them are at the threshold or further. the string is owned
+ *          by @matcher.
+ */
+const gchar *
+lt_matcher_get_best_match(lt_matcher_t        *matcher,
+			  const gchar * const *desired,
+			  guint               *distance)
+{
+	const lt_match_locale_t *locales;
+	lt_match_locale_t d;
+	guint i, j, best = G_MAXUINT, best_index = 0;
+
+	g_return_val_if_fail (matcher != NULL, NULL);
+	g_return_val_if_fail (desired != NULL, NULL);
+
+	locales = (const lt_match_locale_t *)matcher->locales->data;
+	for (i = 0; desired[i] != NULL; i++) {
+		guint demotion = i * LT_MATCHER_DEMOTION;
+
+		if (demotion >= best)
+			break;
+		if (!_lt_matcher_parse(matcher, desired[i], &d))
+			continue;
+		for (j = 0; j < matcher->locales->len; j++) {
+			guint dist = demotion + lt_match_data_get_distance(matcher->data,
+									   &d, &locales[j]);
+
+			if (dist < best) {
+				best = dist;
+				best_index = j;
+			}
+		}
+	}
+	if (distance)
+		*distance = best;
+	if (best >= matcher->threshold)
+		return NULL;
+
+	return g_ptr_array_index(matcher->tags, best_index);
+}
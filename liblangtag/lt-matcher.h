@@ -0,0 +1,68 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-matcher.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__LANGTAG_H__INSIDE) && !defined (__LANGTAG_COMPILATION)
+#error "Only <liblangtag/langtag.h> can be included directly."
+#endif
+
+#ifndef __LT_MATCHER_H__
+#define __LT_MATCHER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * LT_MATCHER_DEFAULT_THRESHOLD:
+ *
+ * The default threshold of the distance for lt_matcher_get_best_match().
+ * the different scripts or the different languages are beyond this.
+ */
+#define LT_MATCHER_DEFAULT_THRESHOLD	50
+
+/**
+ * lt_matcher_t:
+ *
+ * All the fields in the <structname>lt_matcher_t</structname>
+ * structure are private to the #lt_matcher_t implementation.
+ */
+typedef struct _lt_matcher_t	lt_matcher_t;
+
+
+lt_matcher_t *lt_matcher_new           (void);
+lt_matcher_t *lt_matcher_ref           (lt_matcher_t        *matcher);
+void          lt_matcher_unref         (lt_matcher_t        *matcher);
+gboolean      lt_matcher_add_supported (lt_matcher_t        *matcher,
+                                        const gchar         *tag_string,
+                                        GError             **error);
+void          lt_matcher_set_threshold (lt_matcher_t        *matcher,
+                                        guint                threshold);
+guint         lt_matcher_get_threshold (lt_matcher_t        *matcher);
+guint         lt_matcher_get_distance  (lt_matcher_t        *matcher,
+                                        const gchar         *desired,
+                                        const gchar         *supported);
+const gchar  *lt_matcher_get_best_match(lt_matcher_t        *matcher,
+                                        const gchar * const *desired,
+                                        guint               *distance);
+
+G_END_DECLS
+
+#endif /* __LT_MATCHER_H__ */
@@ -36,6 +36,17 @@ lt_mem_gstring_free(GString *string)
 		g_string_free(string, TRUE);
 }
 
+/* Free @list after decreasing the reference count of the objects in it */
+void
+lt_mem_object_list_free(GList *list)
+{
+	GList *l;
+
+	for (l = list; l != NULL; l = g_list_next(l))
+		lt_mem_unref(l->data);
+	g_list_free(list);
+}
+
 /*< public >*/
 gpointer
 lt_mem_alloc_object(gsize size)
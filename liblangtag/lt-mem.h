@@ -53,7 +53,8 @@ void     lt_mem_remove_weak_pointer(lt_mem_t          *object,
                                     gpointer          *p);
 
 /* utility functions */
-void lt_mem_gstring_free(GString *string);
+void lt_mem_gstring_free    (GString *string);
+void lt_mem_object_list_free(GList   *list);
 
 G_END_DECLS
 
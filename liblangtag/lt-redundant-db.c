@@ -24,6 +24,7 @@
 #endif
 
 #include <libxml/xpath.h>
+#include "lt-database-private.h"
 #include "lt-error.h"
 #include "lt-redundant.h"
 #include "lt-redundant-private.h"
@@ -140,6 +141,7 @@ lt_redundant_db_parse(lt_redundant_db_t  *redundantdb,
 		if (preferred)
 			lt_redundant_set_preferred_tag(le, (const gchar *)preferred);
 
+		le = lt_db_share_entry(ent, le);
 		s = g_strdup(lt_redundant_get_tag(le));
 		g_hash_table_replace(redundantdb->redundant_entries,
 				     lt_strlower(s),
@@ -187,8 +189,8 @@ lt_redundant_db_new(void)
 	if (retval) {
 		GError *err = NULL;
 
-		retval->redundant_entries = g_hash_table_new_full(g_str_hash,
-								  g_str_equal,
+		retval->redundant_entries = g_hash_table_new_full(lt_strcase_hash,
+								  lt_strcase_equal,
 								  g_free,
 								  (GDestroyNotify)lt_redundant_unref);
 		lt_mem_add_ref(&retval->parent, retval->redundant_entries,
@@ -261,15 +263,11 @@ lt_redundant_db_lookup(lt_redundant_db_t *redundantdb,
 		       const gchar       *tag)
 {
 	lt_redundant_t *retval;
-	gchar *s;
 
 	g_return_val_if_fail (redundantdb != NULL, NULL);
 	g_return_val_if_fail (tag != NULL, NULL);
 
-	s = g_strdup(tag);
-	retval = g_hash_table_lookup(redundantdb->redundant_entries,
-				     lt_strlower(s));
-	g_free(s);
+	retval = g_hash_table_lookup(redundantdb->redundant_entries, tag);
 	if (retval)
 		return lt_redundant_ref(retval);
 
@@ -23,7 +23,10 @@
 #include "config.h"
 #endif
 
+#include <string.h>
 #include <libxml/xpath.h>
+#include "lt-database-private.h"
+#include "lt-description-index.h"
 #include "lt-error.h"
 #include "lt-mem.h"
 #include "lt-utils.h"
@@ -42,11 +45,17 @@
  * registered as ISO 3166-1 and UN M.49 code.
  */
 struct _lt_region_db_t {
-	lt_mem_t    parent;
-	lt_xml_t   *xml;
-	GHashTable *region_entries;
+	lt_mem_t                parent;
+	lt_xml_t               *xml;
+	GHashTable             *region_entries;
+	lt_description_index_t *search_index;
+	GHashTable             *containment_ids;
+	GArray                 *containment;
+	guint                   containment_words;
 };
 
+G_LOCK_DEFINE_STATIC (lt_region_db_search);
+
 
 /*< private >*/
 static gboolean
@@ -141,6 +150,7 @@ lt_region_db_parse(lt_region_db_t  *regiondb,
 		if (preferred)
 			lt_region_set_preferred_tag(le, (const gchar *)preferred);
 
+		le = lt_db_share_entry(ent, le);
 		s = g_strdup(lt_region_get_tag(le));
 		g_hash_table_replace(regiondb->region_entries,
 				     lt_strlower(s),
@@ -172,6 +182,160 @@ lt_region_db_parse(lt_region_db_t  *regiondb,
 	return retval;
 }
 
+static guint
+_lt_region_db_get_containment_id(lt_region_db_t *regiondb,
+				 const gchar    *region,
+				 gsize           length)
+{
+	gchar *s = g_strndup(region, length);
+	guint retval = GPOINTER_TO_UINT (g_hash_table_lookup(regiondb->containment_ids, s));
+
+	if (retval == 0) {
+		retval = g_hash_table_size(regiondb->containment_ids) + 1;
+		g_hash_table_insert(regiondb->containment_ids, s,
+				    GUINT_TO_POINTER (retval));
+	} else {
+		g_free(s);
+	}
+
+	return retval;
+}
+
+/*
+ * Build the bitsets from CLDR territoryContainment, where the bit N in
+ * the row for the region M is set if the region which has the id N + 1
+ * is contained in M directly or indirectly. the deprecated groups and
+ * the groupings which aren't in UN M.49, such as EU, are skipped.
+ * nothing is contained if supplementalData.xml isn't installed.
+ */
+static gboolean
+lt_region_db_parse_containment(lt_region_db_t  *regiondb,
+			       GError         **error)
+{
+	gboolean retval = TRUE, changed;
+	xmlDocPtr doc = NULL;
+	xmlXPathContextPtr xctxt = NULL;
+	xmlXPathObjectPtr xobj = NULL;
+	GError *err = NULL;
+	GArray *edges;
+	guint32 *rows;
+	guint i, j, n_regions;
+	int n;
+
+	g_return_val_if_fail (regiondb != NULL, FALSE);
+
+	doc = lt_xml_get_cldr(regiondb->xml, LT_XML_CLDR_SUPPLEMENTAL_DATA);
+	if (!doc)
+		return TRUE;
+	edges = g_array_new(FALSE, FALSE, sizeof (guint));
+	xctxt = xmlXPathNewContext(doc);
+	if (!xctxt) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to create an instance of xmlXPathContextPtr.");
+		goto bail;
+	}
+	xobj = xmlXPathEvalExpression((const xmlChar *)"/supplementalData/territoryContainment/group", xctxt);
+	if (!xobj) {
+		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+			    "No valid elements for %s",
+			    doc->name);
+		goto bail;
+	}
+	n = xmlXPathNodeSetGetLength(xobj->nodesetval);
+
+	for (i = 0; i < (guint)n; i++) {
+		xmlNodePtr ent = xmlXPathNodeSetItem(xobj->nodesetval, i);
+		xmlChar *type, *contains, *status;
+		const gchar *p, *s;
+		guint parent, child;
+
+		if (!ent) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "Unable to obtain the xml node via XPath.");
+			goto bail;
+		}
+		status = xmlGetProp(ent, (const xmlChar *)"status");
+		if (status) {
+			gboolean skip = xmlStrcmp(status, (const xmlChar *)"deprecated") == 0 ||
+				xmlStrcmp(status, (const xmlChar *)"grouping") == 0;
+
+			xmlFree(status);
+			if (skip)
+				continue;
+		}
+		type = xmlGetProp(ent, (const xmlChar *)"type");
+		contains = xmlGetProp(ent, (const xmlChar *)"contains");
+		if (type && contains) {
+			parent = _lt_region_db_get_containment_id(regiondb,
+								  (const gchar *)type,
+								  strlen((const gchar *)type));
+			for (p = (const gchar *)contains; *p; p = s) {
+				while (*p == ' ')
+					p++;
+				for (s = p; *s && *s != ' '; s++);
+				if (s == p)
+					break;
+				child = _lt_region_db_get_containment_id(regiondb, p, s - p);
+				g_array_append_val(edges, parent);
+				g_array_append_val(edges, child);
+			}
+		}
+		if (type)
+			xmlFree(type);
+		if (contains)
+			xmlFree(contains);
+	}
+	n_regions = g_hash_table_size(regiondb->containment_ids);
+	regiondb->containment_words = (n_regions + 31) / 32;
+	g_array_set_size(regiondb->containment,
+			 (n_regions + 1) * regiondb->containment_words);
+	rows = (guint32 *)regiondb->containment->data;
+	for (i = 0; i < edges->len; i += 2) {
+		guint parent = g_array_index(edges, guint, i);
+		guint child = g_array_index(edges, guint, i + 1) - 1;
+
+		rows[parent * regiondb->containment_words + child / 32] |= 1U << (child % 32);
+	}
+	/* the transitive closure. the hierarchy is shallow enough */
+	do {
+		changed = FALSE;
+		for (i = 0; i < edges->len; i += 2) {
+			guint32 *prow = &rows[g_array_index(edges, guint, i) * regiondb->containment_words];
+			guint32 *crow = &rows[g_array_index(edges, guint, i + 1) * regiondb->containment_words];
+
+			for (j = 0; j < regiondb->containment_words; j++) {
+				if ((prow[j] | crow[j]) != prow[j]) {
+					prow[j] |= crow[j];
+					changed = TRUE;
+				}
+			}
+		}
+	} while (changed);
+  bail:
+	g_array_free(edges, TRUE);
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	if (xobj)
+		xmlXPathFreeObject(xobj);
+	if (xctxt)
+		xmlXPathFreeContext(xctxt);
+
+	return retval;
+}
+
+static void
+_lt_region_db_array_free(GArray *array)
+{
+	g_array_free(array, TRUE);
+}
+
 /*< public >*/
 /**
  * lt_region_db_new:
@@ -189,12 +353,21 @@ lt_region_db_new(void)
 		GError *err = NULL;
 		lt_region_t *le;
 
-		retval->region_entries = g_hash_table_new_full(g_str_hash,
-							       g_str_equal,
+		retval->region_entries = g_hash_table_new_full(lt_strcase_hash,
+							       lt_strcase_equal,
 							       g_free,
 							       (GDestroyNotify)lt_region_unref);
 		lt_mem_add_ref(&retval->parent, retval->region_entries,
 			       (lt_destroy_func_t)g_hash_table_destroy);
+		retval->containment_ids = g_hash_table_new_full(lt_strcase_hash,
+								lt_strcase_equal,
+								g_free,
+								NULL);
+		lt_mem_add_ref(&retval->parent, retval->containment_ids,
+			       (lt_destroy_func_t)g_hash_table_destroy);
+		retval->containment = g_array_new(FALSE, TRUE, sizeof (guint32));
+		lt_mem_add_ref(&retval->parent, retval->containment,
+			       (lt_destroy_func_t)_lt_region_db_array_free);
 
 		le = lt_region_create();
 		lt_region_set_tag(le, "*");
@@ -218,7 +391,8 @@ lt_region_db_new(void)
 		lt_mem_add_ref(&retval->parent, retval->xml,
 			       (lt_destroy_func_t)lt_xml_unref);
 
-		lt_region_db_parse(retval, &err);
+		if (lt_region_db_parse(retval, &err))
+			lt_region_db_parse_containment(retval, &err);
 		if (err) {
 			g_printerr(err->message);
 			lt_region_db_unref(retval);
@@ -277,17 +451,91 @@ lt_region_db_lookup(lt_region_db_t *regiondb,
 		    const gchar    *language_or_code)
 {
 	lt_region_t *retval;
-	gchar *s;
 
 	g_return_val_if_fail (regiondb != NULL, NULL);
 	g_return_val_if_fail (language_or_code != NULL, NULL);
 
-	s = g_strdup(language_or_code);
-	retval = g_hash_table_lookup(regiondb->region_entries,
-				     lt_strlower(s));
-	g_free(s);
+	retval = g_hash_table_lookup(regiondb->region_entries, language_or_code);
 	if (retval)
 		return lt_region_ref(retval);
 
 	return NULL;
 }
+
+/**
+ * lt_region_db_contains:
+ * @regiondb: a #lt_region_db_t.
+ * @container: a region code, such as "419".
+ * @region: a region code, such as "MX".
+ *
+ * Checks if @region is within @container according to the territory
+ * containment in CLDR, which is based on UN M.49. the groupings out of
+ * M.49, such as "EU" and "UN", don't contain any regions. the containment
+ * is precomputed when the database is loaded, so that this costs
+ * the lookups of the codes and a bit test.
+ *
+ * Returns: %TRUE if @region is the same as @container or contained in
+ *          @container directly or indirectly, otherwise %FALSE.
+ */
+gboolean
+lt_region_db_contains(lt_region_db_t *regiondb,
+		      const gchar    *container,
+		      const gchar    *region)
+{
+	guint c, r;
+	const guint32 *row;
+
+	g_return_val_if_fail (regiondb != NULL, FALSE);
+	g_return_val_if_fail (container != NULL, FALSE);
+	g_return_val_if_fail (region != NULL, FALSE);
+
+	if (lt_strcase_equal(container, region))
+		return TRUE;
+	c = GPOINTER_TO_UINT (g_hash_table_lookup(regiondb->containment_ids, container));
+	r = GPOINTER_TO_UINT (g_hash_table_lookup(regiondb->containment_ids, region));
+	if (c == 0 || r == 0)
+		return FALSE;
+	r--;
+	row = &g_array_index(regiondb->containment, guint32, c * regiondb->containment_words);
+
+	return (row[r / 32] & (1U << (r % 32))) != 0;
+}
+
+/**
+ * lt_region_db_search:
+ * @regiondb: a #lt_region_db_t.
+ * @query: the words to search for in the descriptions, such as "United States".
+ * @prefix: %TRUE to match the words starting with the words in @query,
+ *          otherwise only the whole words match.
+ *
+ * Search #lt_region_t whose description contains all of the words in @query.
+ * the words are compared case-insensitively. the index for the search is
+ * built from the database at the first call.
+ *
+ * Returns: (element-type lt_region_t) (transfer full): a list of #lt_region_t
+ *          in the order of the registry, or %NULL if nothing matched.
+ *          the elements have to be freed with lt_region_unref() and
+ *          the list with g_list_free().
+ */
+GList *
+lt_region_db_search(lt_region_db_t *regiondb,
+		    const gchar    *query,
+		    gboolean        prefix)
+{
+	g_return_val_if_fail (regiondb != NULL, NULL);
+	g_return_val_if_fail (query != NULL, NULL);
+
+	G_LOCK (lt_region_db_search);
+	if (!regiondb->search_index) {
+		regiondb->search_index = lt_description_index_new(regiondb->xml, "region");
+		if (regiondb->search_index)
+			lt_mem_add_ref(&regiondb->parent, regiondb->search_index,
+				       (lt_destroy_func_t)lt_description_index_unref);
+	}
+	G_UNLOCK (lt_region_db_search);
+	if (!regiondb->search_index)
+		return NULL;
+
+	return lt_description_index_search(regiondb->search_index, query, prefix,
+					   regiondb->region_entries);
+}
@@ -40,11 +40,17 @@ G_BEGIN_DECLS
 typedef struct _lt_region_db_t		lt_region_db_t;
 
 
-lt_region_db_t *lt_region_db_new   (void);
-lt_region_db_t *lt_region_db_ref   (lt_region_db_t *regiondb);
-void            lt_region_db_unref (lt_region_db_t *regiondb);
-lt_region_t    *lt_region_db_lookup(lt_region_db_t *regiondb,
-                                    const gchar    *language_or_code);
+lt_region_db_t *lt_region_db_new     (void);
+lt_region_db_t *lt_region_db_ref     (lt_region_db_t *regiondb);
+void            lt_region_db_unref   (lt_region_db_t *regiondb);
+lt_region_t    *lt_region_db_lookup  (lt_region_db_t *regiondb,
+                                      const gchar    *language_or_code);
+gboolean        lt_region_db_contains(lt_region_db_t *regiondb,
+                                      const gchar    *container,
+                                      const gchar    *region);
+GList          *lt_region_db_search  (lt_region_db_t *regiondb,
+                                      const gchar    *query,
+                                      gboolean        prefix);
 
 G_END_DECLS
 
@@ -24,6 +24,8 @@
 #endif
 
 #include <libxml/xpath.h>
+#include "lt-database-private.h"
+#include "lt-description-index.h"
 #include "lt-error.h"
 #include "lt-mem.h"
 #include "lt-utils.h"
@@ -41,11 +43,14 @@
  * registered as ISO 15924.
  */
 struct _lt_script_db_t {
-	lt_mem_t    parent;
-	lt_xml_t   *xml;
-	GHashTable *script_entries;
+	lt_mem_t                parent;
+	lt_xml_t               *xml;
+	GHashTable             *script_entries;
+	lt_description_index_t *search_index;
 };
 
+G_LOCK_DEFINE_STATIC (lt_script_db_search);
+
 /*< private >*/
 static gboolean
 lt_script_db_parse(lt_script_db_t  *scriptdb,
@@ -129,6 +134,7 @@ lt_script_db_parse(lt_script_db_t  *scriptdb,
 		lt_script_set_tag(le, (const gchar *)subtag);
 		lt_script_set_name(le, (const gchar *)desc);
 
+		le = lt_db_share_entry(ent, le);
 		s = g_strdup(lt_script_get_tag(le));
 		g_hash_table_replace(scriptdb->script_entries,
 				     lt_strlower(s),
@@ -175,8 +181,8 @@ lt_script_db_new(void)
 		GError *err = NULL;
 		lt_script_t *le;
 
-		retval->script_entries = g_hash_table_new_full(g_str_hash,
-							       g_str_equal,
+		retval->script_entries = g_hash_table_new_full(lt_strcase_hash,
+							       lt_strcase_equal,
 							       g_free,
 							       (GDestroyNotify)lt_script_unref);
 		lt_mem_add_ref(&retval->parent, retval->script_entries,
@@ -262,17 +268,52 @@ lt_script_db_lookup(lt_script_db_t *scriptdb,
 		    const gchar    *subtag)
 {
 	lt_script_t *retval;
-	gchar *s;
 
 	g_return_val_if_fail (scriptdb != NULL, NULL);
 	g_return_val_if_fail (subtag != NULL, NULL);
 
-	s = g_strdup(subtag);
-	retval = g_hash_table_lookup(scriptdb->script_entries,
-				     lt_strlower(s));
-	g_free(s);
+	retval = g_hash_table_lookup(scriptdb->script_entries, subtag);
 	if (retval)
 		return lt_script_ref(retval);
 
 	return NULL;
 }
+
+/**
+ * lt_script_db_search:
+ * @scriptdb: a #lt_script_db_t.
+ * @query: the words to search for in the descriptions, such as "Cyrillic".
+ * @prefix: %TRUE to match the words starting with the words in @query,
+ *          otherwise only the whole words match.
+ *
+ * Search #lt_script_t whose description contains all of the words in @query.
+ * the words are compared case-insensitively. the index for the search is
+ * built from the database at the first call.
+ *
+ * Returns: (element-type lt_script_t) (transfer full): a list of #lt_script_t
+ *          in the order of the registry, or %NULL if nothing matched.
+ *          the elements have to be freed with lt_script_unref() and
+ *          the list with g_list_free().
+ */
+GList *
+lt_script_db_search(lt_script_db_t *scriptdb,
+		    const gchar    *query,
+		    gboolean        prefix)
+{
+	g_return_val_if_fail (scriptdb != NULL, NULL);
+	g_return_val_if_fail (query != NULL, NULL);
+
+	G_LOCK (lt_script_db_search);
+	if (!scriptdb->search_index) {
+		scriptdb->search_index = lt_description_index_new(scriptdb->xml, "script");
+		if (scriptdb->search_index)
+			lt_mem_add_ref(&scriptdb->parent, scriptdb->search_index,
+				       (lt_destroy_func_t)lt_description_index_unref);
+	}
+	G_UNLOCK (lt_script_db_search);
+	if (!scriptdb->search_index)
+		return NULL;
+
+	return lt_description_index_search(scriptdb->search_index, query, prefix,
+					   scriptdb->script_entries);
+}
@@ -45,6 +45,9 @@ lt_script_db_t *lt_script_db_ref        (lt_script_db_t *scriptdb);
 void            lt_script_db_unref      (lt_script_db_t *scriptdb);
 lt_script_t    *lt_script_db_lookup     (lt_script_db_t *scriptdb,
                                          const gchar    *subtag);
+GList          *lt_script_db_search     (lt_script_db_t *scriptdb,
+                                         const gchar    *query,
+                                         gboolean        prefix);
 
 G_END_DECLS
 
@@ -37,13 +37,44 @@
  * This container class provides a data access to Script subtag entry.
  */
 struct _lt_script_t {
-	lt_mem_t  parent;
-	gchar    *tag;
-	gchar    *description;
+	lt_mem_t     parent;
+	gchar       *tag;
+	gchar       *description;
+	const gchar *modifier;
 };
 
 
 /*< private >*/
+static const gchar *
+_lt_script_lookup_modifier(const gchar *subtag)
+{
+	static const struct {
+		gchar *modifier;
+		gchar *script;
+	} modifiers[] = {
+		{"abegede", NULL},
+		{"cyrillic", "Cyrl"},
+		{"cyrillic", "Cyrs"},
+		{"devanagari", "Deva"},
+		{"euro", NULL},
+		{"iqtelif", NULL},
+		{"latin", "Latf"},
+		{"latin", "Latg"},
+		{"latin", "Latn"},
+		{"saaho", NULL},
+		{NULL, NULL}
+	};
+	static gsize len = G_N_ELEMENTS(modifiers), i;
+
+	for (i = 0; i < len; i++) {
+		if (modifiers[i].script &&
+		    g_ascii_strcasecmp(subtag, modifiers[i].script) == 0)
+			return modifiers[i].modifier;
+	}
+
+	return NULL;
+}
+
 
 /*< protected >*/
 lt_script_t *
@@ -80,6 +111,8 @@ lt_script_set_tag(lt_script_t *script,
 	script->tag = g_strdup(subtag);
 	lt_mem_add_ref(&script->parent, script->tag,
 		       (lt_destroy_func_t)g_free);
+	/* resolve it once here. this is used for every conversion to the locale */
+	script->modifier = _lt_script_lookup_modifier(subtag);
 }
 
 /*< public >*/
@@ -170,35 +203,9 @@ lt_script_dump(const lt_script_t *script)
 const gchar *
 lt_script_convert_to_modifier(const lt_script_t *script)
 {
-	const gchar *p;
-	static const struct {
-		gchar *modifier;
-		gchar *script;
-	} modifiers[] = {
-		{"abegede", NULL},
-		{"cyrillic", "Cyrl"},
-		{"cyrillic", "Cyrs"},
-		{"devanagari", "Deva"},
-		{"euro", NULL},
-		{"iqtelif", NULL},
-		{"latin", "Latf"},
-		{"latin", "Latg"},
-		{"latin", "Latn"},
-		{"saaho", NULL},
-		{NULL, NULL}
-	};
-	static gsize len = G_N_ELEMENTS(modifiers), i;
-
 	g_return_val_if_fail (script != NULL, NULL);
 
-	p = lt_script_get_tag(script);
-	for (i = 0; i < len; i++) {
-		if (modifiers[i].script &&
-		    g_ascii_strcasecmp(p, modifiers[i].script) == 0)
-			return modifiers[i].modifier;
-	}
-
-	return NULL;
+	return script->modifier;
 }
 
 /**
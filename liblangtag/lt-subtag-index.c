@@ -0,0 +1,342 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-subtag-index.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <libxml/xpath.h>
+#include "lt-database.h"
+#include "lt-error.h"
+#include "lt-mem.h"
+#include "lt-utils.h"
+#include "lt-xml.h"
+#include "lt-subtag-index.h"
+
+
+/*
+ * This class assigns the small integer to every subtag in the registry.
+ * ids are given in the lexicographic order of the subtags in lowercase,
+ * so that the sequence of ids sorts in the same order as the tag strings.
+ * Index 0 is reserved as a terminator. the registered objects for every id
+ * are kept as well, so that the binary form is decoded without lookups.
+ */
+struct _lt_subtag_index_t {
+	lt_mem_t    parent;
+	lt_xml_t   *xml;
+	guint32     version;
+	GPtrArray  *subtags;
+	GHashTable *ids;
+	GArray     *entries;
+};
+
+/*< private >*/
+static gint
+_lt_subtag_index_compare(gconstpointer a,
+			 gconstpointer b)
+{
+	const gchar * const *s1 = a, * const *s2 = b;
+
+	return strcmp(*s1, *s2);
+}
+
+static guint32
+_lt_subtag_index_parse_date(const gchar *date)
+{
+	guint32 retval = 0;
+	const gchar *p;
+
+	/* "YYYY-MM-DD" is turned into YYYYMMDD */
+	for (p = date; p && *p; p++) {
+		if (g_ascii_isdigit(*p))
+			retval = retval * 10 + (*p - '0');
+	}
+
+	return retval;
+}
+
+static gboolean
+lt_subtag_index_parse(lt_subtag_index_t  *idx,
+		      GError            **error)
+{
+	gboolean retval = TRUE;
+	xmlDocPtr doc = NULL;
+	xmlXPathContextPtr xctxt = NULL;
+	xmlXPathObjectPtr xobj = NULL;
+	xmlChar *date;
+	GPtrArray *array = NULL;
+	GError *err = NULL;
+	const gchar *singletons = "0123456789abcdefghijklmnopqrstuvwxyz";
+	int i, n;
+
+	g_return_val_if_fail (idx != NULL, FALSE);
+
+	doc = lt_xml_get_subtag_registry(idx->xml);
+	date = xmlGetProp(xmlDocGetRootElement(doc), (const xmlChar *)"file-date");
+	if (date) {
+		idx->version = _lt_subtag_index_parse_date((const gchar *)date);
+		xmlFree(date);
+	}
+	xctxt = xmlXPathNewContext(doc);
+	if (!xctxt) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to create an instance of xmlXPathContextPtr.");
+		goto bail;
+	}
+	xobj = xmlXPathEvalExpression((const xmlChar *)"/registry/*/subtag", xctxt);
+	if (!xobj) {
+		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+			    "No valid elements for %s",
+			    doc->name);
+		goto bail;
+	}
+	n = xmlXPathNodeSetGetLength(xobj->nodesetval);
+	array = g_ptr_array_sized_new(n + 36);
+
+	for (i = 0; i < n; i++) {
+		xmlNodePtr ent = xmlXPathNodeSetItem(xobj->nodesetval, i);
+		xmlChar *subtag;
+
+		if (!ent) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "Unable to obtain the xml node via XPath.");
+			goto bail;
+		}
+		subtag = xmlNodeGetContent(ent);
+		/* ignore the range of the private use subtags */
+		if (subtag && !strstr((const gchar *)subtag, ".."))
+			g_ptr_array_add(array, lt_strlower(g_strdup((const gchar *)subtag)));
+		if (subtag)
+			xmlFree(subtag);
+	}
+	/* singletons to keep the order of extensions and privateuse */
+	for (i = 0; singletons[i] != 0; i++) {
+		g_ptr_array_add(array, g_strndup(&singletons[i], 1));
+	}
+	g_ptr_array_sort(array, _lt_subtag_index_compare);
+
+	g_ptr_array_add(idx->subtags, NULL);
+	for (i = 0; i < array->len; i++) {
+		gchar *s = g_ptr_array_index(array, i);
+
+		if (idx->subtags->len > 1 &&
+		    strcmp(g_ptr_array_index(idx->subtags, idx->subtags->len - 1), s) == 0) {
+			/* the same subtag may be registered as the different type */
+			g_free(s);
+			continue;
+		}
+		if (idx->subtags->len > LT_SUBTAG_INDEX_MAX_ID) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "Too many subtags in the registry.");
+			g_free(s);
+			continue;
+		}
+		g_hash_table_replace(idx->ids, s,
+				     GUINT_TO_POINTER (idx->subtags->len));
+		g_ptr_array_add(idx->subtags, s);
+	}
+  bail:
+	if (array) {
+		/* the strings are owned by idx once they are sorted */
+		if (idx->subtags->len == 0) {
+			for (i = 0; i < array->len; i++)
+				g_free(g_ptr_array_index(array, i));
+		}
+		g_ptr_array_free(array, TRUE);
+	}
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	if (xobj)
+		xmlXPathFreeObject(xobj);
+	if (xctxt)
+		xmlXPathFreeContext(xctxt);
+
+	return retval;
+}
+
+static void
+_lt_subtag_index_free_subtags(GPtrArray *array)
+{
+	guint i;
+
+	for (i = 0; i < array->len; i++)
+		g_free(g_ptr_array_index(array, i));
+	g_ptr_array_free(array, TRUE);
+}
+
+static void
+_lt_subtag_index_free_entries(GArray *array)
+{
+	guint i;
+
+	for (i = 0; i < array->len; i++) {
+		lt_subtag_index_entry_t *e = &g_array_index(array, lt_subtag_index_entry_t, i);
+
+		lt_lang_unref(e->lang);
+		lt_extlang_unref(e->extlang);
+		lt_script_unref(e->script);
+		lt_region_unref(e->region);
+		lt_variant_unref(e->variant);
+	}
+	g_array_free(array, TRUE);
+}
+
+static void
+lt_subtag_index_fill_entries(lt_subtag_index_t *idx)
+{
+	lt_lang_db_t *langdb = lt_db_get_lang();
+	lt_extlang_db_t *extlangdb = lt_db_get_extlang();
+	lt_script_db_t *scriptdb = lt_db_get_script();
+	lt_region_db_t *regiondb = lt_db_get_region();
+	lt_variant_db_t *variantdb = lt_db_get_variant();
+	guint i;
+
+	g_array_set_size(idx->entries, idx->subtags->len);
+	for (i = 1; i < idx->subtags->len; i++) {
+		lt_subtag_index_entry_t *e = &g_array_index(idx->entries, lt_subtag_index_entry_t, i);
+		const gchar *subtag = g_ptr_array_index(idx->subtags, i);
+
+		/* the same subtag may be registered as the different type */
+		e->lang = lt_lang_db_lookup(langdb, subtag);
+		e->extlang = lt_extlang_db_lookup(extlangdb, subtag);
+		e->script = lt_script_db_lookup(scriptdb, subtag);
+		e->region = lt_region_db_lookup(regiondb, subtag);
+		e->variant = lt_variant_db_lookup(variantdb, subtag);
+	}
+	lt_lang_db_unref(langdb);
+	lt_extlang_db_unref(extlangdb);
+	lt_script_db_unref(scriptdb);
+	lt_region_db_unref(regiondb);
+	lt_variant_db_unref(variantdb);
+}
+
+/*< public >*/
+lt_subtag_index_t *
+lt_subtag_index_new(void)
+{
+	lt_subtag_index_t *retval = lt_mem_alloc_object(sizeof (lt_subtag_index_t));
+
+	if (retval) {
+		GError *err = NULL;
+
+		retval->subtags = g_ptr_array_new();
+		lt_mem_add_ref(&retval->parent, retval->subtags,
+			       (lt_destroy_func_t)_lt_subtag_index_free_subtags);
+		/* the keys are owned by subtags */
+		retval->ids = g_hash_table_new(lt_strcase_hash,
+					       lt_strcase_equal);
+		lt_mem_add_ref(&retval->parent, retval->ids,
+			       (lt_destroy_func_t)g_hash_table_destroy);
+		retval->entries = g_array_new(FALSE, TRUE, sizeof (lt_subtag_index_entry_t));
+		lt_mem_add_ref(&retval->parent, retval->entries,
+			       (lt_destroy_func_t)_lt_subtag_index_free_entries);
+
+		retval->xml = lt_xml_new();
+		if (!retval->xml) {
+			lt_subtag_index_unref(retval);
+			retval = NULL;
+			goto bail;
+		}
+		lt_mem_add_ref(&retval->parent, retval->xml,
+			       (lt_destroy_func_t)lt_xml_unref);
+
+		lt_subtag_index_parse(retval, &err);
+		if (err) {
+			g_printerr(err->message);
+			lt_subtag_index_unref(retval);
+			retval = NULL;
+			g_error_free(err);
+		} else {
+			lt_subtag_index_fill_entries(retval);
+		}
+	}
+  bail:
+
+	return retval;
+}
+
+lt_subtag_index_t *
+lt_subtag_index_ref(lt_subtag_index_t *idx)
+{
+	g_return_val_if_fail (idx != NULL, NULL);
+
+	return lt_mem_ref(&idx->parent);
+}
+
+void
+lt_subtag_index_unref(lt_subtag_index_t *idx)
+{
+	if (idx)
+		lt_mem_unref(&idx->parent);
+}
+
+/* The date of the registry being used, in YYYYMMDD. 0 if unknown. */
+guint32
+lt_subtag_index_get_version(lt_subtag_index_t *idx)
+{
+	g_return_val_if_fail (idx != NULL, 0);
+
+	return idx->version;
+}
+
+/* Returns the id of @subtag, or 0 if it isn't registered. */
+guint
+lt_subtag_index_lookup(lt_subtag_index_t *idx,
+		       const gchar       *subtag)
+{
+	g_return_val_if_fail (idx != NULL, 0);
+	g_return_val_if_fail (subtag != NULL, 0);
+
+	return GPOINTER_TO_UINT (g_hash_table_lookup(idx->ids, subtag));
+}
+
+const gchar *
+lt_subtag_index_get_subtag(lt_subtag_index_t *idx,
+			   guint              id)
+{
+	g_return_val_if_fail (idx != NULL, NULL);
+
+	if (id == 0 || id >= idx->subtags->len)
+		return NULL;
+
+	return g_ptr_array_index(idx->subtags, id);
+}
+
+/* Returns the registered objects for @id, or %NULL if @id is invalid. */
+const lt_subtag_index_entry_t *
+lt_subtag_index_get_entry(lt_subtag_index_t *idx,
+			  guint              id)
+{
+	g_return_val_if_fail (idx != NULL, NULL);
+
+	if (id == 0 || id >= idx->entries->len)
+		return NULL;
+
+	return &g_array_index(idx->entries, lt_subtag_index_entry_t, id);
+}
@@ -0,0 +1,61 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-subtag-index.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __LT_SUBTAG_INDEX_H__
+#define __LT_SUBTAG_INDEX_H__
+
+#include <glib.h>
+#include "lt-extlang.h"
+#include "lt-lang.h"
+#include "lt-region.h"
+#include "lt-script.h"
+#include "lt-variant.h"
+
+G_BEGIN_DECLS
+
+/* the largest id to be assigned to the subtag */
+#define LT_SUBTAG_INDEX_MAX_ID	0xfffe
+
+typedef struct _lt_subtag_index_t	lt_subtag_index_t;
+/* the objects registered with the subtag. owned by lt_subtag_index_t */
+typedef struct _lt_subtag_index_entry_t {
+	lt_lang_t    *lang;
+	lt_extlang_t *extlang;
+	lt_script_t  *script;
+	lt_region_t  *region;
+	lt_variant_t *variant;
+} lt_subtag_index_entry_t;
+
+lt_subtag_index_t             *lt_subtag_index_new        (void);
+lt_subtag_index_t             *lt_subtag_index_ref        (lt_subtag_index_t *idx);
+void                           lt_subtag_index_unref      (lt_subtag_index_t *idx);
+guint32                        lt_subtag_index_get_version(lt_subtag_index_t *idx);
+guint                          lt_subtag_index_lookup     (lt_subtag_index_t *idx,
+                                                           const gchar       *subtag);
+const gchar                   *lt_subtag_index_get_subtag (lt_subtag_index_t *idx,
+                                                           guint              id);
+const lt_subtag_index_entry_t *lt_subtag_index_get_entry  (lt_subtag_index_t *idx,
+                                                           guint              id);
+lt_subtag_index_t             *lt_db_get_subtag_index     (void);
+
+G_END_DECLS
+
+#endif /* __LT_SUBTAG_INDEX_H__ */
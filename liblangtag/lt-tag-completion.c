@@ -0,0 +1,319 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-tag-completion.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "lt-mem.h"
+#include "lt-tag-dfa.h"
+#include "lt-tag-completion.h"
+
+
+/**
+ * SECTION: lt-tag-completion
+ * @Short_Description: A container class to complete Language tag
+ * @Title: Container - Tag Completion
+ *
+ * This container class provides the candidates of the language tags
+ * that starts with the partial input, such as "zh-Ha", and tells if it
+ * can still be completed to a valid tag. it is intended for type-ahead
+ * on the input fields.
+ *
+ * The candidates are the registered subtags to fill in the last subtag
+ * in the input, in the order of the length and then alphabetical order,
+ * followed by the grandfathered tags that starts with the whole of
+ * the input. the prefixes of the variants and the extlangs aren't taken
+ * into account, nor the ranges of the private use subtags like "qaa..qtz".
+ */
+struct _lt_tag_completion_t {
+	lt_mem_t           parent;
+	gboolean           viable;
+	GString           *prefix;
+	GString           *string;
+	lt_tag_dfa_iter_t  subtags;
+	lt_tag_dfa_iter_t  tags;
+};
+
+enum {
+	TAIL_SINGLETON,
+	TAIL_EXTENSION_FIRST,
+	TAIL_EXTENSION,
+	TAIL_PRIVATEUSE_FIRST,
+	TAIL_PRIVATEUSE
+};
+
+/*< private >*/
+static gboolean
+_lt_tag_completion_is_alnum_len(const gchar *subtag,
+				gsize        length)
+{
+	gsize i;
+
+	for (i = 0; i < length; i++) {
+		if (!g_ascii_isalnum(subtag[i]))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Check the extensions and the private use subtags from @start to
+ * @length. the last subtag can be incomplete.
+ */
+static gboolean
+_lt_tag_completion_check_tail(const gchar *partial,
+			      gsize        start,
+			      gsize        length)
+{
+	gint mode = TAIL_SINGLETON;
+	gsize i, len;
+
+	for (i = start; i <= length; i++) {
+		if (i < length && partial[i] != '-')
+			continue;
+		len = i - start;
+		if (len > 8 ||
+		    !_lt_tag_completion_is_alnum_len(&partial[start], len))
+			return FALSE;
+		if (i == length)
+			break;
+		if (len == 0)
+			return FALSE;
+		switch (mode) {
+		    case TAIL_SINGLETON:
+		    case TAIL_EXTENSION:
+			    if (len == 1)
+				    mode = g_ascii_tolower(partial[start]) == 'x' ? TAIL_PRIVATEUSE_FIRST : TAIL_EXTENSION_FIRST;
+			    else if (mode == TAIL_SINGLETON)
+				    return FALSE;
+			    break;
+		    case TAIL_EXTENSION_FIRST:
+			    if (len == 1)
+				    return FALSE;
+			    mode = TAIL_EXTENSION;
+			    break;
+		    default:
+			    mode = TAIL_PRIVATEUSE;
+			    break;
+		}
+		start = i + 1;
+	}
+
+	return TRUE;
+}
+
+static void
+_lt_tag_completion_analyze(lt_tag_completion_t *completion,
+			   lt_tag_dfa_t        *dfa,
+			   const gchar         *partial,
+			   gsize                length)
+{
+	lt_tag_dfa_result_t result;
+	const gchar *p;
+	gsize last;
+	guint state, types = 0;
+
+	/* the grandfathered tags are the candidates for the whole of input */
+	state = lt_tag_dfa_walk(dfa, LT_TAG_DFA_TAG, partial, length);
+	if ((lt_tag_dfa_get_reach(dfa, state) & LT_TAG_DFA_GRANDFATHERED) != 0)
+		completion->viable = TRUE;
+	lt_tag_dfa_iter_init(dfa, &completion->tags, state,
+			     LT_TAG_DFA_GRANDFATHERED);
+
+	p = g_strrstr_len(partial, length, "-");
+	if (!p) {
+		last = 0;
+		types = LT_TAG_DFA_LANG;
+		/* the private use tag */
+		if (length == 1 && g_ascii_tolower(partial[0]) == 'x')
+			completion->viable = TRUE;
+	} else {
+		gsize h = p - partial;
+
+		last = h + 1;
+		g_string_append_len(completion->prefix, partial, last);
+		if (!lt_tag_dfa_run(dfa, partial, h, &result) ||
+		    result.grandfathered) {
+			/* no subtags can follow */
+		} else if (result.tail < h) {
+			if (_lt_tag_completion_check_tail(partial,
+							  result.tail == 0 ? 0 : result.tail + 1,
+							  length))
+				completion->viable = TRUE;
+		} else {
+			switch (result.state) {
+			    case STATE_PRE_EXTLANG:
+				    types |= LT_TAG_DFA_EXTLANG;
+				    /* fall through */
+			    case STATE_PRE_SCRIPT:
+				    types |= LT_TAG_DFA_SCRIPT;
+				    /* fall through */
+			    case STATE_PRE_REGION:
+				    types |= LT_TAG_DFA_REGION;
+				    /* fall through */
+			    case STATE_PRE_VARIANT:
+				    types |= LT_TAG_DFA_VARIANT;
+				    break;
+			    default:
+				    break;
+			}
+			/* the singleton for the extensions or the private use */
+			if (types != 0 &&
+			    (length == last ||
+			     (length == last + 1 && g_ascii_isalnum(partial[last]))))
+				completion->viable = TRUE;
+		}
+	}
+	if (types != 0) {
+		state = lt_tag_dfa_walk(dfa, LT_TAG_DFA_SUBTAG,
+					&partial[last], length - last);
+		if ((lt_tag_dfa_get_reach(dfa, state) & types) != 0)
+			completion->viable = TRUE;
+	} else {
+		state = LT_TAG_DFA_DEAD;
+	}
+	lt_tag_dfa_iter_init(dfa, &completion->subtags, state, types);
+}
+
+/*< public >*/
+/**
+ * lt_tag_completion_new:
+ * @partial: a partial language tag string, such as "zh-Ha".
+ * @length: the length of @partial in bytes, or -1 if it's nul-terminated.
+ *
+ * Create a new instance of #lt_tag_completion_t to look up the candidates
+ * that start with @partial.
+ *
+ * Returns: (transfer full): a new instance of #lt_tag_completion_t.
+ */
+lt_tag_completion_t *
+lt_tag_completion_new(const gchar *partial,
+		      gssize       length)
+{
+	lt_tag_completion_t *retval;
+	lt_tag_dfa_t *dfa;
+
+	g_return_val_if_fail (partial != NULL, NULL);
+
+	if (length < 0)
+		length = strlen(partial);
+	retval = lt_mem_alloc_object(sizeof (lt_tag_completion_t));
+	if (retval) {
+		retval->prefix = g_string_new(NULL);
+		lt_mem_add_ref(&retval->parent, retval->prefix,
+			       (lt_destroy_func_t)lt_mem_gstring_free);
+		retval->string = g_string_new(NULL);
+		lt_mem_add_ref(&retval->parent, retval->string,
+			       (lt_destroy_func_t)lt_mem_gstring_free);
+		lt_mem_add_ref(&retval->parent, &retval->subtags,
+			       (lt_destroy_func_t)lt_tag_dfa_iter_finish);
+		lt_mem_add_ref(&retval->parent, &retval->tags,
+			       (lt_destroy_func_t)lt_tag_dfa_iter_finish);
+		dfa = lt_tag_get_dfa();
+		if (dfa) {
+			_lt_tag_completion_analyze(retval, dfa, partial, length);
+			lt_tag_dfa_unref(dfa);
+		}
+	}
+
+	return retval;
+}
+
+/**
+ * lt_tag_completion_ref:
+ * @completion: a #lt_tag_completion_t.
+ *
+ * Increases the reference count of @completion.
+ *
+ * Returns: (transfer none): the same @completion object.
+ */
+lt_tag_completion_t *
+lt_tag_completion_ref(lt_tag_completion_t *completion)
+{
+	g_return_val_if_fail (completion != NULL, NULL);
+
+	return lt_mem_ref(&completion->parent);
+}
+
+/**
+ * lt_tag_completion_unref:
+ * @completion: a #lt_tag_completion_t.
+ *
+ * Decreases the reference count of @completion. when its reference count
+ * drops to 0, the object is finalized (i.e. its memory is freed).
+ */
+void
+lt_tag_completion_unref(lt_tag_completion_t *completion)
+{
+	if (completion)
+		lt_mem_unref(&completion->parent);
+}
+
+/**
+ * lt_tag_completion_is_viable:
+ * @completion: a #lt_tag_completion_t.
+ *
+ * Checks if the partial input given to lt_tag_completion_new() can be
+ * completed to a valid language tag by appending more characters.
+ *
+ * Returns: %TRUE if it's still viable, otherwise %FALSE.
+ */
+gboolean
+lt_tag_completion_is_viable(lt_tag_completion_t *completion)
+{
+	g_return_val_if_fail (completion != NULL, FALSE);
+
+	return completion->viable;
+}
+
+/**
+ * lt_tag_completion_next:
+ * @completion: a #lt_tag_completion_t.
+ *
+ * Obtains the next candidate. the cost is proportional to the number of
+ * the candidates obtained, not the size of the registry.
+ *
+ * Returns: a language tag string that starts with the partial input,
+ *          or %NULL if no more candidates. the string is valid until
+ *          the next call or @completion is finalized.
+ */
+const gchar *
+lt_tag_completion_next(lt_tag_completion_t *completion)
+{
+	const gchar *retval;
+
+	g_return_val_if_fail (completion != NULL, NULL);
+
+	if (completion->subtags.queue &&
+	    (retval = lt_tag_dfa_iter_next(&completion->subtags, NULL)) != NULL) {
+		g_string_assign(completion->string, completion->prefix->str);
+		g_string_append(completion->string, retval);
+
+		return completion->string->str;
+	}
+	if (completion->tags.queue)
+		return lt_tag_dfa_iter_next(&completion->tags, NULL);
+
+	return NULL;
+}
@@ -0,0 +1,51 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-tag-completion.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__LANGTAG_H__INSIDE) && !defined (__LANGTAG_COMPILATION)
+#error "Only <liblangtag/langtag.h> can be included directly."
+#endif
+
+#ifndef __LT_TAG_COMPLETION_H__
+#define __LT_TAG_COMPLETION_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * lt_tag_completion_t:
+ *
+ * All the fields in the <structname>lt_tag_completion_t</structname>
+ * structure are private to the #lt_tag_completion_t implementation.
+ */
+typedef struct _lt_tag_completion_t	lt_tag_completion_t;
+
+
+lt_tag_completion_t *lt_tag_completion_new      (const gchar         *partial,
+                                                 gssize               length);
+lt_tag_completion_t *lt_tag_completion_ref      (lt_tag_completion_t *completion);
+void                 lt_tag_completion_unref    (lt_tag_completion_t *completion);
+gboolean             lt_tag_completion_is_viable(lt_tag_completion_t *completion);
+const gchar         *lt_tag_completion_next     (lt_tag_completion_t *completion);
+
+G_END_DECLS
+
+#endif /* __LT_TAG_COMPLETION_H__ */
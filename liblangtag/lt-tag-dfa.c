@@ -0,0 +1,672 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-tag-dfa.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <libxml/xpath.h>
+#include "lt-database.h"
+#include "lt-error.h"
+#include "lt-mem.h"
+#include "lt-subtag-index.h"
+#include "lt-utils.h"
+#include "lt-xml.h"
+#include "lt-tag-dfa.h"
+
+
+/*
+ * This class compiles all of the subtags and tags in the registry into
+ * one automaton over the case-folded bytes. the states are shared by two
+ * tries: one starts at LT_TAG_DFA_SUBTAG and accepts every subtags, which
+ * goes back to the root at the hyphen. another one starts at LT_TAG_DFA_TAG
+ * and accepts the whole of the grandfathered and the redundant tags.
+ * both are walked at the same time, so that a tag is validated and
+ * the subtags are identified in a single pass without hash lookups.
+ */
+/* a-z, 0-9 and the hyphen */
+#define LT_TAG_DFA_N_SYMBOLS	37
+#define LT_TAG_DFA_MAX_STATES	0xffff
+
+typedef struct _lt_tag_dfa_entry_t {
+	guint               types;
+	guint               id;
+	lt_lang_t          *lang;
+	lt_extlang_t       *extlang;
+	lt_script_t        *script;
+	lt_region_t        *region;
+	lt_variant_t       *variant;
+	lt_grandfathered_t *grandfathered;
+	lt_redundant_t     *redundant;
+} lt_tag_dfa_entry_t;
+
+struct _lt_tag_dfa_t {
+	lt_mem_t   parent;
+	lt_xml_t  *xml;
+	guint8     symbols[256];
+	GArray    *transitions;
+	GArray    *accepts;
+	GArray    *entries;
+	GArray    *reach;
+};
+
+/*< private >*/
+static void
+_lt_tag_dfa_entries_free(GArray *array)
+{
+	guint i;
+
+	for (i = 0; i < array->len; i++) {
+		lt_tag_dfa_entry_t *e = &g_array_index(array, lt_tag_dfa_entry_t, i);
+
+		lt_lang_unref(e->lang);
+		lt_extlang_unref(e->extlang);
+		lt_script_unref(e->script);
+		lt_region_unref(e->region);
+		lt_variant_unref(e->variant);
+		lt_grandfathered_unref(e->grandfathered);
+		lt_redundant_unref(e->redundant);
+	}
+	g_array_free(array, TRUE);
+}
+
+static void
+_lt_tag_dfa_array_free(GArray *array)
+{
+	g_array_free(array, TRUE);
+}
+
+static guint
+lt_tag_dfa_add_state(lt_tag_dfa_t  *dfa,
+		     GError       **error)
+{
+	guint retval = dfa->accepts->len;
+
+	if (retval >= LT_TAG_DFA_MAX_STATES) {
+		g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_XML,
+			    "Too many states to compile the registry.");
+		return LT_TAG_DFA_DEAD;
+	}
+	/* the new elements are cleared */
+	g_array_set_size(dfa->transitions, (retval + 1) * LT_TAG_DFA_N_SYMBOLS);
+	g_array_set_size(dfa->accepts, retval + 1);
+
+	return retval;
+}
+
+static lt_tag_dfa_entry_t *
+lt_tag_dfa_insert(lt_tag_dfa_t  *dfa,
+		  guint          root,
+		  const gchar   *string,
+		  GError       **error)
+{
+	guint state = root;
+	const gchar *p;
+
+	for (p = string; *p; p++) {
+		guint sym = dfa->symbols[(guchar)*p];
+		guint next;
+
+		/* the range of the private use subtags isn't compiled */
+		if (sym == 0)
+			return NULL;
+		next = g_array_index(dfa->transitions, guint16, state * LT_TAG_DFA_N_SYMBOLS + sym - 1);
+		if (next == LT_TAG_DFA_DEAD) {
+			next = lt_tag_dfa_add_state(dfa, error);
+			if (next == LT_TAG_DFA_DEAD)
+				return NULL;
+			g_array_index(dfa->transitions, guint16, state * LT_TAG_DFA_N_SYMBOLS + sym - 1) = next;
+		}
+		state = next;
+	}
+	if (g_array_index(dfa->accepts, guint16, state) == 0) {
+		lt_tag_dfa_entry_t e;
+
+		if (dfa->entries->len > G_MAXUINT16) {
+			g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "Too many subtags to compile the registry.");
+			return NULL;
+		}
+		memset(&e, 0, sizeof (lt_tag_dfa_entry_t));
+		g_array_index(dfa->accepts, guint16, state) = dfa->entries->len;
+		g_array_append_val(dfa->entries, e);
+	}
+
+	return &g_array_index(dfa->entries, lt_tag_dfa_entry_t,
+			      g_array_index(dfa->accepts, guint16, state));
+}
+
+static gboolean
+lt_tag_dfa_compile(lt_tag_dfa_t  *dfa,
+		   GError       **error)
+{
+	static const struct {
+		const gchar *xpath;
+		guint        type;
+	} tables[] = {
+		{ "/registry/language/subtag", LT_TAG_DFA_LANG },
+		{ "/registry/extlang/subtag", LT_TAG_DFA_EXTLANG },
+		{ "/registry/script/subtag", LT_TAG_DFA_SCRIPT },
+		{ "/registry/region/subtag", LT_TAG_DFA_REGION },
+		{ "/registry/variant/subtag", LT_TAG_DFA_VARIANT },
+		{ "/registry/grandfathered/tag", LT_TAG_DFA_GRANDFATHERED },
+		{ "/registry/redundant/tag", LT_TAG_DFA_REDUNDANT },
+		{ NULL, 0 }
+	};
+	gboolean retval = TRUE;
+	xmlDocPtr doc = NULL;
+	xmlXPathContextPtr xctxt = NULL;
+	lt_lang_db_t *langdb = lt_db_get_lang();
+	lt_extlang_db_t *extlangdb = lt_db_get_extlang();
+	lt_script_db_t *scriptdb = lt_db_get_script();
+	lt_region_db_t *regiondb = lt_db_get_region();
+	lt_variant_db_t *variantdb = lt_db_get_variant();
+	lt_grandfathered_db_t *grandfathereddb = lt_db_get_grandfathered();
+	lt_redundant_db_t *redundantdb = lt_db_get_redundant();
+	lt_subtag_index_t *sindex = lt_db_get_subtag_index();
+	GError *err = NULL;
+	int i, j, n;
+
+	g_return_val_if_fail (dfa != NULL, FALSE);
+
+	doc = lt_xml_get_subtag_registry(dfa->xml);
+	xctxt = xmlXPathNewContext(doc);
+	if (!xctxt) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to create an instance of xmlXPathContextPtr.");
+		goto bail;
+	}
+	for (i = 0; tables[i].xpath != NULL; i++) {
+		xmlXPathObjectPtr xobj;
+
+		xobj = xmlXPathEvalExpression((const xmlChar *)tables[i].xpath, xctxt);
+		if (!xobj) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+				    "No valid elements for %s",
+				    doc->name);
+			goto bail;
+		}
+		n = xmlXPathNodeSetGetLength(xobj->nodesetval);
+		for (j = 0; j < n; j++) {
+			xmlNodePtr ent = xmlXPathNodeSetItem(xobj->nodesetval, j);
+			lt_tag_dfa_entry_t *e;
+			xmlChar *content;
+			gchar *s;
+
+			if (!ent) {
+				g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_XML,
+					    "Unable to obtain the xml node via XPath.");
+				break;
+			}
+			content = xmlNodeGetContent(ent);
+			if (!content)
+				continue;
+			s = lt_strlower(g_strdup((const gchar *)content));
+			xmlFree(content);
+			e = lt_tag_dfa_insert(dfa,
+					      tables[i].type >= LT_TAG_DFA_GRANDFATHERED ? LT_TAG_DFA_TAG : LT_TAG_DFA_SUBTAG,
+					      s, &err);
+			if (e) {
+				/* only what the database really has is accepted */
+				switch (tables[i].type) {
+				    case LT_TAG_DFA_LANG:
+					    if (!e->lang)
+						    e->lang = lt_lang_db_lookup(langdb, s);
+					    if (e->lang)
+						    e->types |= LT_TAG_DFA_LANG;
+					    break;
+				    case LT_TAG_DFA_EXTLANG:
+					    if (!e->extlang)
+						    e->extlang = lt_extlang_db_lookup(extlangdb, s);
+					    if (e->extlang)
+						    e->types |= LT_TAG_DFA_EXTLANG;
+					    break;
+				    case LT_TAG_DFA_SCRIPT:
+					    if (!e->script)
+						    e->script = lt_script_db_lookup(scriptdb, s);
+					    if (e->script)
+						    e->types |= LT_TAG_DFA_SCRIPT;
+					    break;
+				    case LT_TAG_DFA_REGION:
+					    if (!e->region)
+						    e->region = lt_region_db_lookup(regiondb, s);
+					    if (e->region)
+						    e->types |= LT_TAG_DFA_REGION;
+					    break;
+				    case LT_TAG_DFA_VARIANT:
+					    if (!e->variant)
+						    e->variant = lt_variant_db_lookup(variantdb, s);
+					    if (e->variant)
+						    e->types |= LT_TAG_DFA_VARIANT;
+					    break;
+				    case LT_TAG_DFA_GRANDFATHERED:
+					    if (!e->grandfathered)
+						    e->grandfathered = lt_grandfathered_db_lookup(grandfathereddb, s);
+					    if (e->grandfathered)
+						    e->types |= LT_TAG_DFA_GRANDFATHERED;
+					    break;
+				    case LT_TAG_DFA_REDUNDANT:
+					    if (!e->redundant)
+						    e->redundant = lt_redundant_db_lookup(redundantdb, s);
+					    if (e->redundant)
+						    e->types |= LT_TAG_DFA_REDUNDANT;
+					    break;
+				    default:
+					    break;
+				}
+				if (tables[i].type < LT_TAG_DFA_GRANDFATHERED)
+					e->id = lt_subtag_index_lookup(sindex, s);
+			}
+			g_free(s);
+			if (err)
+				break;
+		}
+		xmlXPathFreeObject(xobj);
+		if (err)
+			break;
+	}
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	if (xctxt)
+		xmlXPathFreeContext(xctxt);
+	lt_lang_db_unref(langdb);
+	lt_extlang_db_unref(extlangdb);
+	lt_script_db_unref(scriptdb);
+	lt_region_db_unref(regiondb);
+	lt_variant_db_unref(variantdb);
+	lt_grandfathered_db_unref(grandfathereddb);
+	lt_redundant_db_unref(redundantdb);
+	lt_subtag_index_unref(sindex);
+
+	return retval;
+}
+
+/* the types accepted by any states reachable from each state */
+static void
+lt_tag_dfa_compute_reach(lt_tag_dfa_t *dfa)
+{
+	const guint16 *transitions = (const guint16 *)dfa->transitions->data;
+	const guint16 *accepts = (const guint16 *)dfa->accepts->data;
+	guint8 *reach;
+	guint i, j;
+
+	g_array_set_size(dfa->reach, dfa->accepts->len);
+	reach = (guint8 *)dfa->reach->data;
+	/* the states are always added after their parents */
+	for (i = dfa->accepts->len; i > LT_TAG_DFA_DEAD + 1; i--) {
+		guint state = i - 1;
+
+		reach[state] = g_array_index(dfa->entries, lt_tag_dfa_entry_t, accepts[state]).types;
+		for (j = 0; j < LT_TAG_DFA_N_SYMBOLS; j++) {
+			guint16 next = transitions[state * LT_TAG_DFA_N_SYMBOLS + j];
+
+			if (next != LT_TAG_DFA_DEAD)
+				reach[state] |= reach[next];
+		}
+	}
+}
+
+static gboolean
+lt_tag_dfa_emit(lt_tag_dfa_result_t *result,
+		lt_tag_state_t       type,
+		gsize                start,
+		gsize                length,
+		guint                id,
+		gpointer             object)
+{
+	lt_tag_dfa_subtag_t *s;
+
+	if (result->n_subtags >= LT_TAG_DFA_MAX_SUBTAGS)
+		return FALSE;
+	s = &result->subtags[result->n_subtags++];
+	s->type = type;
+	s->id = id;
+	s->offset = start;
+	s->length = length;
+	s->object = object;
+	/* the state where lt_tag_parse_state() continues from */
+	result->state = type == STATE_VARIANT ? STATE_PRE_VARIANT : type + 1;
+
+	return TRUE;
+}
+
+/*< public >*/
+lt_tag_dfa_t *
+lt_tag_dfa_new(void)
+{
+	lt_tag_dfa_t *retval = lt_mem_alloc_object(sizeof (lt_tag_dfa_t));
+
+	if (retval) {
+		GError *err = NULL;
+		lt_tag_dfa_entry_t e;
+		gint i;
+
+		for (i = 0; i < 26; i++) {
+			retval->symbols['a' + i] = i + 1;
+			retval->symbols['A' + i] = i + 1;
+		}
+		for (i = 0; i < 10; i++)
+			retval->symbols['0' + i] = 26 + i + 1;
+		retval->symbols['-'] = LT_TAG_DFA_N_SYMBOLS;
+
+		retval->transitions = g_array_sized_new(FALSE, TRUE, sizeof (guint16),
+							4096 * LT_TAG_DFA_N_SYMBOLS);
+		lt_mem_add_ref(&retval->parent, retval->transitions,
+			       (lt_destroy_func_t)_lt_tag_dfa_array_free);
+		retval->accepts = g_array_sized_new(FALSE, TRUE, sizeof (guint16), 4096);
+		lt_mem_add_ref(&retval->parent, retval->accepts,
+			       (lt_destroy_func_t)_lt_tag_dfa_array_free);
+		/* the dead state and the roots */
+		g_array_set_size(retval->transitions, LT_TAG_DFA_BEGIN * LT_TAG_DFA_N_SYMBOLS);
+		g_array_set_size(retval->accepts, LT_TAG_DFA_BEGIN);
+
+		/* index 0 is reserved for the states not being accepted */
+		retval->entries = g_array_new(FALSE, FALSE, sizeof (lt_tag_dfa_entry_t));
+		memset(&e, 0, sizeof (lt_tag_dfa_entry_t));
+		g_array_append_val(retval->entries, e);
+		lt_mem_add_ref(&retval->parent, retval->entries,
+			       (lt_destroy_func_t)_lt_tag_dfa_entries_free);
+
+		retval->xml = lt_xml_new();
+		if (!retval->xml) {
+			lt_tag_dfa_unref(retval);
+			retval = NULL;
+			goto bail;
+		}
+		lt_mem_add_ref(&retval->parent, retval->xml,
+			       (lt_destroy_func_t)lt_xml_unref);
+
+		retval->reach = g_array_new(FALSE, TRUE, sizeof (guint8));
+		lt_mem_add_ref(&retval->parent, retval->reach,
+			       (lt_destroy_func_t)_lt_tag_dfa_array_free);
+
+		lt_tag_dfa_compile(retval, &err);
+		if (!err)
+			lt_tag_dfa_compute_reach(retval);
+		if (err) {
+			g_printerr(err->message);
+			lt_tag_dfa_unref(retval);
+			retval = NULL;
+			g_error_free(err);
+		}
+	}
+  bail:
+
+	return retval;
+}
+
+lt_tag_dfa_t *
+lt_tag_dfa_ref(lt_tag_dfa_t *dfa)
+{
+	g_return_val_if_fail (dfa != NULL, NULL);
+
+	return lt_mem_ref(&dfa->parent);
+}
+
+void
+lt_tag_dfa_unref(lt_tag_dfa_t *dfa)
+{
+	if (dfa)
+		lt_mem_unref(&dfa->parent);
+}
+
+/*
+ * Walk @tag_string from left to right once. the registered subtags
+ * are stored into @result until the first singleton, where the
+ * extensions or the private use subtags start, and its offset is
+ * stored as the tail. the objects in @result are owned by @dfa.
+ *
+ * Returns FALSE if @tag_string has any subtags not registered or
+ * in the wrong order, unless the whole of it is the grandfathered tag.
+ */
+gboolean
+lt_tag_dfa_run(lt_tag_dfa_t        *dfa,
+	       const gchar         *tag_string,
+	       gsize                length,
+	       lt_tag_dfa_result_t *result)
+{
+	const guint16 *transitions, *accepts;
+	const lt_tag_dfa_entry_t *entries, *e;
+	guint subtag = LT_TAG_DFA_SUBTAG, whole = LT_TAG_DFA_TAG, sym;
+	lt_tag_state_t state = STATE_LANG;
+	gboolean in_tail = FALSE, rejected = FALSE;
+	gsize i, start = 0, len;
+
+	g_return_val_if_fail (dfa != NULL, FALSE);
+	g_return_val_if_fail (tag_string != NULL, FALSE);
+	g_return_val_if_fail (result != NULL, FALSE);
+
+	transitions = (const guint16 *)dfa->transitions->data;
+	accepts = (const guint16 *)dfa->accepts->data;
+	entries = (const lt_tag_dfa_entry_t *)dfa->entries->data;
+	result->grandfathered = NULL;
+	result->redundant = NULL;
+	result->state = STATE_NONE;
+	result->tail = length;
+	result->n_subtags = 0;
+
+	for (i = 0; i <= length; i++) {
+		if (i < length) {
+			sym = dfa->symbols[(guchar)tag_string[i]];
+			if (sym == 0)
+				return FALSE;
+			whole = transitions[whole * LT_TAG_DFA_N_SYMBOLS + sym - 1];
+			if (sym != LT_TAG_DFA_N_SYMBOLS) {
+				subtag = transitions[subtag * LT_TAG_DFA_N_SYMBOLS + sym - 1];
+				continue;
+			}
+		}
+		/* reached at the end of subtag */
+		len = i - start;
+		if (!in_tail && !rejected) {
+			e = &entries[accepts[subtag]];
+			if (len == 1) {
+				if (state == STATE_LANG &&
+				    g_ascii_tolower(tag_string[start]) != 'x') {
+					rejected = TRUE;
+				} else {
+					in_tail = TRUE;
+					result->tail = start > 0 ? start - 1 : 0;
+				}
+			} else if (state == STATE_LANG) {
+				if (len <= 3 && (e->types & LT_TAG_DFA_LANG))
+					rejected = !lt_tag_dfa_emit(result, STATE_LANG, start, len, e->id, e->lang);
+				else
+					rejected = TRUE;
+				state = STATE_EXTLANG;
+			} else if (state == STATE_EXTLANG &&
+				   (e->types & LT_TAG_DFA_EXTLANG)) {
+				rejected = !lt_tag_dfa_emit(result, STATE_EXTLANG, start, len, e->id, e->extlang);
+				state = STATE_SCRIPT;
+			} else if (state <= STATE_SCRIPT &&
+				   (e->types & LT_TAG_DFA_SCRIPT)) {
+				rejected = !lt_tag_dfa_emit(result, STATE_SCRIPT, start, len, e->id, e->script);
+				state = STATE_REGION;
+			} else if (state <= STATE_REGION &&
+				   (e->types & LT_TAG_DFA_REGION)) {
+				rejected = !lt_tag_dfa_emit(result, STATE_REGION, start, len, e->id, e->region);
+				state = STATE_VARIANT;
+			} else if (state <= STATE_VARIANT &&
+				   (e->types & LT_TAG_DFA_VARIANT)) {
+				rejected = !lt_tag_dfa_emit(result, STATE_VARIANT, start, len, e->id, e->variant);
+				state = STATE_VARIANT;
+			} else {
+				rejected = TRUE;
+			}
+		}
+		/* nothing to see anymore */
+		if ((in_tail || rejected) && whole == LT_TAG_DFA_DEAD)
+			break;
+		subtag = LT_TAG_DFA_SUBTAG;
+		start = i + 1;
+	}
+	if (whole != LT_TAG_DFA_DEAD) {
+		e = &entries[accepts[whole]];
+		result->grandfathered = e->grandfathered;
+		result->redundant = e->redundant;
+		if (result->grandfathered)
+			return TRUE;
+	}
+
+	return !rejected;
+}
+
+/*
+ * Walk @string from @state. Returns the state reached at the end, or
+ * LT_TAG_DFA_DEAD if no subtags nor tags start with @string.
+ */
+guint
+lt_tag_dfa_walk(lt_tag_dfa_t *dfa,
+		guint         state,
+		const gchar  *string,
+		gsize         length)
+{
+	const guint16 *transitions;
+	gsize i;
+
+	g_return_val_if_fail (dfa != NULL, LT_TAG_DFA_DEAD);
+	g_return_val_if_fail (state < dfa->accepts->len, LT_TAG_DFA_DEAD);
+
+	transitions = (const guint16 *)dfa->transitions->data;
+	for (i = 0; i < length && state != LT_TAG_DFA_DEAD; i++) {
+		guint sym = dfa->symbols[(guchar)string[i]];
+
+		if (sym == 0)
+			return LT_TAG_DFA_DEAD;
+		state = transitions[state * LT_TAG_DFA_N_SYMBOLS + sym - 1];
+	}
+
+	return state;
+}
+
+/* Returns the types accepted at @state or any states after it. */
+guint
+lt_tag_dfa_get_reach(lt_tag_dfa_t *dfa,
+		     guint         state)
+{
+	g_return_val_if_fail (dfa != NULL, 0);
+	g_return_val_if_fail (state < dfa->reach->len, 0);
+
+	return g_array_index(dfa->reach, guint8, state);
+}
+
+/*
+ * Visit the states accepting any of @types after @state in the breadth-first
+ * order, that is, the shorter ones first and then in alphabetical order.
+ * the branches without such states aren't visited at all.
+ */
+void
+lt_tag_dfa_iter_init(lt_tag_dfa_t      *dfa,
+		     lt_tag_dfa_iter_t *iter,
+		     guint              state,
+		     guint              types)
+{
+	g_return_if_fail (dfa != NULL);
+	g_return_if_fail (iter != NULL);
+
+	iter->dfa = lt_tag_dfa_ref(dfa);
+	iter->types = types;
+	iter->head = 0;
+	iter->queue = g_array_new(FALSE, FALSE, sizeof (guint16));
+	if (state != LT_TAG_DFA_DEAD &&
+	    (lt_tag_dfa_get_reach(dfa, state) & types) != 0) {
+		guint16 s = state;
+
+		g_array_append_val(iter->queue, s);
+	}
+}
+
+/*
+ * Returns the registered form of the next subtag or tag, and its type
+ * in @type, or %NULL if no more entries.
+ */
+const gchar *
+lt_tag_dfa_iter_next(lt_tag_dfa_iter_t *iter,
+		     guint             *type)
+{
+	g_return_val_if_fail (iter != NULL, NULL);
+
+	while (iter->head < iter->queue->len) {
+		lt_tag_dfa_t *dfa = iter->dfa;
+		const guint16 *transitions = (const guint16 *)dfa->transitions->data;
+		const guint8 *reach = (const guint8 *)dfa->reach->data;
+		guint state = g_array_index(iter->queue, guint16, iter->head++);
+		const lt_tag_dfa_entry_t *e;
+		guint i, t;
+
+		for (i = 0; i < LT_TAG_DFA_N_SYMBOLS; i++) {
+			guint16 next = transitions[state * LT_TAG_DFA_N_SYMBOLS + i];
+
+			if (next != LT_TAG_DFA_DEAD && (reach[next] & iter->types) != 0)
+				g_array_append_val(iter->queue, next);
+		}
+		e = &g_array_index(dfa->entries, lt_tag_dfa_entry_t,
+				   g_array_index(dfa->accepts, guint16, state));
+		t = e->types & iter->types;
+		if (t == 0)
+			continue;
+		/* take the first one in the order of the subtags in a tag */
+		t &= -t;
+		if (type)
+			*type = t;
+		switch (t) {
+		    case LT_TAG_DFA_LANG:
+			    return lt_lang_get_tag(e->lang);
+		    case LT_TAG_DFA_EXTLANG:
+			    return lt_extlang_get_tag(e->extlang);
+		    case LT_TAG_DFA_SCRIPT:
+			    return lt_script_get_tag(e->script);
+		    case LT_TAG_DFA_REGION:
+			    return lt_region_get_tag(e->region);
+		    case LT_TAG_DFA_VARIANT:
+			    return lt_variant_get_tag(e->variant);
+		    case LT_TAG_DFA_GRANDFATHERED:
+			    return lt_grandfathered_get_tag(e->grandfathered);
+		    case LT_TAG_DFA_REDUNDANT:
+			    return lt_redundant_get_tag(e->redundant);
+		    default:
+			    break;
+		}
+	}
+
+	return NULL;
+}
+
+void
+lt_tag_dfa_iter_finish(lt_tag_dfa_iter_t *iter)
+{
+	g_return_if_fail (iter != NULL);
+
+	if (iter->queue)
+		g_array_free(iter->queue, TRUE);
+	iter->queue = NULL;
+	lt_tag_dfa_unref(iter->dfa);
+	iter->dfa = NULL;
+}
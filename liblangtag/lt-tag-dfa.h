@@ -0,0 +1,114 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-tag-dfa.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __LT_TAG_DFA_H__
+#define __LT_TAG_DFA_H__
+
+#include <glib.h>
+#include "lt-extlang.h"
+#include "lt-grandfathered.h"
+#include "lt-lang.h"
+#include "lt-redundant.h"
+#include "lt-region.h"
+#include "lt-script.h"
+#include "lt-variant.h"
+#include "lt-tag-private.h"
+
+G_BEGIN_DECLS
+
+/* the number of the registered subtags to be identified at once */
+#define LT_TAG_DFA_MAX_SUBTAGS	16
+
+/* the special states */
+enum {
+	LT_TAG_DFA_DEAD = 0,
+	LT_TAG_DFA_SUBTAG,
+	LT_TAG_DFA_TAG,
+	LT_TAG_DFA_BEGIN
+};
+
+/* the types of the entries, in the order of the subtags in a tag */
+enum {
+	LT_TAG_DFA_LANG          = 1 << 0,
+	LT_TAG_DFA_EXTLANG       = 1 << 1,
+	LT_TAG_DFA_SCRIPT        = 1 << 2,
+	LT_TAG_DFA_REGION        = 1 << 3,
+	LT_TAG_DFA_VARIANT       = 1 << 4,
+	LT_TAG_DFA_GRANDFATHERED = 1 << 5,
+	LT_TAG_DFA_REDUNDANT     = 1 << 6
+};
+
+typedef struct _lt_tag_dfa_t		lt_tag_dfa_t;
+typedef struct _lt_tag_dfa_subtag_t	lt_tag_dfa_subtag_t;
+typedef struct _lt_tag_dfa_result_t	lt_tag_dfa_result_t;
+typedef struct _lt_tag_dfa_iter_t	lt_tag_dfa_iter_t;
+
+struct _lt_tag_dfa_subtag_t {
+	lt_tag_state_t  type;
+	guint           id;
+	gsize           offset;
+	gsize           length;
+	gpointer        object;
+};
+
+/* all of the objects are owned by lt_tag_dfa_t */
+struct _lt_tag_dfa_result_t {
+	lt_grandfathered_t  *grandfathered;
+	lt_redundant_t      *redundant;
+	lt_tag_state_t       state;
+	gsize                tail;
+	gsize                n_subtags;
+	lt_tag_dfa_subtag_t  subtags[LT_TAG_DFA_MAX_SUBTAGS];
+};
+
+struct _lt_tag_dfa_iter_t {
+	lt_tag_dfa_t *dfa;
+	guint         types;
+	guint         head;
+	GArray       *queue;
+};
+
+lt_tag_dfa_t *lt_tag_dfa_new        (void);
+lt_tag_dfa_t *lt_tag_dfa_ref        (lt_tag_dfa_t        *dfa);
+void          lt_tag_dfa_unref      (lt_tag_dfa_t        *dfa);
+gboolean      lt_tag_dfa_run        (lt_tag_dfa_t        *dfa,
+                                     const gchar         *tag_string,
+                                     gsize                length,
+                                     lt_tag_dfa_result_t *result);
+guint         lt_tag_dfa_walk       (lt_tag_dfa_t        *dfa,
+                                     guint                state,
+                                     const gchar         *string,
+                                     gsize                length);
+guint         lt_tag_dfa_get_reach  (lt_tag_dfa_t        *dfa,
+                                     guint                state);
+void          lt_tag_dfa_iter_init  (lt_tag_dfa_t        *dfa,
+                                     lt_tag_dfa_iter_t   *iter,
+                                     guint                state,
+                                     guint                types);
+const gchar  *lt_tag_dfa_iter_next  (lt_tag_dfa_iter_t   *iter,
+                                     guint               *type);
+void          lt_tag_dfa_iter_finish(lt_tag_dfa_iter_t   *iter);
+lt_tag_dfa_t *lt_db_get_tag_dfa     (void);
+lt_tag_dfa_t *lt_tag_get_dfa        (void);
+
+G_END_DECLS
+
+#endif /* __LT_TAG_DFA_H__ */
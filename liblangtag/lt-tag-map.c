@@ -0,0 +1,238 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-tag-map.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "lt-error.h"
+#include "lt-mem.h"
+#include "lt-match-data.h"
+#include "lt-utils.h"
+#include "lt-fallback-iter.h"
+#include "lt-tag.h"
+#include "lt-tag-map.h"
+
+/* the canonicalized requests longer than this are looked up as they are */
+#define LT_TAG_MAP_BUFSIZE	256
+
+
+/**
+ * SECTION: lt-tag-map
+ * @Short_Description: A container class to map Language tags to the resources
+ * @Title: Container - Tag Map
+ *
+ * This container class maps the language tags to the values, such as
+ * the translations, and finds the best one for the language tag
+ * requested. the keys are canonicalized when they are inserted, and
+ * so is the request before the lookup. then the lookup walks the fallback
+ * chain of the request in the same manner as #lt_fallback_iter_t, so that
+ * each step costs one hash probe.
+ */
+struct _lt_tag_map_t {
+	lt_mem_t         parent;
+	lt_match_data_t *data;
+	GHashTable      *entries;
+};
+
+/*< public >*/
+/**
+ * lt_tag_map_new:
+ * @value_destroy_func: (allow-none): a function to free the values, or %NULL.
+ *
+ * Create a new instance of #lt_tag_map_t.
+ *
+ * Returns: (transfer full): a new instance of #lt_tag_map_t.
+ */
+lt_tag_map_t *
+lt_tag_map_new(GDestroyNotify value_destroy_func)
+{
+	lt_tag_map_t *retval = lt_mem_alloc_object(sizeof (lt_tag_map_t));
+
+	if (retval) {
+		/* keep the parent locales loaded while @retval is alive */
+		retval->data = lt_db_get_match_data();
+		if (retval->data)
+			lt_mem_add_ref(&retval->parent, retval->data,
+				       (lt_destroy_func_t)lt_match_data_unref);
+		retval->entries = g_hash_table_new_full(lt_strcase_hash,
+							lt_strcase_equal,
+							g_free,
+							value_destroy_func);
+		lt_mem_add_ref(&retval->parent, retval->entries,
+			       (lt_destroy_func_t)g_hash_table_destroy);
+	}
+
+	return retval;
+}
+
+/**
+ * lt_tag_map_ref:
+ * @map: a #lt_tag_map_t.
+ *
+ * Increases the reference count of @map.
+ *
+ * Returns: (transfer none): the same @map object.
+ */
+lt_tag_map_t *
+lt_tag_map_ref(lt_tag_map_t *map)
+{
+	g_return_val_if_fail (map != NULL, NULL);
+
+	return lt_mem_ref(&map->parent);
+}
+
+/**
+ * lt_tag_map_unref:
+ * @map: a #lt_tag_map_t.
+ *
+ * Decreases the reference count of @map. when its reference count
+ * drops to 0, the object is finalized (i.e. its memory is freed).
+ */
+void
+lt_tag_map_unref(lt_tag_map_t *map)
+{
+	if (map)
+		lt_mem_unref(&map->parent);
+}
+
+/**
+ * lt_tag_map_insert:
+ * @map: a #lt_tag_map_t.
+ * @tag_string: a language tag, or "root" for the value to fall back at last.
+ * @value: the value to be associated with @tag_string.
+ * @error: (allow-none): a #GError.
+ *
+ * Associate @value with @tag_string. @tag_string is canonicalized, and
+ * the value associated with the same canonical tag before is replaced.
+ * this isn't thread-safe. all of the values have to be inserted before
+ * @map is shared.
+ *
+ * Returns: %TRUE if @value is inserted, or %FALSE if @tag_string is invalid.
+ */
+gboolean
+lt_tag_map_insert(lt_tag_map_t  *map,
+		  const gchar   *tag_string,
+		  gpointer       value,
+		  GError       **error)
+{
+	lt_tag_t *tag = NULL;
+	gchar *key = NULL;
+	GError *err = NULL;
+
+	g_return_val_if_fail (map != NULL, FALSE);
+	g_return_val_if_fail (tag_string != NULL, FALSE);
+
+	if (lt_strcase_equal(tag_string, "root")) {
+		key = g_strdup("root");
+	} else {
+		tag = lt_tag_new();
+		if (!lt_tag_parse(tag, tag_string, &err))
+			goto bail;
+		key = lt_tag_canonicalize(tag, &err);
+		if (err)
+			goto bail;
+	}
+	g_hash_table_replace(map->entries, key, value);
+  bail:
+	if (tag)
+		lt_tag_unref(tag);
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * lt_tag_map_size:
+ * @map: a #lt_tag_map_t.
+ *
+ * Obtains the number of the language tags in @map.
+ *
+ * Returns: the number of the entries.
+ */
+guint
+lt_tag_map_size(lt_tag_map_t *map)
+{
+	g_return_val_if_fail (map != NULL, 0);
+
+	return g_hash_table_size(map->entries);
+}
+
+/**
+ * lt_tag_map_lookup:
+ * @map: a #lt_tag_map_t.
+ * @tag_string: a language tag requested, such as "zh-Hant-HK".
+ * @matched_tag: (out) (allow-none) (transfer none): the location to store
+ *               the key in @map that is found, or %NULL.
+ *
+ * Find the value for @tag_string. if it isn't in @map as is, the fallback
+ * chain of @tag_string is walked until any of them is found, such as
+ * "zh-Hant" and then "root". @tag_string is canonicalized as the keys are,
+ * so that "iw-IL" finds the value for "he". this is safe to call from
+ * multiple threads at the same time.
+ *
+ * Returns: the value found, or %NULL if nothing is found.
+ */
+gpointer
+lt_tag_map_lookup(lt_tag_map_t  *map,
+		  const gchar   *tag_string,
+		  const gchar  **matched_tag)
+{
+	lt_fallback_iter_t iter;
+	lt_tag_t *tag;
+	const gchar *s;
+	gchar buffer[LT_TAG_MAP_BUFSIZE];
+	gpointer key = NULL, retval = NULL;
+	GError *err = NULL;
+
+	g_return_val_if_fail (map != NULL, NULL);
+	g_return_val_if_fail (tag_string != NULL, NULL);
+
+	/* the requests which can't be parsed, such as "root", are looked up
+	 * as they are.
+	 */
+	tag = lt_tag_new();
+	if (lt_tag_parse(tag, tag_string, &err) &&
+	    lt_tag_canonicalize_to_buf(tag, buffer, sizeof (buffer), NULL, &err))
+		tag_string = buffer;
+	if (err)
+		g_error_free(err);
+	lt_tag_unref(tag);
+	lt_fallback_iter_init(&iter, tag_string);
+	while ((s = lt_fallback_iter_next(&iter)) != NULL) {
+		if (g_hash_table_lookup_extended(map->entries, s, &key, &retval))
+			break;
+		key = NULL;
+	}
+	lt_fallback_iter_finish(&iter);
+	if (matched_tag)
+		*matched_tag = key;
+
+	return retval;
+}
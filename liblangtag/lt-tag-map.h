@@ -0,0 +1,56 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * lt-tag-map.h
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__LANGTAG_H__INSIDE) && !defined (__LANGTAG_COMPILATION)
+#error "Only <liblangtag/langtag.h> can be included directly."
+#endif
+
+#ifndef __LT_TAG_MAP_H__
+#define __LT_TAG_MAP_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * lt_tag_map_t:
+ *
+ * All the fields in the <structname>lt_tag_map_t</structname>
+ * structure are private to the #lt_tag_map_t implementation.
+ */
+typedef struct _lt_tag_map_t	lt_tag_map_t;
+
+
+lt_tag_map_t *lt_tag_map_new   (GDestroyNotify   value_destroy_func);
+lt_tag_map_t *lt_tag_map_ref   (lt_tag_map_t    *map);
+void          lt_tag_map_unref (lt_tag_map_t    *map);
+gboolean      lt_tag_map_insert(lt_tag_map_t    *map,
+                                const gchar     *tag_string,
+                                gpointer         value,
+                                GError         **error);
+guint         lt_tag_map_size  (lt_tag_map_t    *map);
+gpointer      lt_tag_map_lookup(lt_tag_map_t    *map,
+                                const gchar     *tag_string,
+                                const gchar    **matched_tag);
+
+G_END_DECLS
+
+#endif /* __LT_TAG_MAP_H__ */
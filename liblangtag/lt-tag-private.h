@@ -55,9 +55,13 @@ enum _lt_tag_state_t {
 
 typedef enum _lt_tag_state_t	lt_tag_state_t;
 
-lt_tag_state_t lt_tag_parse_wildcard(lt_tag_t     *tag,
-				     const gchar  *tag_string,
-				     GError      **error);
+lt_tag_state_t lt_tag_parse_wildcard    (lt_tag_t     *tag,
+					 const gchar  *tag_string,
+					 gssize        length,
+					 GError      **error);
+void           lt_tag_intern_clear      (void);
+void           lt_tag_parser_clear      (void);
+void           lt_tag_locale_cache_clear(void);
 
 G_END_DECLS
 
@@ -23,16 +23,22 @@
 #include "config.h"
 #endif
 
+#ifdef HAVE_LANGINFO_H
 #include <langinfo.h>
+#endif
 #include <locale.h>
+#include <stdlib.h>
 #include <string.h>
 #include <libxml/xpath.h>
 #include "lt-database.h"
+#include "lt-database-private.h"
 #include "lt-error.h"
 #include "lt-ext-module-private.h"
 #include "lt-extension-private.h"
 #include "lt-localealias.h"
 #include "lt-mem.h"
+#include "lt-subtag-index.h"
+#include "lt-tag-dfa.h"
 #include "lt-utils.h"
 #include "lt-xml.h"
 #include "lt-tag.h"
@@ -46,15 +52,36 @@
  *
  * This container class provides an interface to deal with the language tag.
  */
+/* subtags are up to 8 characters. the rest is a room to report errors */
+#define LT_TAG_SCANNER_TOKEN_MAX	63
+
 typedef struct _lt_tag_scanner_t {
-	lt_mem_t  parent;
-	gchar    *string;
-	gsize     length;
-	gsize     position;
+	const gchar *string;
+	gsize        length;
+	gsize        position;
+	gchar        token[LT_TAG_SCANNER_TOKEN_MAX + 1];
 } lt_tag_scanner_t;
 
+/* 256 bytes is enough for most of tags in the real world */
+#define LT_TAG_WRITER_BUFSIZE		256
+#define LT_TAG_WRITER_MAX_SUBTAGS	16
+/* the subtag id in the binary form for unregistered subtags */
+#define LT_TAG_ENCODING_LITERAL		0xffff
+#define LT_TAG_ENCODING_SUBTAG_MAX	8
+/* the tag strings given to lt_tag_intern() which are cached as they are */
+#define LT_TAG_INTERN_ALIASES_MAX	1024
+
+typedef struct _lt_tag_writer_t {
+	GString *string;
+	gchar   *buffer;
+	gsize    size;
+	gsize    length;
+	guint    hash;
+} lt_tag_writer_t;
+
 struct _lt_tag_t {
 	lt_mem_t            parent;
+	lt_mem_t           *storage;
 	gint32              wildcard_map;
 	lt_tag_state_t      state;
 	GString            *tag_string;
@@ -66,8 +93,27 @@ struct _lt_tag_t {
 	lt_extension_t     *extension;
 	GString            *privateuse;
 	lt_grandfathered_t *grandfathered;
+	gboolean            frozen;
+	gchar              *canonical_string;
 };
 
+/* the tag for the locale effective in a thread */
+typedef struct _lt_tag_locale_cache_t {
+	gint      serial;
+	gchar    *locale;
+	lt_tag_t *tag;
+} lt_tag_locale_cache_t;
+
+static GHashTable *__lt_tag_intern_table = NULL;
+static GHashTable *__lt_tag_intern_aliases = NULL;
+static volatile gint __lt_tag_parser = LT_TAG_PARSER_DEFAULT;
+static lt_tag_dfa_t *__lt_tag_dfa = NULL;
+static volatile gint __lt_tag_locale_serial = 0;
+static volatile gint __lt_tag_intern_serial = 0;
+
+G_LOCK_DEFINE_STATIC (lt_tag_intern);
+G_LOCK_DEFINE_STATIC (lt_tag_dfa);
+
 /*< private >*/
 static gboolean
 _lt_tag_gstring_compare(const GString *v1,
@@ -107,35 +153,41 @@ _lt_tag_variants_list_free(GList *list)
 	g_list_free(list);
 }
 
-static lt_tag_scanner_t *
-lt_tag_scanner_new(const gchar *tag)
+static gboolean
+_lt_tag_is_frozen_with_error(const lt_tag_t  *tag,
+			     GError         **error)
 {
-	lt_tag_scanner_t *retval = lt_mem_alloc_object(sizeof (lt_tag_scanner_t));
-
-	if (retval) {
-		retval->string = g_strdup(tag);
-		lt_mem_add_ref(&retval->parent, retval->string,
-			       (lt_destroy_func_t)g_free);
-		retval->length = strlen(tag);
+	if (tag->frozen) {
+		g_set_error(error, LT_ERROR, LT_ERR_INVALID,
+			    "Frozen tag can't be modified: %s",
+			    tag->tag_string ? tag->tag_string->str : "");
+		return TRUE;
 	}
 
-	return retval;
+	return FALSE;
 }
 
+/* The scanner works on @tag as is, which doesn't need to be
+ * nul-terminated. the tokens are copied into the scanner.
+ */
 static void
-lt_tag_scanner_unref(lt_tag_scanner_t *scanner)
+lt_tag_scanner_init(lt_tag_scanner_t *scanner,
+		    const gchar      *tag,
+		    gsize             length)
 {
-	if (scanner)
-		lt_mem_unref(&scanner->parent);
+	scanner->string = tag;
+	scanner->length = length;
+	scanner->position = 0;
+	scanner->token[0] = 0;
 }
 
 static gboolean
 lt_tag_scanner_get_token(lt_tag_scanner_t  *scanner,
-			 gchar            **retval,
+			 const gchar      **retval,
 			 gsize             *length,
 			 GError           **error)
 {
-	GString *string = NULL;
+	gsize len = 0;
 	gchar c;
 	GError *err = NULL;
 
@@ -147,11 +199,10 @@ lt_tag_scanner_get_token(lt_tag_scanner_t  *scanner,
 		goto bail;
 	}
 
-	string = g_string_new(NULL);
 	while (scanner->position < scanner->length) {
 		c = scanner->string[scanner->position++];
 		if (c == 0) {
-			if (string->len == 0) {
+			if (len == 0) {
 				g_set_error(&err, LT_ERROR, LT_ERR_EOT,
 					    "No more tokens in buffer");
 			}
@@ -159,7 +210,7 @@ lt_tag_scanner_get_token(lt_tag_scanner_t  *scanner,
 			break;
 		}
 		if (c == '*') {
-			if (string->len > 0) {
+			if (len > 0) {
 				g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
 					    "Invalid wildcard: positon = %" G_GSIZE_FORMAT,
 					    scanner->position - 1);
@@ -170,12 +221,19 @@ lt_tag_scanner_get_token(lt_tag_scanner_t  *scanner,
 				    "Invalid character for tag: '%c'", c);
 			break;
 		}
-		g_string_append_c(string, c);
+		if (len >= LT_TAG_SCANNER_TOKEN_MAX) {
+			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+				    "Too long subtag: positon = %" G_GSIZE_FORMAT,
+				    scanner->position - 1);
+			break;
+		}
+		scanner->token[len++] = c;
 
 		if (c == '-' ||
 		    c == '*')
 			break;
-		if (scanner->string[scanner->position] == '-' ||
+		if (scanner->position >= scanner->length ||
+		    scanner->string[scanner->position] == '-' ||
 		    scanner->string[scanner->position] == 0)
 			break;
 	}
@@ -186,16 +244,15 @@ lt_tag_scanner_get_token(lt_tag_scanner_t  *scanner,
 		else
 			g_warning(err->message);
 		g_error_free(err);
-		if (string)
-			g_string_free(string, TRUE);
 		*retval = NULL;
 		*length = 0;
 
 		return FALSE;
 	}
 
-	*length = string->len;
-	*retval = g_string_free(string, FALSE);
+	scanner->token[len] = 0;
+	*length = len;
+	*retval = scanner->token;
 
 	return TRUE;
 }
@@ -206,8 +263,36 @@ lt_tag_scanner_is_eof(lt_tag_scanner_t *scanner)
 	g_return_val_if_fail (scanner != NULL, TRUE);
 	g_return_val_if_fail (scanner->position <= scanner->length, TRUE);
 
-	return scanner->string[scanner->position] == 0 ||
-		scanner->position >= scanner->length;
+	return scanner->position >= scanner->length ||
+		scanner->string[scanner->position] == 0;
+}
+
+static gboolean
+_lt_tag_is_alpha_len(const gchar *subtag,
+		     gsize        length)
+{
+	gsize i;
+
+	for (i = 0; i < length; i++) {
+		if (!g_ascii_isalpha(subtag[i]))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+_lt_tag_is_digit_len(const gchar *subtag,
+		     gsize        length)
+{
+	gsize i;
+
+	for (i = 0; i < length; i++) {
+		if (!g_ascii_isdigit(subtag[i]))
+			return FALSE;
+	}
+
+	return TRUE;
 }
 
 static gint
@@ -217,48 +302,52 @@ _lt_tag_variant_compare(gconstpointer a,
 	return (gulong)a - (gulong)b;
 }
 
-#define DEFUNC_TAG_FREE(__func__)					\
+/* The subtags are owned by tag->storage rather than tag itself.
+ * lt_tag_copy() shares it with the copy and it will be duplicated
+ * when either of them is modified. see lt_tag_unshare().
+ */
+#define DEFUNC_TAG_FREE(__func__, __owner__)				\
 	G_INLINE_FUNC void						\
 	lt_tag_free_ ##__func__ (lt_tag_t *tag)				\
 	{								\
 		if (tag->__func__) {					\
-			lt_mem_remove_ref(&tag->parent, tag->__func__);	\
+			lt_mem_remove_ref(__owner__, tag->__func__);	\
 			tag->__func__ = NULL;				\
 		}							\
 	}
 
-DEFUNC_TAG_FREE (language)
-DEFUNC_TAG_FREE (extlang)
-DEFUNC_TAG_FREE (script)
-DEFUNC_TAG_FREE (region)
-DEFUNC_TAG_FREE (variants)
-DEFUNC_TAG_FREE (extension)
-DEFUNC_TAG_FREE (grandfathered)
-DEFUNC_TAG_FREE (tag_string)
+DEFUNC_TAG_FREE (language, tag->storage)
+DEFUNC_TAG_FREE (extlang, tag->storage)
+DEFUNC_TAG_FREE (script, tag->storage)
+DEFUNC_TAG_FREE (region, tag->storage)
+DEFUNC_TAG_FREE (variants, tag->storage)
+DEFUNC_TAG_FREE (extension, tag->storage)
+DEFUNC_TAG_FREE (grandfathered, tag->storage)
+DEFUNC_TAG_FREE (tag_string, &tag->parent)
 
 #undef DEFUNC_TAG_FREE
 
-#define DEFUNC_TAG_SET(__func__, __unref_func__)			\
+#define DEFUNC_TAG_TAKE(__func__, __unref_func__)			\
 	G_INLINE_FUNC void						\
-	lt_tag_set_ ##__func__ (lt_tag_t *tag, gpointer p)		\
+	lt_tag_take_ ##__func__ (lt_tag_t *tag, gpointer p)		\
 	{								\
 		lt_tag_free_ ##__func__ (tag);				\
 		if (p) {						\
 			tag->__func__ = p;				\
-			lt_mem_add_ref(&tag->parent, tag->__func__,	\
+			lt_mem_add_ref(tag->storage, tag->__func__,	\
 				       (lt_destroy_func_t)__unref_func__); \
 		}							\
 	}
 
-DEFUNC_TAG_SET (language, lt_lang_unref)
-DEFUNC_TAG_SET (extlang, lt_extlang_unref)
-DEFUNC_TAG_SET (script, lt_script_unref)
-DEFUNC_TAG_SET (region, lt_region_unref)
-DEFUNC_TAG_SET (extension, lt_extension_unref)
-DEFUNC_TAG_SET (grandfathered, lt_grandfathered_unref)
+DEFUNC_TAG_TAKE (language, lt_lang_unref)
+DEFUNC_TAG_TAKE (extlang, lt_extlang_unref)
+DEFUNC_TAG_TAKE (script, lt_script_unref)
+DEFUNC_TAG_TAKE (region, lt_region_unref)
+DEFUNC_TAG_TAKE (extension, lt_extension_unref)
+DEFUNC_TAG_TAKE (grandfathered, lt_grandfathered_unref)
 
 G_INLINE_FUNC void
-lt_tag_set_variant(lt_tag_t *tag,
+lt_tag_take_variant(lt_tag_t *tag,
 		   gpointer  p)
 {
 	gboolean no_variants = (tag->variants == NULL);
@@ -266,18 +355,19 @@ lt_tag_set_variant(lt_tag_t *tag,
 	if (p) {
 		tag->variants = g_list_append(tag->variants, p);
 		if (no_variants)
-			lt_mem_add_ref(&tag->parent, tag->variants,
+			lt_mem_add_ref(tag->storage, tag->variants,
 				       (lt_destroy_func_t)_lt_tag_variants_list_free);
 	} else {
 		g_warn_if_reached();
 	}
 }
 
-#undef DEFUNC_TAG_SET
+#undef DEFUNC_TAG_TAKE
 
 G_INLINE_FUNC void
-lt_tag_add_tag_string(lt_tag_t    *tag,
-		      const gchar *s)
+lt_tag_add_tag_string_len(lt_tag_t    *tag,
+			  const gchar *s,
+			  gsize        len)
 {
 	if (!tag->tag_string) {
 		tag->tag_string = g_string_new(NULL);
@@ -287,25 +377,106 @@ lt_tag_add_tag_string(lt_tag_t    *tag,
 	if (s) {
 		if (tag->tag_string->len > 0)
 			g_string_append_c(tag->tag_string, '-');
-		g_string_append(tag->tag_string, s);
+		g_string_append_len(tag->tag_string, s, len);
 	} else {
 		g_warn_if_reached();
 	}
 }
 
+G_INLINE_FUNC void
+lt_tag_add_tag_string(lt_tag_t    *tag,
+		      const gchar *s)
+{
+	lt_tag_add_tag_string_len(tag, s, s ? strlen(s) : 0);
+}
+
+static void
+lt_tag_set_storage(lt_tag_t *tag,
+		   lt_mem_t *storage)
+{
+	if (tag->storage)
+		lt_mem_remove_ref(&tag->parent, tag->storage);
+	tag->storage = storage;
+	lt_mem_add_ref(&tag->parent, tag->storage,
+		       (lt_destroy_func_t)lt_mem_unref);
+}
+
+static void
+lt_tag_new_storage(lt_tag_t *tag)
+{
+	lt_tag_set_storage(tag, lt_mem_alloc_object(sizeof (lt_mem_t)));
+	tag->language = NULL;
+	tag->extlang = NULL;
+	tag->script = NULL;
+	tag->region = NULL;
+	tag->variants = NULL;
+	tag->extension = NULL;
+	tag->grandfathered = NULL;
+	tag->privateuse = g_string_new(NULL);
+	lt_mem_add_ref(tag->storage, tag->privateuse,
+		       (lt_destroy_func_t)lt_mem_gstring_free);
+}
+
+/* Take over the subtags from the shared storage before modifying @tag. */
+static void
+lt_tag_unshare(lt_tag_t *tag)
+{
+	lt_lang_t *language = tag->language;
+	lt_extlang_t *extlang = tag->extlang;
+	lt_script_t *script = tag->script;
+	lt_region_t *region = tag->region;
+	GList *l, *variants = tag->variants;
+	lt_extension_t *extension = tag->extension;
+	GString *privateuse = tag->privateuse;
+	lt_grandfathered_t *grandfathered = tag->grandfathered;
+	lt_mem_t *storage;
+
+	if (g_atomic_int_get(&tag->storage->ref_count) == 1)
+		return;
+
+	/* keep the shared storage alive until all of subtags are taken. */
+	storage = lt_mem_ref(tag->storage);
+	lt_tag_new_storage(tag);
+	if (language)
+		lt_tag_take_language(tag, lt_lang_ref(language));
+	if (extlang)
+		lt_tag_take_extlang(tag, lt_extlang_ref(extlang));
+	if (script)
+		lt_tag_take_script(tag, lt_script_ref(script));
+	if (region)
+		lt_tag_take_region(tag, lt_region_ref(region));
+	for (l = variants; l != NULL; l = g_list_next(l)) {
+		lt_tag_take_variant(tag, lt_variant_ref(l->data));
+	}
+	if (extension)
+		lt_tag_take_extension(tag, lt_extension_copy(extension));
+	g_string_append(tag->privateuse, privateuse->str);
+	if (grandfathered)
+		lt_tag_take_grandfathered(tag, lt_grandfathered_ref(grandfathered));
+	lt_mem_unref(storage);
+}
+
+/* compare @key with the string at the top of the table entry @entry */
+static int
+_lt_tag_strcase_entry_compare(const void *key,
+			      const void *entry)
+{
+	return g_ascii_strcasecmp(key, *(const gchar * const *)entry);
+}
+
 static const gchar *
 lt_tag_get_locale_from_locale_alias(const gchar *alias)
 {
-	gint i;
+	const lt_localealias_t *entry;
 
 	g_return_val_if_fail (alias != NULL, NULL);
 
-	for (i = 0; __lt_localealias_tables[i].alias != NULL; i++) {
-		if (g_ascii_strcasecmp(alias, __lt_localealias_tables[i].alias) == 0)
-			return __lt_localealias_tables[i].locale;
-	}
+	entry = bsearch(alias, __lt_localealias_tables,
+			G_N_ELEMENTS (__lt_localealias_tables),
+			sizeof (lt_localealias_t),
+			_lt_tag_strcase_entry_compare);
 
-	return NULL;
+	return entry ? entry->locale : NULL;
 }
 
 static void
@@ -326,33 +497,33 @@ lt_tag_fill_wildcard(lt_tag_t       *tag,
 		switch (i) {
 		    case STATE_LANG:
 			    langdb = lt_db_get_lang();
-			    lt_tag_set_language(tag, lt_lang_db_lookup(langdb, "*"));
+			    lt_tag_take_language(tag, lt_lang_db_lookup(langdb, "*"));
 			    lt_lang_db_unref(langdb);
 			    break;
 		    case STATE_EXTLANG:
 			    extlangdb = lt_db_get_extlang();
-			    lt_tag_set_extlang(tag, lt_extlang_db_lookup(extlangdb, "*"));
+			    lt_tag_take_extlang(tag, lt_extlang_db_lookup(extlangdb, "*"));
 			    lt_extlang_db_unref(extlangdb);
 			    break;
 		    case STATE_SCRIPT:
 			    scriptdb = lt_db_get_script();
-			    lt_tag_set_script(tag, lt_script_db_lookup(scriptdb, "*"));
+			    lt_tag_take_script(tag, lt_script_db_lookup(scriptdb, "*"));
 			    lt_script_db_unref(scriptdb);
 			    break;
 		    case STATE_REGION:
 			    regiondb = lt_db_get_region();
-			    lt_tag_set_region(tag, lt_region_db_lookup(regiondb, "*"));
+			    lt_tag_take_region(tag, lt_region_db_lookup(regiondb, "*"));
 			    lt_region_db_unref(regiondb);
 			    break;
 		    case STATE_VARIANT:
 			    variantdb = lt_db_get_variant();
-			    lt_tag_set_variant(tag, lt_variant_db_lookup(variantdb, "*"));
+			    lt_tag_take_variant(tag, lt_variant_db_lookup(variantdb, "*"));
 			    lt_variant_db_unref(variantdb);
 			    break;
 		    case STATE_EXTENSION:
 			    e = lt_extension_create();
 			    lt_extension_add_singleton(e, '*', NULL, NULL);
-			    lt_tag_set_extension(tag, e);
+			    lt_tag_take_extension(tag, e);
 			    break;
 		    case STATE_PRIVATEUSE:
 			    g_string_truncate(tag->privateuse, 0);
@@ -425,6 +596,178 @@ lt_tag_parse_prestate(lt_tag_t     *tag,
 	return retval;
 }
 
+/* @extlang is owned by @tag from now on */
+static gboolean
+lt_tag_parse_extlang(lt_tag_t      *tag,
+		     lt_extlang_t  *extlang,
+		     GError       **error)
+{
+	const gchar *prefix = lt_extlang_get_prefix(extlang);
+	const gchar *subtag = lt_extlang_get_tag(extlang);
+	const gchar *lang = lt_lang_get_better_tag(tag->language);
+
+	if (prefix &&
+	    g_ascii_strcasecmp(prefix, lang) != 0) {
+		g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "extlang '%s' is supposed to be used with %s, but %s",
+			    subtag, prefix, lang);
+		lt_extlang_unref(extlang);
+
+		return FALSE;
+	}
+	tag->extlang = extlang;
+	lt_mem_add_ref(tag->storage, tag->extlang,
+		       (lt_destroy_func_t)lt_extlang_unref);
+	tag->state = STATE_PRE_SCRIPT;
+
+	return TRUE;
+}
+
+/* @variant is owned by @tag from now on. @error has to be non-NULL. */
+static gboolean
+lt_tag_parse_variant(lt_tag_t      *tag,
+		     lt_variant_t  *variant,
+		     const gchar   *token,
+		     GError       **error)
+{
+	const GList *prefixes = lt_variant_get_prefix(variant), *l;
+	gchar *langtag = lt_tag_canonicalize(tag, error);
+	GString *str_prefixes = g_string_new(NULL);
+	gboolean matched = FALSE;
+
+	if (error && *error) {
+		/* ignore it and fallback to the original tag string */
+		g_error_free(*error);
+		*error = NULL;
+		langtag = g_strdup(tag->tag_string->str);
+	}
+	for (l = prefixes; l != NULL; l = g_list_next(l)) {
+		const gchar *s = l->data;
+
+		if (str_prefixes->len > 0)
+			g_string_append(str_prefixes, ",");
+		g_string_append(str_prefixes, s);
+
+		if (g_ascii_strncasecmp(s, langtag, strlen(s)) == 0) {
+			matched = TRUE;
+			break;
+		}
+	}
+	if (prefixes && !matched) {
+		g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "variant '%s' is supposed to be used with %s, but %s",
+			    token, str_prefixes->str, langtag);
+		lt_variant_unref(variant);
+	} else {
+		if (!tag->variants) {
+			lt_tag_take_variant(tag, variant);
+		} else {
+			GList *prefixes = (GList *)lt_variant_get_prefix(variant);
+			const gchar *tstr;
+
+			lt_tag_free_tag_string(tag);
+			tstr = lt_tag_get_string(tag);
+			if (prefixes && !g_list_find_custom(prefixes, tstr, (GCompareFunc)g_strcmp0)) {
+				g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+					    "Variant isn't allowed for %s: %s",
+					    tstr,
+					    lt_variant_get_tag(variant));
+				lt_variant_unref(variant);
+			} else if (!prefixes && g_list_find_custom(tag->variants, variant, _lt_tag_variant_compare)) {
+				g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+					    "Duplicate variants: %s",
+					    lt_variant_get_tag(variant));
+				lt_variant_unref(variant);
+			} else {
+				tag->variants = g_list_append(tag->variants,
+							      variant);
+			}
+		}
+		/* multiple variants are allowed. */
+		tag->state = STATE_PRE_VARIANT;
+	}
+	g_free(langtag);
+	g_string_free(str_prefixes, TRUE);
+
+	return *error == NULL;
+}
+
+/* Check the prefixes of the variants again after the subtags before them
+ * are replaced. the variants are put back one by one as the parser does
+ * and the original list is restored if any of them doesn't fit.
+ */
+static gboolean
+_lt_tag_revalidate_variants(lt_tag_t  *tag,
+			    GError   **error)
+{
+	GList *l, *variants = tag->variants;
+	lt_tag_state_t state = tag->state;
+	GError *err = NULL;
+
+	if (!variants)
+		return TRUE;
+	lt_mem_delete_ref(tag->storage, variants);
+	tag->variants = NULL;
+	lt_tag_free_tag_string(tag);
+	for (l = variants; l != NULL; l = g_list_next(l)) {
+		/* lt_tag_parse_variant() may fall back to the tag string */
+		lt_tag_get_string(tag);
+		if (!lt_tag_parse_variant(tag, lt_variant_ref(l->data),
+					  lt_variant_get_tag(l->data), &err))
+			break;
+	}
+	/* lt_tag_parse_variant() rewinds the state */
+	tag->state = state;
+	if (err) {
+		g_propagate_error(error, err);
+		lt_tag_free_variants(tag);
+		tag->variants = variants;
+		lt_mem_add_ref(tag->storage, tag->variants,
+			       (lt_destroy_func_t)_lt_tag_variants_list_free);
+
+		return FALSE;
+	}
+	_lt_tag_variants_list_free(variants);
+
+	return TRUE;
+}
+
+/* Make the parser state consistent with the subtags set through
+ * the builder functions, so that lt_tag_parse_with_extra_token() can
+ * continue from it.
+ */
+static void
+_lt_tag_update_state(lt_tag_t *tag)
+{
+	if (tag->extension || tag->privateuse->len > 0)
+		return;
+	if (tag->variants || tag->region)
+		tag->state = STATE_PRE_VARIANT;
+	else if (tag->script)
+		tag->state = STATE_PRE_REGION;
+	else if (tag->extlang)
+		tag->state = STATE_PRE_SCRIPT;
+	else
+		tag->state = STATE_PRE_EXTLANG;
+}
+
+static gboolean
+_lt_tag_prepare_builder(lt_tag_t  *tag,
+			gboolean   need_language,
+			GError   **error)
+{
+	if (_lt_tag_is_frozen_with_error(tag, error))
+		return FALSE;
+	lt_tag_unshare(tag);
+	if (need_language && !tag->language) {
+		g_set_error(error, LT_ERROR, LT_ERR_NO_TAG,
+			    "No language subtag to build on.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 static gboolean
 lt_tag_parse_state(lt_tag_t     *tag,
 		   const gchar  *token,
@@ -469,7 +812,7 @@ lt_tag_parse_state(lt_tag_t     *tag,
 				    tag->language = NULL;
 				    break;
 			    }
-			    lt_mem_add_ref(&tag->parent, tag->language,
+			    lt_mem_add_ref(tag->storage, tag->language,
 					   (lt_destroy_func_t)lt_lang_unref);
 			    tag->state = STATE_PRE_EXTLANG;
 		    } else if (length == 4) {
@@ -505,7 +848,7 @@ lt_tag_parse_state(lt_tag_t     *tag,
 					    lt_extlang_unref(tag->extlang);
 					    tag->extlang = NULL;
 				    } else {
-					    lt_mem_add_ref(&tag->parent, tag->extlang,
+					    lt_mem_add_ref(tag->storage, tag->extlang,
 							   (lt_destroy_func_t)lt_extlang_unref);
 					    tag->state = STATE_PRE_SCRIPT;
 				    }
@@ -519,7 +862,7 @@ lt_tag_parse_state(lt_tag_t     *tag,
 		    if (length == 4) {
 			    lt_script_db_t *scriptdb = lt_db_get_script();
 
-			    lt_tag_set_script(tag, lt_script_db_lookup(scriptdb, token));
+			    lt_tag_take_script(tag, lt_script_db_lookup(scriptdb, token));
 			    lt_script_db_unref(scriptdb);
 			    if (tag->script) {
 				    tag->state = STATE_PRE_REGION;
@@ -537,7 +880,7 @@ lt_tag_parse_state(lt_tag_t     *tag,
 			 g_ascii_isdigit(token[2]))) {
 			    lt_region_db_t *regiondb = lt_db_get_region();
 
-			    lt_tag_set_region(tag, lt_region_db_lookup(regiondb, token));
+			    lt_tag_take_region(tag, lt_region_db_lookup(regiondb, token));
 			    lt_region_db_unref(regiondb);
 			    if (tag->region) {
 				    tag->state = STATE_PRE_VARIANT;
@@ -556,64 +899,7 @@ lt_tag_parse_state(lt_tag_t     *tag,
 			    variant = lt_variant_db_lookup(variantdb, token);
 			    lt_variant_db_unref(variantdb);
 			    if (variant) {
-				    const GList *prefixes = lt_variant_get_prefix(variant), *l;
-				    gchar *langtag = lt_tag_canonicalize(tag, error);
-				    GString *str_prefixes = g_string_new(NULL);
-				    gboolean matched = FALSE;
-
-				    if (error && *error) {
-					    /* ignore it and fallback to the original tag string */
-					    g_error_free(*error);
-					    *error = NULL;
-					    langtag = g_strdup(tag->tag_string->str);
-				    }
-				    for (l = prefixes; l != NULL; l = g_list_next(l)) {
-					    const gchar *s = l->data;
-
-					    if (str_prefixes->len > 0)
-						    g_string_append(str_prefixes, ",");
-					    g_string_append(str_prefixes, s);
-
-					    if (g_ascii_strncasecmp(s, langtag, strlen(s)) == 0) {
-						    matched = TRUE;
-						    break;
-					    }
-				    }
-				    if (prefixes && !matched) {
-					    g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
-							"variant '%s' is supposed to be used with %s, but %s",
-							token, str_prefixes->str, langtag);
-					    lt_variant_unref(variant);
-				    } else {
-					    if (!tag->variants) {
-						    lt_tag_set_variant(tag, variant);
-					    } else {
-						    GList *prefixes = (GList *)lt_variant_get_prefix(variant);
-						    const gchar *tstr;
-
-						    lt_tag_free_tag_string(tag);
-						    tstr = lt_tag_get_string(tag);
-						    if (prefixes && !g_list_find_custom(prefixes, tstr, (GCompareFunc)g_strcmp0)) {
-							    g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
-									"Variant isn't allowed for %s: %s",
-									tstr,
-									lt_variant_get_tag(variant));
-							    lt_variant_unref(variant);
-						    } else if (!prefixes && g_list_find_custom(tag->variants, variant, _lt_tag_variant_compare)) {
-							    g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
-									"Duplicate variants: %s",
-									lt_variant_get_tag(variant));
-							    lt_variant_unref(variant);
-						    } else {
-							    tag->variants = g_list_append(tag->variants,
-											  variant);
-						    }
-					    }
-					    /* multiple variants are allowed. */
-					    tag->state = STATE_PRE_VARIANT;
-				    }
-				    g_free(langtag);
-				    g_string_free(str_prefixes, TRUE);
+				    lt_tag_parse_variant(tag, variant, token, error);
 				    break;
 			    }
 			    /* try to check something else */
@@ -628,7 +914,7 @@ lt_tag_parse_state(lt_tag_t     *tag,
 			token[0] != '*' &&
 			token[0] != '-') {
 			    if (!tag->extension)
-				    lt_tag_set_extension(tag, lt_extension_create());
+				    lt_tag_take_extension(tag, lt_extension_create());
 			    if (lt_extension_has_singleton(tag->extension, token[0])) {
 				    g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
 						"Duplicate singleton for extension: %s", token);
@@ -697,28 +983,253 @@ lt_tag_parse_state(lt_tag_t     *tag,
 	return retval;
 }
 
+/* The grandfathered tags are short enough to be looked up
+ * in the stack buffer.
+ */
+#define LT_TAG_GRANDFATHERED_MAX	32
+
+/*
+ * Most of tags in the real world are "ll", "ll-RR", "ll-Ssss" or
+ * "ll-Ssss-RR". they are recognized by the length and the positions of
+ * the hyphens, and the subtags are looked up directly. None of
+ * the grandfathered tags, which is the closed list in RFC 5646, has
+ * such shapes. FALSE is returned without touching @tag for anything else,
+ * including the unknown subtags, so that the general parser can deal
+ * with it and report errors.
+ */
+static gboolean
+_lt_tag_parse_fast(lt_tag_t    *tag,
+		   const gchar *langtag,
+		   gsize        length)
+{
+	const gchar *script_string = NULL, *region_string = NULL;
+	gchar subtag[5];
+	gsize llen, rlen = 0;
+	lt_lang_db_t *langdb;
+	lt_lang_t *lang;
+	lt_script_t *script = NULL;
+	lt_region_t *region = NULL;
+
+	if (length < 2 || length > 12)
+		return FALSE;
+	llen = length > 3 && langtag[2] == '-' ? 2 : MIN (length, 3);
+	if (!_lt_tag_is_alpha_len(langtag, llen))
+		return FALSE;
+	if (llen < length) {
+		const gchar *p = &langtag[llen + 1];
+		gsize rest = length - llen - 1;
+
+		if (langtag[llen] != '-')
+			return FALSE;
+		if (rest >= 4 && (rest == 4 || p[4] == '-') &&
+		    _lt_tag_is_alpha_len(p, 4)) {
+			script_string = p;
+			if (rest == 4)
+				goto lookup;
+			p += 5;
+			rest -= 5;
+		}
+		if ((rest == 2 && _lt_tag_is_alpha_len(p, 2)) ||
+		    (rest == 3 && _lt_tag_is_digit_len(p, 3))) {
+			region_string = p;
+			rlen = rest;
+		} else {
+			return FALSE;
+		}
+	}
+  lookup:
+	memcpy(subtag, langtag, llen);
+	subtag[llen] = 0;
+	langdb = lt_db_get_lang();
+	lang = lt_lang_db_lookup(langdb, subtag);
+	lt_lang_db_unref(langdb);
+	/* validate if it's really shortest one */
+	if (!lang || g_ascii_strcasecmp(lt_lang_get_tag(lang), subtag) != 0)
+		goto bail;
+	if (script_string) {
+		lt_script_db_t *scriptdb = lt_db_get_script();
+
+		memcpy(subtag, script_string, 4);
+		subtag[4] = 0;
+		script = lt_script_db_lookup(scriptdb, subtag);
+		lt_script_db_unref(scriptdb);
+		if (!script)
+			goto bail;
+	}
+	if (region_string) {
+		lt_region_db_t *regiondb = lt_db_get_region();
+
+		memcpy(subtag, region_string, rlen);
+		subtag[rlen] = 0;
+		region = lt_region_db_lookup(regiondb, subtag);
+		lt_region_db_unref(regiondb);
+		if (!region)
+			goto bail;
+	}
+	tag->language = lang;
+	lt_mem_add_ref(tag->storage, tag->language,
+		       (lt_destroy_func_t)lt_lang_unref);
+	lt_tag_take_script(tag, script);
+	lt_tag_take_region(tag, region);
+	if (region)
+		tag->state = STATE_PRE_VARIANT;
+	else if (script)
+		tag->state = STATE_PRE_REGION;
+	else
+		tag->state = STATE_PRE_EXTLANG;
+
+	return TRUE;
+  bail:
+	lt_lang_unref(lang);
+	lt_script_unref(script);
+
+	return FALSE;
+}
+
+/*< protected >*/
+lt_tag_dfa_t *
+lt_tag_get_dfa(void)
+{
+	lt_tag_dfa_t *retval;
+
+	/* the snapshot owns its own automaton */
+	if (lt_db_get_snapshot())
+		return lt_db_get_tag_dfa();
+
+	G_LOCK (lt_tag_dfa);
+	/* keep the instance until lt_db_finalize(). compiling it isn't cheap */
+	if (!__lt_tag_dfa)
+		__lt_tag_dfa = lt_db_get_tag_dfa();
+	retval = __lt_tag_dfa ? lt_tag_dfa_ref(__lt_tag_dfa) : NULL;
+	G_UNLOCK (lt_tag_dfa);
+
+	return retval;
+}
+
+/*
+ * Fill in @tag with the subtags identified by the automaton, up to
+ * the extensions or the private use subtags. @consumed is where
+ * the state machine continues from. FALSE is returned to let
+ * the state machine parse the whole of the tag and report errors.
+ */
+static gboolean
+_lt_tag_parse_with_dfa(lt_tag_t    *tag,
+		       const gchar *langtag,
+		       gsize        length,
+		       gsize       *consumed)
+{
+	lt_tag_dfa_t *dfa = lt_tag_get_dfa();
+	lt_tag_dfa_result_t result;
+	GError *err = NULL;
+	gboolean retval = FALSE;
+	gsize i;
+
+	if (!dfa)
+		return FALSE;
+	if (!lt_tag_dfa_run(dfa, langtag, length, &result))
+		goto bail;
+	if (result.grandfathered) {
+		lt_tag_take_grandfathered(tag, lt_grandfathered_ref(result.grandfathered));
+		*consumed = length;
+		retval = TRUE;
+		goto bail;
+	}
+	if (result.n_subtags == 0)
+		goto bail;
+	for (i = 0; i < result.n_subtags && !err; i++) {
+		const lt_tag_dfa_subtag_t *s = &result.subtags[i];
+
+		switch (s->type) {
+		    case STATE_LANG:
+			    tag->language = lt_lang_ref(s->object);
+			    lt_mem_add_ref(tag->storage, tag->language,
+					   (lt_destroy_func_t)lt_lang_unref);
+			    break;
+		    case STATE_EXTLANG:
+			    lt_tag_parse_extlang(tag, lt_extlang_ref(s->object), &err);
+			    break;
+		    case STATE_SCRIPT:
+			    lt_tag_take_script(tag, lt_script_ref(s->object));
+			    break;
+		    case STATE_REGION:
+			    lt_tag_take_region(tag, lt_region_ref(s->object));
+			    break;
+		    case STATE_VARIANT:
+			    G_STMT_START {
+				    gchar token[LT_TAG_SCANNER_TOKEN_MAX + 1];
+				    gsize len = MIN (s->length, LT_TAG_SCANNER_TOKEN_MAX);
+
+				    memcpy(token, &langtag[s->offset], len);
+				    token[len] = 0;
+				    lt_tag_parse_variant(tag, lt_variant_ref(s->object), token, &err);
+			    } G_STMT_END;
+			    break;
+		    default:
+			    break;
+		}
+	}
+	if (err) {
+		g_error_free(err);
+		lt_tag_parser_init(tag);
+		goto bail;
+	}
+	tag->state = result.state;
+	*consumed = result.tail;
+	retval = TRUE;
+  bail:
+	lt_tag_dfa_unref(dfa);
+
+	return retval;
+}
+
 static gboolean
 _lt_tag_parse(lt_tag_t     *tag,
 	      const gchar  *langtag,
+	      gssize        length,
 	      gboolean      allow_wildcard,
 	      GError      **error)
 {
-	lt_tag_scanner_t *scanner = NULL;
+	lt_tag_scanner_t scanner;
 	lt_grandfathered_db_t *grandfathereddb;
-	gchar *token = NULL;
+	const gchar *token = NULL;
 	gsize len = 0;
 	GError *err = NULL;
 	gboolean retval = TRUE;
 	lt_tag_state_t wildcard = STATE_NONE;
 	gint count = 0;
+	gsize consumed = 0;
+	lt_db_snapshot_t *pinned;
 
 	g_return_val_if_fail (tag != NULL, FALSE);
 	g_return_val_if_fail (langtag != NULL, FALSE);
 
-	if (tag->state == STATE_NONE) {
-		grandfathereddb = lt_db_get_grandfathered();
-		lt_tag_set_grandfathered(tag, lt_grandfathered_db_lookup(grandfathereddb, langtag));
-		lt_grandfathered_db_unref(grandfathereddb);
+	/* keep the same databases during parsing even if they are reloaded */
+	pinned = lt_db_pin_snapshot();
+	if (length < 0)
+		length = strlen(langtag);
+	lt_tag_scanner_init(&scanner, langtag, length);
+	if (tag->state == STATE_NONE &&
+	    g_atomic_int_get(&__lt_tag_parser) == LT_TAG_PARSER_DEFAULT &&
+	    _lt_tag_parse_fast(tag, langtag, length)) {
+		goto bail;
+	} else if (tag->state == STATE_NONE &&
+		   !allow_wildcard &&
+	    g_atomic_int_get(&__lt_tag_parser) == LT_TAG_PARSER_DFA &&
+	    _lt_tag_parse_with_dfa(tag, langtag, length, &consumed)) {
+		if (tag->grandfathered)
+			goto bail;
+		/* the rest is the extensions or the private use subtags */
+		lt_tag_scanner_init(&scanner, langtag + consumed, length - consumed);
+	} else if (tag->state == STATE_NONE) {
+		if (length < LT_TAG_GRANDFATHERED_MAX) {
+			gchar buffer[LT_TAG_GRANDFATHERED_MAX];
+
+			memcpy(buffer, langtag, length);
+			buffer[length] = 0;
+			grandfathereddb = lt_db_get_grandfathered();
+			lt_tag_take_grandfathered(tag, lt_grandfathered_db_lookup(grandfathereddb, buffer));
+			lt_grandfathered_db_unref(grandfathereddb);
+		}
 		if (tag->grandfathered) {
 			/* no need to lookup anymore. */
 			goto bail;
@@ -734,13 +1245,8 @@ _lt_tag_parse(lt_tag_t     *tag,
 			tag->state++;
 	}
 
-	scanner = lt_tag_scanner_new(langtag);
-	while (!lt_tag_scanner_is_eof(scanner)) {
-		if (token) {
-			g_free(token);
-			token = NULL;
-		}
-		if (!lt_tag_scanner_get_token(scanner, &token, &len, &err)) {
+	while (!lt_tag_scanner_is_eof(&scanner)) {
+		if (!lt_tag_scanner_get_token(&scanner, &token, &len, &err)) {
 			if (err)
 				break;
 			g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
@@ -786,12 +1292,12 @@ _lt_tag_parse(lt_tag_t     *tag,
 	    tag->state != STATE_IN_PRIVATEUSETOKEN &&
 	    tag->state != STATE_NONE) {
 		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
-			    "Invalid tag: %s, last token = '%s', state = %d, parsed count = %d",
-			    langtag, token, tag->state, count);
+			    "Invalid tag: %.*s, last token = '%s', state = %d, parsed count = %d",
+			    (gint)length, langtag, token, tag->state, count);
 	}
   bail:
-	lt_tag_add_tag_string(tag, langtag);
-	lt_tag_scanner_unref(scanner);
+	lt_db_unpin_snapshot(pinned);
+	lt_tag_add_tag_string_len(tag, langtag, length);
 	if (err) {
 		if (error)
 			*error = g_error_copy(err);
@@ -800,48 +1306,60 @@ _lt_tag_parse(lt_tag_t     *tag,
 		g_error_free(err);
 		retval = FALSE;
 	}
-	g_free(token);
 
 	return retval;
 }
 
 static gboolean
-_lt_tag_match(const lt_tag_t *v1,
-	      lt_tag_t       *v2,
-	      lt_tag_state_t  state)
+_lt_tag_match(const lt_tag_t       *v1,
+	      lt_tag_t             *v2,
+	      lt_tag_state_t        state,
+	      lt_tag_match_flags_t  flags)
 {
 	g_return_val_if_fail (v1 != NULL, FALSE);
 	g_return_val_if_fail (v2 != NULL, FALSE);
 
+	if ((flags & LT_TAG_MATCH_REGION_CONTAINMENT) != 0 &&
+	    v1->region && v2->region) {
+		lt_region_db_t *db = lt_db_get_region();
+
+		/* the region in the range is replaced with the one within it */
+		if (lt_region_db_contains(db,
+					  lt_region_get_tag(v2->region),
+					  lt_region_get_tag(v1->region)))
+			lt_tag_take_region(v2, lt_region_ref(v1->region));
+		lt_region_db_unref(db);
+	}
+
 	if (state > STATE_EXTLANG && !v2->extlang && v1->extlang) {
 		lt_extlang_db_t *db = lt_db_get_extlang();
 
-		lt_tag_set_extlang(v2, lt_extlang_db_lookup(db, ""));
+		lt_tag_take_extlang(v2, lt_extlang_db_lookup(db, ""));
 		lt_extlang_db_unref(db);
 	}
 	if (state > STATE_SCRIPT && !v2->script && v1->script) {
 		lt_script_db_t *db = lt_db_get_script();
 
-		lt_tag_set_script(v2, lt_script_db_lookup(db, ""));
+		lt_tag_take_script(v2, lt_script_db_lookup(db, ""));
 		lt_script_db_unref(db);
 	}
 	if (state > STATE_REGION && !v2->region && v1->region) {
 		lt_region_db_t *db = lt_db_get_region();
 
-		lt_tag_set_region(v2, lt_region_db_lookup(db, ""));
+		lt_tag_take_region(v2, lt_region_db_lookup(db, ""));
 		lt_region_db_unref(db);
 	}
 	if (state > STATE_VARIANT && !v2->variants && v1->variants) {
 		lt_variant_db_t *db = lt_db_get_variant();
 
-		lt_tag_set_variant(v2, lt_variant_db_lookup(db, ""));
+		lt_tag_take_variant(v2, lt_variant_db_lookup(db, ""));
 		lt_variant_db_unref(db);
 	}
 	if (state > STATE_EXTENSION && !v2->extension && v1->extension) {
 		lt_extension_t *e = lt_extension_create();
 
 		lt_extension_add_singleton(e, ' ', NULL, NULL);
-		lt_tag_set_extension(v2, e);
+		lt_tag_take_extension(v2, e);
 	}
 
 	return lt_tag_compare(v1, v2);
@@ -882,19 +1400,19 @@ _lt_tag_replace(lt_tag_t       *tag,
 {
 	if (rtag->language) {
 		g_return_if_fail (!tag->language);
-		lt_tag_set_language(tag, lt_lang_ref(rtag->language));
+		lt_tag_take_language(tag, lt_lang_ref(rtag->language));
 	}
 	if (rtag->extlang) {
 		g_return_if_fail (!tag->extlang);
-		lt_tag_set_extlang(tag, lt_extlang_ref(rtag->extlang));
+		lt_tag_take_extlang(tag, lt_extlang_ref(rtag->extlang));
 	}
 	if (rtag->script) {
 		g_return_if_fail (!tag->script);
-		lt_tag_set_script(tag, lt_script_ref(rtag->script));
+		lt_tag_take_script(tag, lt_script_ref(rtag->script));
 	}
 	if (rtag->region) {
 		g_return_if_fail (!tag->region);
-		lt_tag_set_region(tag, lt_region_ref(rtag->region));
+		lt_tag_take_region(tag, lt_region_ref(rtag->region));
 	}
 	if (rtag->variants) {
 		GList *l = rtag->variants;
@@ -902,13 +1420,13 @@ _lt_tag_replace(lt_tag_t       *tag,
 		g_return_if_fail (!tag->variants);
 
 		while (l != NULL) {
-			lt_tag_set_variant(tag, lt_variant_ref(l->data));
+			lt_tag_take_variant(tag, lt_variant_ref(l->data));
 			l = g_list_next(l);
 		}
 	}
 	if (rtag->extension) {
 		g_return_if_fail (!tag->extension);
-		lt_tag_set_extension(tag, lt_extension_ref(rtag->extension));
+		lt_tag_take_extension(tag, lt_extension_ref(rtag->extension));
 	}
 	if (rtag->privateuse) {
 		g_string_truncate(tag->privateuse, 0);
@@ -916,334 +1434,1836 @@ _lt_tag_replace(lt_tag_t       *tag,
 	}
 }
 
-/* borrowed the modifier related code from localehelper:
- * http://people.redhat.com/caolanm/BCP47/localehelper-1.0.0.tar.gz
- */
-/*
- * glibc typically uses these modifiers to indicate particular
- * scripts that the language is written in
- * See ISO-15924 http://unicode.org/iso15924/iso15924-codes.html
- */
-static gboolean
-_lt_tag_convert_script_from_locale_modifier(const gchar  *modifier,
-					    const gchar **ret)
-{
-	/* XXX: think about how to get rid of the hardcoded mapping table */
-	static const gchar * const maps[][2] = {
-		{ "Arabic", "Arab" },
-		{ "Imperial_Aramaic", "Armi" },
-		{ "Armenian", "Armn" },
-		{ "Avestan", "Avst" },
-		{ "Balinese", "Bali" },
-		{ "Bamum", "Bamu" },
-		{ "Bengali", "Beng" },
-		{ "Bopomofo", "Bopo" },
-		{ "Braille", "Brai" },
-		{ "Buginese", "Bugi" },
-		{ "Buhid", "Buhd" },
-		{ "Canadian_Aboriginal", "Cans" },
-		{ "Carian", "Cari" },
-		{ "Cham", "Cham" },
-		{ "Cherokee", "Cher" },
-		{ "Coptic", "Copt" },
-		{ "Cypriot", "Cprt" },
-		{ "Cyrillic", "Cyrl" },
-		{ "Devanagari", "Deva" },
-		{ "Deseret", "Dsrt" },
-		{ "Egyptian_Hierogyphs", "Egyp" },
-		{ "Ethiopic", "Ethi" },
-		{ "Georgian", "Geor" },
-		{ "Glagolitic", "Glag" },
-		{ "Gothic", "Goth" },
-		{ "Greek", "Grek" },
-		{ "Gujarati", "Gujr" },
-		{ "Gurmukhi", "Guru" },
-		{ "Hangul", "Hang" },
-		{ "Han", "Hani" },
-		{ "Hanunoo", "Hano" },
-		{ "Hebrew", "Hebr" },
-		{ "Hiragana", "Hira" },
-		{ "Katakana_Or_Hiragana", "Hrkt" },
-		{ "Old_Italic", "Ital" },
-		{ "Javanese", "Java" },
-		{ "Kayah_Li", "Kali" },
-		{ "Katakana", "Kana" },
-		{ "Kharoshthi", "Khar" },
-		{ "Khmer", "Khmr" },
-		{ "Kannada", "Knda" },
-		{ "Kaithi", "Kthi" },
-		{ "Tai_Tham", "Lana" },
-		{ "Lao", "Laoo" },
-		{ "Latin", "Latn" },
-		{ "Lepcha", "Lepc" },
-		{ "Limbu", "Limb" },
-		{ "Linear_B", "Linb" },
-		{ "Lisu", "Lisu" },
-		{ "Lycian", "Lyci" },
-		{ "Lydian", "Lydi" },
-		{ "Malayalam", "Mlym" },
-		{ "Mongolian", "Mong" },
-		{ "Meetei_Mayek", "Mtei" },
-		{ "Myanmar", "Mymr" },
-		{ "Nko", "Nkoo" },
-		{ "Ogham", "Ogam" },
-		{ "Ol_Chiki", "Olck" },
-		{ "Old_Turkic", "Orkh" },
-		{ "Oriya", "Orya" },
-		{ "Osmanya", "Osma" },
-		{ "Phags_Pa", "Phag" },
-		{ "Inscriptional_Pahlavi", "Phli" },
-		{ "Phoenician", "Phnx" },
-		{ "Inscriptional_Parthian", "Prti" },
-		{ "Rejang", "Rjng" },
-		{ "Runic", "Runr" },
-		{ "Samaritan", "Samr" },
-		{ "Old_South_Arabian", "Sarb" },
-		{ "Saurashtra", "Saur" },
-		{ "Shavian", "Shaw" },
-		{ "Sinhala", "Sinh" },
-		{ "Sundanese", "Sund" },
-		{ "Syloti_Nagri", "Sylo" },
-		{ "Syriac", "Syrc" },
-		{ "Tagbanwa", "Tagb" },
-		{ "Tai_Le", "Tale" },
-		{ "New_Tai_Lue", "Talu" },
-		{ "Tamil", "Taml" },
-		{ "Tai_Viet", "Tavt" },
-		{ "Telugu", "Telu" },
-		{ "Tifinagh", "Tfng" },
-		{ "Tagalog", "Tglg" },
-		{ "Thaana", "Thaa" },
-		{ "Thai", "Thai" },
-		{ "Tibetan", "Tibt" },
-		{ "Ugaritic", "Ugar" },
-		{ "Vai", "Vaii" },
-		{ "Old_Persian", "Xpeo" },
-		{ "Cuneiform", "Xsux" },
-		{ "Yi", "Yiii" },
-		{ "Inherited", "Zinh" },
-		{ "Common", "Zyyy" },
-		{ "Unknown", "Zzzz" },
-	};
-	gsize i;
+static void
+lt_tag_writer_init(lt_tag_writer_t *writer,
+		   GString         *string,
+		   gchar           *buffer,
+		   gsize            size)
+{
+	writer->string = string;
+	writer->buffer = buffer;
+	writer->size = size;
+	writer->length = 0;
+	writer->hash = 5381;
+	if (buffer && size > 0)
+		buffer[0] = 0;
+}
 
-	if (modifier) {
-		/*
-		 * Special case this one. The script is definitely Latin
-		 * and not Cyrillic. But lets bubble the transliteration scheme
-		 * through another layer with return 0
-		 */
-		if (g_ascii_strcasecmp(modifier, "iqtelif") == 0) {
-			_lt_tag_convert_script_from_locale_modifier("Latin", ret);
-			return FALSE;
-		}
-		for (i = 0; i < sizeof (maps) / sizeof (gchar *[2]); i++) {
-			if (g_ascii_strcasecmp(modifier, maps[i][0]) == 0) {
-				*ret = maps[i][1];
-				return TRUE;
-			}
-		}
+static void
+lt_tag_writer_append(lt_tag_writer_t *writer,
+		     const gchar     *s,
+		     gsize            len)
+{
+	if (writer->string)
+		g_string_append_len(writer->string, s, len);
+	if (writer->buffer && writer->length + 1 < writer->size) {
+		gsize n = MIN (len, writer->size - writer->length - 1);
+
+		memcpy(&writer->buffer[writer->length], s, n);
+		writer->buffer[writer->length + n] = 0;
 	}
+	writer->hash = lt_strcase_hash_update(writer->hash, s, len);
+	writer->length += len;
+}
 
-	return FALSE;
+static void
+lt_tag_writer_append_subtag(lt_tag_writer_t *writer,
+			    const gchar     *s)
+{
+	if (writer->length > 0)
+		lt_tag_writer_append(writer, "-", 1);
+	lt_tag_writer_append(writer, s, strlen(s));
 }
 
-/*
- * Occasionally (ca_ES@valencia) some modifiers indicate a language variant
- * See http://www.iana.org/assignments/language-subtag-registry
- * for IANA language subtag assignments output codes
+/* Look up the redundant registry for the longest prefix of @tag
+ * without generating the tag string for every truncated tag.
  */
-static gboolean
-_lt_tag_convert_variant_from_locale_modifier(const gchar  *modifier,
-					     const gchar **ret)
+static lt_redundant_t *
+_lt_tag_lookup_redundant(const lt_tag_t    *tag,
+			 lt_redundant_db_t *rdb)
 {
-	/* XXx: think about how to get rid of the hardcoded mapping table */
-	static const gchar * const maps[][2] = {
-            { "valencia", "valencia" }
-	};
-	gsize i;
+	gchar buffer[LT_TAG_WRITER_BUFSIZE];
+	gsize ends[LT_TAG_WRITER_MAX_SUBTAGS];
+	gint i, n = 0;
+	lt_tag_writer_t writer;
+	const GList *l;
+	lt_redundant_t *retval = NULL;
+
+	if (!tag->language)
+		return NULL;
 
-	if (modifier) {
-		for (i = 0; i < sizeof (maps) / sizeof (gchar *[2]); i++) {
-			if (g_ascii_strcasecmp(modifier, maps[i][0]) == 0) {
-				*ret = maps[i][1];
-				return TRUE;
-			}
+	lt_tag_writer_init(&writer, NULL, buffer, sizeof (buffer));
+#define _append(_s_)							\
+	G_STMT_START {							\
+		lt_tag_writer_append_subtag(&writer, (_s_));		\
+		if (writer.length >= sizeof (buffer) ||			\
+		    n >= LT_TAG_WRITER_MAX_SUBTAGS)			\
+			goto lookup;					\
+		ends[n++] = writer.length;				\
+	} G_STMT_END
+	_append (lt_lang_get_tag(tag->language));
+	if (tag->extlang)
+		_append (lt_extlang_get_tag(tag->extlang));
+	if (tag->script)
+		_append (lt_script_get_tag(tag->script));
+	if (tag->region)
+		_append (lt_region_get_tag(tag->region));
+	for (l = tag->variants; l != NULL; l = g_list_next(l)) {
+		_append (lt_variant_get_tag(l->data));
+	}
+#undef _append
+  lookup:
+	for (i = n - 1; i >= 0 && !retval; i--) {
+		buffer[ends[i]] = 0;
+		retval = lt_redundant_db_lookup(rdb, buffer);
+	}
+
+	return retval;
+}
+
+static gboolean
+_lt_tag_write_canonical(const lt_tag_t   *tag,
+			lt_tag_writer_t  *writer,
+			GError          **error)
+{
+	GError *err = NULL;
+	lt_redundant_db_t *rdb;
+	lt_redundant_t *r;
+	lt_tag_t *ctag = NULL;
+	const GList *l, *start;
+	lt_db_snapshot_t *pinned = lt_db_pin_snapshot();
+
+	if (tag->grandfathered) {
+		lt_tag_writer_append_subtag(writer, lt_grandfathered_get_better_tag(tag->grandfathered));
+		goto bail;
+	}
+
+	rdb = lt_db_get_redundant();
+	r = _lt_tag_lookup_redundant(tag, rdb);
+	lt_redundant_db_unref(rdb);
+	if (r) {
+		const gchar *preferred = lt_redundant_get_preferred_tag(r);
+
+		if (preferred) {
+			lt_tag_t *rtag = lt_tag_new();
+			lt_tag_t *ntag = lt_tag_new();
+
+			if (lt_tag_parse(rtag, lt_redundant_get_tag(r), &err) &&
+			    lt_tag_parse(ntag, preferred, &err)) {
+				/* don't touch the original tag */
+				ctag = lt_tag_copy(tag);
+				lt_tag_unshare(ctag);
+				_lt_tag_subtract(ctag, rtag);
+				_lt_tag_replace(ctag, ntag);
+				tag = ctag;
+			}
+			lt_tag_unref(rtag);
+			lt_tag_unref(ntag);
+		}
+		lt_redundant_unref(r);
+		if (err)
+			goto bail;
+	}
+
+	if (tag->language) {
+		const gchar *preferred = NULL;
+
+		if (tag->extlang)
+			preferred = lt_extlang_get_preferred_tag(tag->extlang);
+		if (preferred) {
+			lt_tag_writer_append_subtag(writer, preferred);
+		} else {
+			lt_extlang_db_t *edb = lt_db_get_extlang();
+			lt_extlang_t *e;
+
+			/* If the language tag starts with a primary language subtag
+			 * that is also an extlang subtag, then the language tag is
+			 * prepended with the extlang's 'Prefix'.
+			 */
+			e = lt_extlang_db_lookup(edb, lt_lang_get_better_tag(tag->language));
+			if (e) {
+				const gchar *prefix = lt_extlang_get_prefix(e);
+
+				if (prefix)
+					lt_tag_writer_append_subtag(writer, prefix);
+				lt_extlang_unref(e);
+			}
+			lt_extlang_db_unref(edb);
+
+			lt_tag_writer_append_subtag(writer, lt_lang_get_better_tag(tag->language));
+			if (tag->extlang)
+				lt_tag_writer_append_subtag(writer, lt_extlang_get_tag(tag->extlang));
+		}
+		if (tag->script) {
+			const gchar *script = lt_script_get_tag(tag->script);
+			const gchar *suppress = lt_lang_get_suppress_script(tag->language);
+
+			if (!suppress ||
+			    g_ascii_strcasecmp(suppress, script))
+				lt_tag_writer_append_subtag(writer, script);
+		}
+		if (tag->region) {
+			lt_tag_writer_append_subtag(writer, lt_region_get_better_tag(tag->region));
+		}
+		/* ignore all of variants prior to the last one being replaced */
+		start = tag->variants;
+		for (l = tag->variants; l != NULL; l = g_list_next(l)) {
+			const gchar *better = lt_variant_get_better_tag(l->data);
+
+			if (better && g_ascii_strcasecmp(lt_variant_get_tag(l->data), better) != 0)
+				start = l;
+		}
+		for (l = start; l != NULL; l = g_list_next(l)) {
+			const gchar *better = lt_variant_get_better_tag(l->data);
+
+			lt_tag_writer_append_subtag(writer, better ? better : lt_variant_get_tag(l->data));
+		}
+		if (tag->extension) {
+			gchar *s = lt_extension_get_canonicalized_tag((lt_extension_t *)tag->extension);
+
+			lt_tag_writer_append_subtag(writer, s);
+			g_free(s);
+		}
+	}
+	if (tag->privateuse && tag->privateuse->len > 0) {
+		lt_tag_writer_append_subtag(writer, tag->privateuse->str);
+	}
+	if (writer->length == 0) {
+		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
+			    "No tag to convert.");
+	}
+  bail:
+	if (ctag)
+		lt_tag_unref(ctag);
+	lt_db_unpin_snapshot(pinned);
+	if (err) {
+		g_propagate_error(error, err);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+_lt_tag_write_string(const lt_tag_t  *tag,
+		     lt_tag_writer_t *writer)
+{
+	const GList *l;
+
+	if (tag->tag_string) {
+		lt_tag_writer_append(writer, tag->tag_string->str, tag->tag_string->len);
+	} else if (tag->grandfathered) {
+		lt_tag_writer_append_subtag(writer, lt_grandfathered_get_tag(tag->grandfathered));
+	} else if (tag->language) {
+		lt_tag_writer_append_subtag(writer, lt_lang_get_tag(tag->language));
+		if (tag->extlang)
+			lt_tag_writer_append_subtag(writer, lt_extlang_get_tag(tag->extlang));
+		if (tag->script)
+			lt_tag_writer_append_subtag(writer, lt_script_get_tag(tag->script));
+		if (tag->region)
+			lt_tag_writer_append_subtag(writer, lt_region_get_tag(tag->region));
+		for (l = tag->variants; l != NULL; l = g_list_next(l)) {
+			lt_tag_writer_append_subtag(writer, lt_variant_get_tag(l->data));
+		}
+		if (tag->extension)
+			lt_tag_writer_append_subtag(writer, lt_extension_get_tag((lt_extension_t *)tag->extension));
+		if (tag->privateuse && tag->privateuse->len > 0)
+			lt_tag_writer_append_subtag(writer, tag->privateuse->str);
+	} else if (tag->privateuse && tag->privateuse->len > 0) {
+		lt_tag_writer_append_subtag(writer, tag->privateuse->str);
+	}
+}
+
+/* Parse the canonicalized form of @tag into a new tag. */
+static lt_tag_t *
+_lt_tag_new_canonical(const lt_tag_t  *tag,
+		      GError         **error)
+{
+	gchar buffer[LT_TAG_WRITER_BUFSIZE];
+	gchar *allocated = NULL;
+	const gchar *canonical_tag;
+	lt_tag_writer_t writer;
+	lt_tag_t *retval = NULL;
+	GError *err = NULL;
+
+	lt_tag_writer_init(&writer, NULL, buffer, sizeof (buffer));
+	if (!_lt_tag_write_canonical(tag, &writer, &err))
+		goto bail;
+	canonical_tag = buffer;
+	if (writer.length >= sizeof (buffer)) {
+		allocated = lt_tag_canonicalize((lt_tag_t *)tag, &err);
+		if (!allocated)
+			goto bail;
+		canonical_tag = allocated;
+	}
+	retval = lt_tag_new();
+	if (!lt_tag_parse(retval, canonical_tag, &err)) {
+		lt_tag_unref(retval);
+		retval = NULL;
+	}
+  bail:
+	g_free(allocated);
+	if (err)
+		g_propagate_error(error, err);
+
+	return retval;
+}
+
+static gboolean
+_lt_tag_write_locale(const lt_tag_t   *tag,
+		     lt_tag_writer_t  *writer,
+		     GError          **error)
+{
+	const gchar *language = NULL, *mod = NULL;
+	lt_tag_t *ctag = NULL;
+	lt_redundant_t *r = NULL;
+	GError *err = NULL;
+
+	/* the grandfathered tags and the redundant tags with the preferred value
+	 * are replaced with the other subtags. take them from the canonicalized
+	 * tag. otherwise the subtags in the canonicalized tag are obtained from
+	 * @tag directly in the same manner as _lt_tag_write_canonical().
+	 */
+	if (!tag->grandfathered) {
+		lt_redundant_db_t *rdb = lt_db_get_redundant();
+
+		r = _lt_tag_lookup_redundant(tag, rdb);
+		lt_redundant_db_unref(rdb);
+	}
+	if (tag->grandfathered || (r && lt_redundant_get_preferred_tag(r))) {
+		ctag = _lt_tag_new_canonical(tag, &err);
+		if (!ctag)
+			goto bail;
+		tag = ctag;
+		if (tag->language)
+			language = lt_lang_get_better_tag(tag->language);
+	}
+	if (!tag->language) {
+		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
+			    "No language subtag to convert.");
+		goto bail;
+	}
+	if (!language && tag->extlang)
+		language = lt_extlang_get_preferred_tag(tag->extlang);
+	if (language) {
+		lt_tag_writer_append_subtag(writer, language);
+	} else {
+		lt_extlang_db_t *edb = lt_db_get_extlang();
+		lt_extlang_t *e;
+
+		language = lt_lang_get_better_tag(tag->language);
+		/* the primary language that is also an extlang is written
+		 * with the extlang's 'Prefix' in the canonicalized tag.
+		 */
+		e = lt_extlang_db_lookup(edb, language);
+		if (e && lt_extlang_get_prefix(e))
+			language = lt_extlang_get_prefix(e);
+		lt_tag_writer_append_subtag(writer, language);
+		if (e)
+			lt_extlang_unref(e);
+		lt_extlang_db_unref(edb);
+	}
+	if (tag->region) {
+		const gchar *region = lt_region_get_better_tag(tag->region);
+
+		lt_tag_writer_append(writer, "_", 1);
+		lt_tag_writer_append(writer, region, strlen(region));
+	}
+	if (tag->script) {
+		const gchar *suppress = lt_lang_get_suppress_script(tag->language);
+
+		if (!suppress ||
+		    g_ascii_strcasecmp(suppress, lt_script_get_tag(tag->script)))
+			mod = lt_script_convert_to_modifier(tag->script);
+		if (mod) {
+			lt_tag_writer_append(writer, "@", 1);
+			lt_tag_writer_append(writer, mod, strlen(mod));
+		}
+	}
+  bail:
+	if (r)
+		lt_redundant_unref(r);
+	if (ctag)
+		lt_tag_unref(ctag);
+	if (err) {
+		g_propagate_error(error, err);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Finish writing into the caller's buffer. see lt_tag_get_string_to_buf(). */
+static gboolean
+lt_tag_writer_finish(lt_tag_writer_t *writer,
+		     gsize           *needed)
+{
+	if (needed)
+		*needed = writer->length + 1;
+
+	return writer->length < writer->size;
+}
+
+/* Obtain the canonicalized string of @tag into @buffer where possible.
+ * *@allocated is set if the result doesn't fit in @buffer.
+ */
+static const gchar *
+_lt_tag_get_canonical_string(const lt_tag_t  *tag,
+			     gchar           *buffer,
+			     gsize            size,
+			     gchar          **allocated)
+{
+	lt_tag_writer_t writer;
+
+	*allocated = NULL;
+	if (tag->frozen)
+		return tag->canonical_string;
+
+	lt_tag_writer_init(&writer, NULL, buffer, size);
+	if (!_lt_tag_write_canonical(tag, &writer, NULL))
+		return "";
+	if (writer.length < size)
+		return buffer;
+
+	*allocated = lt_tag_canonicalize((lt_tag_t *)tag, NULL);
+
+	return *allocated ? *allocated : "";
+}
+
+/* Set the registered subtag in the order of the canonicalized tag,
+ * as the parser does. this is used to decode the tag from subtag ids.
+ */
+static gboolean
+_lt_tag_set_indexed_subtag(lt_tag_t                      *tag,
+			   const lt_subtag_index_entry_t *entry,
+			   const gchar                   *subtag)
+{
+	gsize len = strlen(subtag);
+
+	if (!tag->language) {
+		if (!entry->lang)
+			return FALSE;
+		lt_tag_take_language(tag, lt_lang_ref(entry->lang));
+		tag->state = STATE_PRE_EXTLANG;
+	} else if (len == 3 && g_ascii_isalpha(subtag[0]) &&
+		   !tag->extlang && !tag->script && !tag->region && !tag->variants) {
+		if (!entry->extlang)
+			return FALSE;
+		lt_tag_take_extlang(tag, lt_extlang_ref(entry->extlang));
+		tag->state = STATE_PRE_SCRIPT;
+	} else if (len == 4 && g_ascii_isalpha(subtag[0]) &&
+		   !tag->script && !tag->region && !tag->variants) {
+		if (!entry->script)
+			return FALSE;
+		lt_tag_take_script(tag, lt_script_ref(entry->script));
+		tag->state = STATE_PRE_REGION;
+	} else if ((len == 2 || (len == 3 && g_ascii_isdigit(subtag[0]))) &&
+		   !tag->region && !tag->variants) {
+		if (!entry->region)
+			return FALSE;
+		lt_tag_take_region(tag, lt_region_ref(entry->region));
+		tag->state = STATE_PRE_VARIANT;
+	} else {
+		if (!entry->variant)
+			return FALSE;
+		lt_tag_take_variant(tag, lt_variant_ref(entry->variant));
+		tag->state = STATE_PRE_VARIANT;
+	}
+
+	return TRUE;
+}
+
+/* irregular grandfathered tags in RFC 5646, which don't match
+ * the langtag production.
+ */
+static const gchar * const __lt_tag_irregular_grandfathered[] = {
+	"en-GB-oed", "i-ami", "i-bnn", "i-default", "i-enochian",
+	"i-hak", "i-klingon", "i-lux", "i-mingo", "i-navajo",
+	"i-pwn", "i-tao", "i-tay", "i-tsu", "sgn-BE-FR",
+	"sgn-BE-NL", "sgn-CH-DE", NULL
+};
+
+static gboolean
+_lt_tag_check_registered_subtag(lt_tag_state_t   state,
+				const gchar     *subtag,
+				GError         **error)
+{
+	gboolean retval = FALSE;
+
+	switch (state) {
+	    case STATE_LANG:
+		    G_STMT_START {
+			    lt_lang_db_t *langdb = lt_db_get_lang();
+			    lt_lang_t *lang = lt_lang_db_lookup(langdb, subtag);
+
+			    /* validate if it's really shortest one */
+			    retval = lang && g_ascii_strcasecmp(lt_lang_get_tag(lang), subtag) == 0;
+			    lt_lang_unref(lang);
+			    lt_lang_db_unref(langdb);
+		    } G_STMT_END;
+		    break;
+	    case STATE_EXTLANG:
+		    G_STMT_START {
+			    lt_extlang_db_t *extlangdb = lt_db_get_extlang();
+			    lt_extlang_t *extlang = lt_extlang_db_lookup(extlangdb, subtag);
+
+			    retval = extlang != NULL;
+			    lt_extlang_unref(extlang);
+			    lt_extlang_db_unref(extlangdb);
+		    } G_STMT_END;
+		    break;
+	    case STATE_SCRIPT:
+		    G_STMT_START {
+			    lt_script_db_t *scriptdb = lt_db_get_script();
+			    lt_script_t *script = lt_script_db_lookup(scriptdb, subtag);
+
+			    retval = script != NULL;
+			    lt_script_unref(script);
+			    lt_script_db_unref(scriptdb);
+		    } G_STMT_END;
+		    break;
+	    case STATE_REGION:
+		    G_STMT_START {
+			    lt_region_db_t *regiondb = lt_db_get_region();
+			    lt_region_t *region = lt_region_db_lookup(regiondb, subtag);
+
+			    retval = region != NULL;
+			    lt_region_unref(region);
+			    lt_region_db_unref(regiondb);
+		    } G_STMT_END;
+		    break;
+	    case STATE_VARIANT:
+		    G_STMT_START {
+			    lt_variant_db_t *variantdb = lt_db_get_variant();
+			    lt_variant_t *variant = lt_variant_db_lookup(variantdb, subtag);
+
+			    retval = variant != NULL;
+			    lt_variant_unref(variant);
+			    lt_variant_db_unref(variantdb);
+		    } G_STMT_END;
+		    break;
+	    default:
+		    retval = TRUE;
+		    break;
+	}
+	if (!retval)
+		g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "Unknown subtag: %s", subtag);
+
+	return retval;
+}
+
+static guint
+_lt_tag_ctz64(guint64 v)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(v);
+#else
+	guint retval = 0;
+
+	while (!(v & 1)) {
+		v >>= 1;
+		retval++;
+	}
+
+	return retval;
+#endif
+}
+
+/* Check if @tag is well-formed according to the syntax in RFC 5646,
+ * with the character classes of @tag in @alpha, @digit and @hyphen if
+ * @classified is %TRUE. otherwise they are obtained per subtags.
+ * the language, extlang, script, region and variant subtags are also
+ * looked up in the registry if @check_registry is %TRUE.
+ * This doesn't create any instances of subtags.
+ */
+static gboolean
+_lt_tag_check_syntax_classified(const gchar  *tag,
+				gsize         length,
+				gboolean      check_registry,
+				gboolean      classified,
+				guint64       alpha,
+				guint64       digit,
+				guint64       hyphen,
+				GError      **error)
+{
+	lt_tag_state_t state = STATE_LANG, type;
+	gsize pos = 0, len;
+	gchar subtag[LT_TAG_GRANDFATHERED_MAX];
+	gint i, n_extlang = 0;
+
+	if (length == 0) {
+		g_set_error(error, LT_ERROR, LT_ERR_NO_TAG,
+			    "No tag to validate.");
+		return FALSE;
+	}
+	if (length < LT_TAG_GRANDFATHERED_MAX) {
+		memcpy(subtag, tag, length);
+		subtag[length] = 0;
+		if (check_registry) {
+			lt_grandfathered_db_t *grandfathereddb = lt_db_get_grandfathered();
+			lt_grandfathered_t *grandfathered = lt_grandfathered_db_lookup(grandfathereddb, subtag);
+
+			lt_grandfathered_db_unref(grandfathereddb);
+			if (grandfathered) {
+				lt_grandfathered_unref(grandfathered);
+				return TRUE;
+			}
+		} else {
+			for (i = 0; __lt_tag_irregular_grandfathered[i] != NULL; i++) {
+				if (g_ascii_strcasecmp(subtag, __lt_tag_irregular_grandfathered[i]) == 0)
+					return TRUE;
+			}
+		}
+	}
+	if (!classified && length <= LT_ASCII_CLASSIFY_MAX) {
+		for (len = 0; len < length; len++) {
+			if (!g_ascii_isalnum(tag[len]) && tag[len] != '-')
+				break;
+		}
+		g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "Invalid character for tag: '%c'", tag[len]);
+		return FALSE;
+	}
+	/* @state is the subtag expected at next */
+	for (; pos <= length; pos += len + 1) {
+		const gchar *p = &tag[pos];
+		gboolean is_alpha, is_digit;
+
+		if (classified) {
+			guint64 m = pos < length ? hyphen >> pos : 0;
+
+			len = m ? _lt_tag_ctz64(m) : length - pos;
+		} else {
+			for (len = 0; pos + len < length && p[len] != '-'; len++) {
+				if (!g_ascii_isalnum(p[len])) {
+					g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+						    "Invalid character for tag: '%c'", p[len]);
+					return FALSE;
+				}
+			}
+		}
+		if (len == 0 || len > 8) {
+			g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+				    "Invalid length of subtag at %" G_GSIZE_FORMAT,
+				    pos);
+			return FALSE;
+		}
+		if (classified) {
+			guint64 m = ((G_GUINT64_CONSTANT (1) << len) - 1) << pos;
+
+			is_alpha = (alpha & m) == m;
+			is_digit = (digit & m) == m;
+		} else {
+			is_alpha = _lt_tag_is_alpha_len(p, len);
+			is_digit = _lt_tag_is_digit_len(p, len);
+		}
+		if (state == STATE_PRIVATEUSE ||
+		    state == STATE_PRIVATEUSETOKEN) {
+			state = STATE_PRIVATEUSETOKEN;
+			continue;
+		}
+		if (len == 1) {
+			/* a singleton has to be followed by its subtag */
+			if (state == STATE_EXTENSION)
+				goto invalid;
+			if (g_ascii_tolower(p[0]) == 'x') {
+				state = STATE_PRIVATEUSE;
+				continue;
+			}
+			if (state == STATE_LANG)
+				goto invalid;
+			state = STATE_EXTENSION;
+			continue;
+		}
+		if (state == STATE_EXTENSION ||
+		    state == STATE_EXTENSIONTOKEN) {
+			state = STATE_EXTENSIONTOKEN;
+			continue;
+		}
+		if (state == STATE_LANG) {
+			if (!is_alpha)
+				goto invalid;
+			type = STATE_LANG;
+			state = len <= 3 ? STATE_EXTLANG : STATE_SCRIPT;
+		} else if (state == STATE_EXTLANG && len == 3 &&
+			   is_alpha && n_extlang < 3) {
+			type = STATE_EXTLANG;
+			n_extlang++;
+		} else if (state <= STATE_SCRIPT && len == 4 && is_alpha) {
+			type = STATE_SCRIPT;
+			state = STATE_REGION;
+		} else if (state <= STATE_REGION &&
+			   ((len == 2 && is_alpha) || (len == 3 && is_digit))) {
+			type = STATE_REGION;
+			state = STATE_VARIANT;
+		} else if (state <= STATE_VARIANT &&
+			   (len >= 5 || (len == 4 && g_ascii_isdigit(p[0])))) {
+			type = STATE_VARIANT;
+			state = STATE_VARIANT;
+		} else {
+		  invalid:
+			g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+				    "Invalid subtag: %.*s", (gint)len, p);
+			return FALSE;
+		}
+		if (check_registry) {
+			memcpy(subtag, p, len);
+			subtag[len] = 0;
+			if (!_lt_tag_check_registered_subtag(type, subtag, error))
+				return FALSE;
+		}
+	}
+	if (state == STATE_EXTENSION ||
+	    state == STATE_PRIVATEUSE) {
+		g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "No subtags after the singleton.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+_lt_tag_check_syntax(const gchar  *tag,
+		     gsize         length,
+		     gboolean      check_registry,
+		     GError      **error)
+{
+	guint64 alpha = 0, digit = 0, hyphen = 0;
+	gboolean classified;
+
+	/* the character classes are obtained at once for most of tags.
+	 * the long tags are classified per subtags.
+	 */
+	classified = lt_ascii_classify(tag, length, &alpha, &digit, &hyphen);
+
+	return _lt_tag_check_syntax_classified(tag, length, check_registry,
+					       classified, alpha, digit, hyphen,
+					       error);
+}
+
+/* borrowed the modifier related code from localehelper:
+ * http://people.redhat.com/caolanm/BCP47/localehelper-1.0.0.tar.gz
+ */
+typedef struct _lt_tag_locale_modifier_t {
+	const gchar *modifier;
+	const gchar *script;
+	const gchar *variant;
+	const gchar *privateuse;
+} lt_tag_locale_modifier_t;
+
+/*
+ * glibc typically uses these modifiers to indicate particular
+ * scripts that the language is written in
+ * See ISO-15924 http://unicode.org/iso15924/iso15924-codes.html
+ *
+ * Occasionally (ca_ES@valencia) some modifiers indicate a language variant
+ * See http://www.iana.org/assignments/language-subtag-registry
+ * for IANA language subtag assignments output codes
+ *
+ * The rest is mapped to the private use subtags or ignored:
+ *
+ * "euro": Old mechanism to denote that the euro currency is in use,
+ * ignore it.
+ *
+ * "cjknarrow": A modifier that indicates what width to assign to an
+ * ambiguous width char, ignore it.
+ * http://www.mail-archive.com/cygwin@cygwin.com/msg97848.html
+ * http://unicode.org/reports/tr11/
+ *
+ * "abegede": Abegede Collation for Ge'ez (as opposed to Halehame,
+ * I believe). http://www.geez.org/Collation/
+ * http://www.iana.org/assignments/language-subtag-registry has
+ * nothing to describe it, so using a private code.
+ * http://tools.ietf.org/html/draft-davis-u-langtag-ext-01
+ * http://www.unicode.org/reports/tr35/ maybe u-co-something some day
+ *
+ * "iqtelif": Latin orthography. The script is definitely Latin and not
+ * Cyrillic, and the transliteration scheme is bubbled through
+ * the private use.
+ * http://www.alvestrand.no/pipermail/ietf-languages/2006-September/005017.html
+ *
+ * XXX: think about how to get rid of the hardcoded mapping table.
+ * This has to be sorted by g_ascii_strcasecmp() for the binary search.
+ */
+static const lt_tag_locale_modifier_t __lt_tag_locale_modifiers[] = {
+	{ "abegede", NULL, NULL, "abegede" },
+	{ "Arabic", "Arab", NULL, NULL },
+	{ "Armenian", "Armn", NULL, NULL },
+	{ "Avestan", "Avst", NULL, NULL },
+	{ "Balinese", "Bali", NULL, NULL },
+	{ "Bamum", "Bamu", NULL, NULL },
+	{ "Bengali", "Beng", NULL, NULL },
+	{ "Bopomofo", "Bopo", NULL, NULL },
+	{ "Braille", "Brai", NULL, NULL },
+	{ "Buginese", "Bugi", NULL, NULL },
+	{ "Buhid", "Buhd", NULL, NULL },
+	{ "Canadian_Aboriginal", "Cans", NULL, NULL },
+	{ "Carian", "Cari", NULL, NULL },
+	{ "Cham", "Cham", NULL, NULL },
+	{ "Cherokee", "Cher", NULL, NULL },
+	{ "cjknarrow", NULL, NULL, NULL },
+	{ "Common", "Zyyy", NULL, NULL },
+	{ "Coptic", "Copt", NULL, NULL },
+	{ "Cuneiform", "Xsux", NULL, NULL },
+	{ "Cypriot", "Cprt", NULL, NULL },
+	{ "Cyrillic", "Cyrl", NULL, NULL },
+	{ "Deseret", "Dsrt", NULL, NULL },
+	{ "Devanagari", "Deva", NULL, NULL },
+	{ "Egyptian_Hierogyphs", "Egyp", NULL, NULL },
+	{ "Ethiopic", "Ethi", NULL, NULL },
+	{ "euro", NULL, NULL, NULL },
+	{ "Georgian", "Geor", NULL, NULL },
+	{ "Glagolitic", "Glag", NULL, NULL },
+	{ "Gothic", "Goth", NULL, NULL },
+	{ "Greek", "Grek", NULL, NULL },
+	{ "Gujarati", "Gujr", NULL, NULL },
+	{ "Gurmukhi", "Guru", NULL, NULL },
+	{ "Han", "Hani", NULL, NULL },
+	{ "Hangul", "Hang", NULL, NULL },
+	{ "Hanunoo", "Hano", NULL, NULL },
+	{ "Hebrew", "Hebr", NULL, NULL },
+	{ "Hiragana", "Hira", NULL, NULL },
+	{ "Imperial_Aramaic", "Armi", NULL, NULL },
+	{ "Inherited", "Zinh", NULL, NULL },
+	{ "Inscriptional_Pahlavi", "Phli", NULL, NULL },
+	{ "Inscriptional_Parthian", "Prti", NULL, NULL },
+	{ "iqtelif", "Latn", NULL, "iqtel" },
+	{ "Javanese", "Java", NULL, NULL },
+	{ "Kaithi", "Kthi", NULL, NULL },
+	{ "Kannada", "Knda", NULL, NULL },
+	{ "Katakana", "Kana", NULL, NULL },
+	{ "Katakana_Or_Hiragana", "Hrkt", NULL, NULL },
+	{ "Kayah_Li", "Kali", NULL, NULL },
+	{ "Kharoshthi", "Khar", NULL, NULL },
+	{ "Khmer", "Khmr", NULL, NULL },
+	{ "Lao", "Laoo", NULL, NULL },
+	{ "Latin", "Latn", NULL, NULL },
+	{ "Lepcha", "Lepc", NULL, NULL },
+	{ "Limbu", "Limb", NULL, NULL },
+	{ "Linear_B", "Linb", NULL, NULL },
+	{ "Lisu", "Lisu", NULL, NULL },
+	{ "Lycian", "Lyci", NULL, NULL },
+	{ "Lydian", "Lydi", NULL, NULL },
+	{ "Malayalam", "Mlym", NULL, NULL },
+	{ "Meetei_Mayek", "Mtei", NULL, NULL },
+	{ "Mongolian", "Mong", NULL, NULL },
+	{ "Myanmar", "Mymr", NULL, NULL },
+	{ "New_Tai_Lue", "Talu", NULL, NULL },
+	{ "Nko", "Nkoo", NULL, NULL },
+	{ "Ogham", "Ogam", NULL, NULL },
+	{ "Ol_Chiki", "Olck", NULL, NULL },
+	{ "Old_Italic", "Ital", NULL, NULL },
+	{ "Old_Persian", "Xpeo", NULL, NULL },
+	{ "Old_South_Arabian", "Sarb", NULL, NULL },
+	{ "Old_Turkic", "Orkh", NULL, NULL },
+	{ "Oriya", "Orya", NULL, NULL },
+	{ "Osmanya", "Osma", NULL, NULL },
+	{ "Phags_Pa", "Phag", NULL, NULL },
+	{ "Phoenician", "Phnx", NULL, NULL },
+	{ "Rejang", "Rjng", NULL, NULL },
+	{ "Runic", "Runr", NULL, NULL },
+	{ "Samaritan", "Samr", NULL, NULL },
+	{ "Saurashtra", "Saur", NULL, NULL },
+	{ "Shavian", "Shaw", NULL, NULL },
+	{ "Sinhala", "Sinh", NULL, NULL },
+	{ "Sundanese", "Sund", NULL, NULL },
+	{ "Syloti_Nagri", "Sylo", NULL, NULL },
+	{ "Syriac", "Syrc", NULL, NULL },
+	{ "Tagalog", "Tglg", NULL, NULL },
+	{ "Tagbanwa", "Tagb", NULL, NULL },
+	{ "Tai_Le", "Tale", NULL, NULL },
+	{ "Tai_Tham", "Lana", NULL, NULL },
+	{ "Tai_Viet", "Tavt", NULL, NULL },
+	{ "Tamil", "Taml", NULL, NULL },
+	{ "Telugu", "Telu", NULL, NULL },
+	{ "Thaana", "Thaa", NULL, NULL },
+	{ "Thai", "Thai", NULL, NULL },
+	{ "Tibetan", "Tibt", NULL, NULL },
+	{ "Tifinagh", "Tfng", NULL, NULL },
+	{ "Ugaritic", "Ugar", NULL, NULL },
+	{ "Unknown", "Zzzz", NULL, NULL },
+	{ "Vai", "Vaii", NULL, NULL },
+	{ "valencia", NULL, "valencia", NULL },
+	{ "Yi", "Yiii", NULL, NULL },
+};
+
+static const lt_tag_locale_modifier_t *
+_lt_tag_lookup_locale_modifier(const gchar *modifier)
+{
+	return bsearch(modifier, __lt_tag_locale_modifiers,
+		       G_N_ELEMENTS (__lt_tag_locale_modifiers),
+		       sizeof (lt_tag_locale_modifier_t),
+		       _lt_tag_strcase_entry_compare);
+}
+
+/* Append the hyphen-separated @subtags to the private use subtags. */
+static gboolean
+_lt_tag_add_privateuse(lt_tag_t     *tag,
+		       const gchar  *subtags,
+		       GError      **error)
+{
+	const gchar *p = subtags;
+	gsize len;
+
+	while (TRUE) {
+		for (len = 0; g_ascii_isalnum(p[len]); len++);
+		if (len == 0 || len > 8 || (p[len] != '-' && p[len] != 0)) {
+			g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+				    "Invalid tag for the private use: token = '%s'",
+				    p);
+			return FALSE;
+		}
+		g_string_append_c(tag->privateuse, '-');
+		g_string_append_len(tag->privateuse, p, len);
+		lt_tag_add_tag_string_len(tag, p, len);
+		if (p[len] == 0)
+			break;
+		p += len + 1;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Fill in @tag with the fields of the locale which has been split
+ * already. the subtags are looked up directly and no tag string is
+ * parsed.
+ */
+static gboolean
+_lt_tag_fill_from_locale(lt_tag_t                       *tag,
+			 const gchar                    *language,
+			 const gchar                    *territory,
+			 const gchar                    *codeset,
+			 const lt_tag_locale_modifier_t *modifier,
+			 const gchar                    *privateuse,
+			 GError                        **error)
+{
+	gsize len = strlen(language);
+	lt_lang_db_t *langdb;
+	lt_lang_t *lang;
+
+	if (len < 2 || len > 3 || !_lt_tag_is_alpha_len(language, len)) {
+		g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "Invalid language subtag: %s", language);
+		return FALSE;
+	}
+	langdb = lt_db_get_lang();
+	lang = lt_lang_db_lookup(langdb, language);
+	lt_lang_db_unref(langdb);
+	/* validate if it's really shortest one */
+	if (!lang || g_ascii_strcasecmp(lt_lang_get_tag(lang), language) != 0) {
+		g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "Unknown ISO 639 code: %s", language);
+		lt_lang_unref(lang);
+		return FALSE;
+	}
+	tag->language = lang;
+	lt_mem_add_ref(tag->storage, tag->language,
+		       (lt_destroy_func_t)lt_lang_unref);
+	lt_tag_add_tag_string(tag, language);
+	tag->state = STATE_PRE_EXTLANG;
+
+	if (modifier && modifier->script) {
+		lt_script_db_t *scriptdb = lt_db_get_script();
+
+		lt_tag_take_script(tag, lt_script_db_lookup(scriptdb, modifier->script));
+		lt_script_db_unref(scriptdb);
+		if (!tag->script) {
+			g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+				    "Unknown script: %s", modifier->script);
+			return FALSE;
+		}
+		lt_tag_add_tag_string(tag, modifier->script);
+		tag->state = STATE_PRE_REGION;
+	}
+	if (territory) {
+		lt_region_db_t *regiondb;
+
+		len = strlen(territory);
+		if ((len == 2 && _lt_tag_is_alpha_len(territory, len)) ||
+		    (len == 3 && _lt_tag_is_digit_len(territory, len))) {
+			regiondb = lt_db_get_region();
+			lt_tag_take_region(tag, lt_region_db_lookup(regiondb, territory));
+			lt_region_db_unref(regiondb);
+		}
+		if (!tag->region) {
+			g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+				    "Unknown region: %s", territory);
+			return FALSE;
+		}
+		lt_tag_add_tag_string(tag, territory);
+		tag->state = STATE_PRE_VARIANT;
+	}
+	if (modifier && modifier->variant) {
+		lt_variant_db_t *variantdb = lt_db_get_variant();
+		lt_variant_t *variant;
+
+		variant = lt_variant_db_lookup(variantdb, modifier->variant);
+		lt_variant_db_unref(variantdb);
+		if (!variant) {
+			g_set_error(error, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+				    "Unknown variant: %s", modifier->variant);
+			return FALSE;
+		}
+		if (!lt_tag_parse_variant(tag, variant, modifier->variant, error))
+			return FALSE;
+		lt_tag_add_tag_string(tag, modifier->variant);
+	}
+	if (codeset || privateuse) {
+		g_string_append_c(tag->privateuse, 'x');
+		lt_tag_add_tag_string(tag, "x");
+		if (codeset &&
+		    (!_lt_tag_add_privateuse(tag, "codeset", error) ||
+		     !_lt_tag_add_privateuse(tag, codeset, error)))
+			return FALSE;
+		if (privateuse &&
+		    !_lt_tag_add_privateuse(tag, privateuse, error))
+			return FALSE;
+		tag->state = STATE_IN_PRIVATEUSETOKEN;
+	}
+
+	return TRUE;
+}
+
+static lt_tag_t *
+_lt_tag_convert_from_locale_string(const gchar  *locale,
+				   GError      **error)
+{
+	gchar buffer[LT_TAG_WRITER_BUFSIZE];
+	gchar *s = NULL, *territory, *codeset, *modifier;
+	gsize len;
+	lt_tag_t *tag;
+	GError *err = NULL;
+
+	tag = lt_tag_new();
+	if (!locale || locale[0] == 0 ||
+	    g_strcmp0(locale, "C") == 0 ||
+	    g_strcmp0(locale, "POSIX") == 0) {
+		if (!lt_tag_parse(tag, "en-US-u-va-posix", &err))
+			goto bail;
+	} else {
+		const lt_tag_locale_modifier_t *m = NULL;
+		const gchar *privateuse = NULL;
+
+		/* split the locale in the stack buffer unless it's too long */
+		len = strlen(locale);
+		if (len < sizeof (buffer))
+			s = memcpy(buffer, locale, len + 1);
+		else
+			s = g_strdup(locale);
+		modifier = strchr(s, '@');
+		if (modifier) {
+			*modifier = 0;
+			modifier++;
+		}
+		codeset = strchr(s, '.');
+		if (codeset) {
+			*codeset = 0;
+			codeset++;
+		}
+		territory = strchr(s, '_');
+		if (territory) {
+			*territory = 0;
+			territory++;
+		}
+		if (codeset &&
+		    (g_ascii_strcasecmp(codeset, "utf-8") == 0 ||
+		     g_ascii_strcasecmp(codeset, "utf8") == 0)) {
+			codeset = NULL;
+		}
+		/* check if the language is a locale alias */
+		if (strlen(s) > 3 &&
+		    !territory &&
+		    !codeset &&
+		    !modifier) {
+			const gchar *loc = lt_tag_get_locale_from_locale_alias(s);
+			lt_tag_t *t;
+
+			if (loc && (t = _lt_tag_convert_from_locale_string(loc, &err)) != NULL) {
+				lt_tag_unref(tag);
+				tag = t;
+				goto bail;
+			}
+		}
+		if (modifier) {
+			m = _lt_tag_lookup_locale_modifier(modifier);
+			if (m) {
+				privateuse = m->privateuse;
+			} else {
+				g_warning("Unknown modifiers: %s", modifier);
+				privateuse = modifier;
+			}
+		}
+		_lt_tag_fill_from_locale(tag, s, territory, codeset, m, privateuse, &err);
+	}
+
+  bail:
+	if (s != buffer)
+		g_free(s);
+
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		lt_tag_unref(tag);
+		tag = NULL;
+	}
+
+	return tag;
+}
+
+static void
+_lt_tag_locale_cache_free(gpointer data)
+{
+	lt_tag_locale_cache_t *cache = data;
+
+	lt_tag_unref(cache->tag);
+	g_free(cache->locale);
+	g_free(cache);
+}
+
+static GPrivate __lt_tag_locale_cache = G_PRIVATE_INIT (_lt_tag_locale_cache_free);
+
+/* The locale name for LC_CTYPE in the calling thread.
+ * setlocale() only tells the global locale, whereas nl_langinfo()
+ * follows the one set by uselocale() where it's available.
+ */
+static const gchar *
+_lt_tag_get_thread_locale_name(void)
+{
+	const gchar *locale;
+
+#if defined (HAVE_LANGINFO_H) && defined (_NL_LOCALE_NAME)
+	locale = nl_langinfo(_NL_LOCALE_NAME (LC_CTYPE));
+	if (locale && locale[0] != 0)
+		return locale;
+#endif
+	locale = setlocale(LC_CTYPE, NULL);
+	if (!locale)
+		locale = setlocale(LC_ALL, NULL);
+
+	return locale;
+}
+
+/*< protected >*/
+lt_tag_state_t
+lt_tag_parse_wildcard(lt_tag_t     *tag,
+		      const gchar  *tag_string,
+		      gssize        length,
+		      GError      **error)
+{
+	GError *err = NULL;
+	gboolean ret;
+
+	lt_tag_parser_init(tag);
+	ret = _lt_tag_parse(tag, tag_string, length, TRUE, &err);
+
+	if (!ret && !err) {
+		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
+			    "Unknown error during parsing a tag.");
+	}
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+	}
+
+	return tag->state;
+}
+
+void
+lt_tag_intern_clear(void)
+{
+	G_LOCK (lt_tag_intern);
+
+	/* the tags being parsed against the previous databases aren't added */
+	g_atomic_int_inc(&__lt_tag_intern_serial);
+	if (__lt_tag_intern_aliases) {
+		g_hash_table_destroy(__lt_tag_intern_aliases);
+		__lt_tag_intern_aliases = NULL;
+	}
+	if (__lt_tag_intern_table) {
+		g_hash_table_destroy(__lt_tag_intern_table);
+		__lt_tag_intern_table = NULL;
+	}
+
+	G_UNLOCK (lt_tag_intern);
+}
+
+void
+lt_tag_parser_clear(void)
+{
+	G_LOCK (lt_tag_dfa);
+
+	lt_tag_dfa_unref(__lt_tag_dfa);
+	__lt_tag_dfa = NULL;
+
+	G_UNLOCK (lt_tag_dfa);
+}
+
+void
+lt_tag_locale_cache_clear(void)
+{
+	/* the caches in the threads are invalidated at the next use */
+	g_atomic_int_inc(&__lt_tag_locale_serial);
+}
+
+/*< public >*/
+/**
+ * lt_tag_set_parser:
+ * @parser: a #lt_tag_parser_t.
+ *
+ * Choose the engine used in lt_tag_parse() and its friends.
+ * %LT_TAG_PARSER_DFA compiles the whole of the registry into an automaton
+ * at the first use, which takes some memory and time, but the subtags are
+ * identified in a single pass then. The extensions and the private use
+ * subtags are still parsed with the state machine.
+ */
+void
+lt_tag_set_parser(lt_tag_parser_t parser)
+{
+	g_return_if_fail (parser >= LT_TAG_PARSER_DEFAULT &&
+			  parser <= LT_TAG_PARSER_DFA);
+
+	g_atomic_int_set(&__lt_tag_parser, parser);
+	if (parser != LT_TAG_PARSER_DFA)
+		lt_tag_parser_clear();
+}
+
+/**
+ * lt_tag_get_parser:
+ *
+ * Obtain the engine used in lt_tag_parse().
+ *
+ * Returns: a #lt_tag_parser_t.
+ */
+lt_tag_parser_t
+lt_tag_get_parser(void)
+{
+	return g_atomic_int_get(&__lt_tag_parser);
+}
+
+/**
+ * lt_tag_new:
+ *
+ * Create a new instance of #lt_tag_t.
+ *
+ * Returns: (transfer full): a new instance of #lt_tag_t.
+ */
+lt_tag_t *
+lt_tag_new(void)
+{
+	lt_tag_t *retval = lt_mem_alloc_object(sizeof (lt_tag_t));
+
+	if (retval) {
+		retval->state = STATE_NONE;
+		lt_tag_new_storage(retval);
+	}
+
+	return retval;
+}
+
+/**
+ * lt_tag_ref:
+ * @tag: a #lt_tag_t.
+ *
+ * Increases the reference count of @tag.
+ *
+ * Returns: (transfer none): the same @tag object.
+ */
+lt_tag_t *
+lt_tag_ref(lt_tag_t *tag)
+{
+	g_return_val_if_fail (tag != NULL, NULL);
+
+	return lt_mem_ref(&tag->parent);
+}
+
+/**
+ * lt_tag_unref:
+ * @tag: a #lt_tag_t.
+ *
+ * Decreases the reference count of @tag. when its reference count
+ * drops to 0, the object is finalized (i.e. its memory is freed).
+ */
+void
+lt_tag_unref(lt_tag_t *tag)
+{
+	if (tag)
+		lt_mem_unref(&tag->parent);
+}
+
+/**
+ * lt_tag_clear:
+ * @tag: a #lt_tag_t.
+ *
+ * (Re-)Initialize all of the subtag information stored in @tag.
+ */
+void
+lt_tag_clear(lt_tag_t *tag)
+{
+	g_return_if_fail (tag != NULL);
+	g_return_if_fail (!tag->frozen);
+
+	lt_tag_free_tag_string(tag);
+	if (g_atomic_int_get(&tag->storage->ref_count) > 1) {
+		/* just leave the shared subtags to others */
+		lt_tag_new_storage(tag);
+		return;
+	}
+	lt_tag_free_language(tag);
+	lt_tag_free_extlang(tag);
+	lt_tag_free_script(tag);
+	lt_tag_free_region(tag);
+	lt_tag_free_variants(tag);
+	lt_tag_free_extension(tag);
+	if (tag->privateuse) {
+		g_string_truncate(tag->privateuse, 0);
+	}
+	lt_tag_free_grandfathered(tag);
+}
+
+/**
+ * lt_tag_parse:
+ * @tag: a #lt_tag_t.
+ * @tag_string: language tag to be parsed.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Parse @tag_string and create appropriate instances for subtags.
+ *
+ * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
+ */
+gboolean
+lt_tag_parse(lt_tag_t     *tag,
+	     const gchar  *tag_string,
+	     GError      **error)
+{
+	return lt_tag_parse_len(tag, tag_string, -1, error);
+}
+
+/**
+ * lt_tag_parse_len:
+ * @tag: a #lt_tag_t.
+ * @tag_string: (array length=length): language tag to be parsed.
+ * @length: the length of @tag_string in bytes, or -1 if it's nul-terminated.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Same as lt_tag_parse() but @tag_string doesn't need to be nul-terminated.
+ * @tag_string is parsed as is without being copied.
+ *
+ * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
+ */
+gboolean
+lt_tag_parse_len(lt_tag_t     *tag,
+		 const gchar  *tag_string,
+		 gssize        length,
+		 GError      **error)
+{
+	g_return_val_if_fail (tag != NULL, FALSE);
+
+	if (_lt_tag_is_frozen_with_error(tag, error))
+		return FALSE;
+	lt_tag_parser_init(tag);
+
+	return _lt_tag_parse(tag, tag_string, length, FALSE, error);
+}
+
+/**
+ * lt_tag_validate:
+ * @tag_string: (array length=length): language tag to be validated.
+ * @length: the length of @tag_string in bytes, or -1 if it's nul-terminated.
+ * @level: a #lt_validation_level_t.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Validate @tag_string at @level without creating #lt_tag_t.
+ * %LT_VALIDATION_WELL_FORMED checks the syntax only and doesn't touch
+ * any databases. %LT_VALIDATION_VALID_SUBTAGS looks up the subtags
+ * in the registry as well, but the variant prefixes and the extensions
+ * aren't validated. %LT_VALIDATION_STRICT does the same as lt_tag_parse()
+ * with a temporary tag.
+ *
+ * Returns: %TRUE if @tag_string is valid at @level, otherwise %FALSE.
+ */
+gboolean
+lt_tag_validate(const gchar            *tag_string,
+		gssize                  length,
+		lt_validation_level_t   level,
+		GError                **error)
+{
+	GError *err = NULL;
+	gboolean retval = FALSE;
+
+	g_return_val_if_fail (tag_string != NULL, FALSE);
+
+	if (length < 0)
+		length = strlen(tag_string);
+	switch (level) {
+	    case LT_VALIDATION_WELL_FORMED:
+	    case LT_VALIDATION_VALID_SUBTAGS:
+		    retval = _lt_tag_check_syntax(tag_string, length,
+						  level == LT_VALIDATION_VALID_SUBTAGS,
+						  &err);
+		    break;
+	    case LT_VALIDATION_STRICT:
+		    G_STMT_START {
+			    lt_tag_t *tag = lt_tag_new();
+
+			    retval = lt_tag_parse_len(tag, tag_string, length, &err);
+			    lt_tag_unref(tag);
+		    } G_STMT_END;
+		    break;
+	    default:
+		    g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+				"Unknown validation level: %d", level);
+		    break;
+	}
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	return retval;
+}
+
+/**
+ * lt_tag_validate_bulk:
+ * @tag_strings: (array length=n): language tags to be validated.
+ * @lengths: (array length=n) (allow-none): the length of each tag in bytes,
+ *           or -1 if it's nul-terminated. %NULL if all tags are
+ *           nul-terminated.
+ * @n: the number of tags.
+ * @level: a #lt_validation_level_t.
+ * @results: (array length=n) (allow-none): the location to store the result
+ *           for each tag, or %NULL.
+ *
+ * Validate many tags at once. The short tags are packed together to
+ * classify their characters with SIMD instructions where available, and
+ * checked with the fast syntax checker. only the well-formed tags go on to
+ * the further validation at @level, with the databases pinned for the whole
+ * call. This is useful as a pre-filter before parsing the tags from the bulk
+ * data.
+ *
+ * Returns: the number of the valid tags.
+ */
+gsize
+lt_tag_validate_bulk(const gchar * const    *tag_strings,
+		     const gssize           *lengths,
+		     gsize                   n,
+		     lt_validation_level_t   level,
+		     gboolean               *results)
+{
+	lt_db_snapshot_t *pinned = NULL;
+	lt_tag_t *tag = NULL;
+	gsize i = 0, j, k, retval = 0;
+
+	g_return_val_if_fail (tag_strings != NULL || n == 0, 0);
+	g_return_val_if_fail (level <= LT_VALIDATION_STRICT, 0);
+
+	if (level != LT_VALIDATION_WELL_FORMED)
+		pinned = lt_db_pin_snapshot();
+	if (level == LT_VALIDATION_STRICT)
+		tag = lt_tag_new();
+	while (i < n) {
+		/* the tags are separated by nul, which isn't classified
+		 * into any classes.
+		 */
+		gchar window[LT_ASCII_CLASSIFY_MAX];
+		gsize offsets[LT_ASCII_CLASSIFY_MAX / 2], sizes[LT_ASCII_CLASSIFY_MAX / 2];
+		guint64 alpha = 0, digit = 0, hyphen = 0;
+		gsize used = 0, n_packed;
+
+		for (j = i; j < n && j - i < G_N_ELEMENTS (offsets); j++) {
+			const gchar *s = tag_strings[j];
+			gssize len = lengths ? lengths[j] : -1;
+
+			if (!s)
+				break;
+			if (len < 0)
+				len = strlen(s);
+			if (len == 0 ||
+			    (used > 0 ? used + 1 : 0) + len > LT_ASCII_CLASSIFY_MAX)
+				break;
+			if (used > 0)
+				window[used++] = 0;
+			offsets[j - i] = used;
+			sizes[j - i] = len;
+			memcpy(&window[used], s, len);
+			used += len;
+		}
+		n_packed = j - i;
+		if (n_packed > 0)
+			lt_ascii_classify(window, used, &alpha, &digit, &hyphen);
+		else
+			j = i + 1;
+		for (k = i; k < j; k++) {
+			const gchar *s = tag_strings[k];
+			gssize len;
+			gboolean valid = FALSE, classified = FALSE;
+			guint64 a = 0, d = 0, h = 0;
+
+			if (!s)
+				goto next;
+			if (k - i < n_packed) {
+				guint64 mask;
+
+				len = sizes[k - i];
+				mask = len == 64 ? G_MAXUINT64 : (G_GUINT64_CONSTANT (1) << len) - 1;
+				a = (alpha >> offsets[k - i]) & mask;
+				d = (digit >> offsets[k - i]) & mask;
+				h = (hyphen >> offsets[k - i]) & mask;
+				classified = (a | d | h) == mask;
+			} else {
+				len = lengths ? lengths[k] : -1;
+				if (len < 0)
+					len = strlen(s);
+				classified = lt_ascii_classify(s, len, &a, &d, &h);
+			}
+			valid = _lt_tag_check_syntax_classified(s, len,
+								level == LT_VALIDATION_VALID_SUBTAGS,
+								classified, a, d, h,
+								NULL);
+			if (valid && level == LT_VALIDATION_STRICT) {
+				GError *err = NULL;
+
+				lt_tag_clear(tag);
+				valid = lt_tag_parse_len(tag, s, len, &err);
+				if (err)
+					g_error_free(err);
+			}
+		  next:
+			if (valid)
+				retval++;
+			if (results)
+				results[k] = valid;
 		}
+		i = j;
 	}
+	if (tag)
+		lt_tag_unref(tag);
+	lt_db_unpin_snapshot(pinned);
+
+	return retval;
+}
+
+/**
+ * lt_tag_parse_with_extra_token:
+ * @tag: a #lt_tag_t.
+ * @tag_string: a language tag to be parsed much more.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Continue to parse a language tag with @tag_string. please use lt_tag_parse()
+ * at first.
+ *
+ * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
+ */
+gboolean
+lt_tag_parse_with_extra_token(lt_tag_t     *tag,
+			      const gchar  *tag_string,
+			      GError      **error)
+{
+	g_return_val_if_fail (tag != NULL, FALSE);
+	g_return_val_if_fail (tag->state != STATE_NONE, FALSE);
 
-	return FALSE;
+	if (_lt_tag_is_frozen_with_error(tag, error))
+		return FALSE;
+	lt_tag_unshare(tag);
+
+	return _lt_tag_parse(tag, tag_string, -1, FALSE, error);
 }
 
-static const gchar * const
-_lt_tag_convert_privaseuse_from_locale_modifier(const gchar *modifier)
+/**
+ * lt_tag_copy:
+ * @tag: a #lt_tag_t.
+ *
+ * Create a copy instance of @tag. the subtags are shared between @tag and
+ * the copy until either of them is modified, so this is a cheap operation.
+ *
+ * Returns: (transfer full): a new instance of #lt_tag_t or %NULL if fails.
+ */
+lt_tag_t *
+lt_tag_copy(const lt_tag_t *tag)
 {
-	/* XXX: think about how to get rid of the hardcoded mapping table */
-	static const gchar * const maps[][2] = {
-		/*
-		 * Old mechanism to denote that the euro currency is in use, 
-		 * ignore it.
-		 */
-		{ "euro", NULL },
-		/*
-		 * http://www.mail-archive.com/cygwin@cygwin.com/msg97848.html
-		 * 
-		 * A modifier that indicates what width to assign to an
-		 * ambiguous width char, ignore it.
-		 *
-		 * http://unicode.org/reports/tr11/
-		 */
-		{ "cjknarrow", NULL },
-		/*
-		 * http://www.geez.org/Collation/
-		 * 
-		 * Abegede Collation for Ge'ez (as opposed to Halehame, I believe)
-		 *
-		 * http://www.iana.org/assignments/language-subtag-registry has
-		 * nothing to describe it, so using a private code
-		 *
-		 * http://tools.ietf.org/html/draft-davis-u-langtag-ext-01
-		 * http://www.unicode.org/reports/tr35/ maybe u-co-something some day
-		 */
-		{ "abegede", "abegede" },
-		/*
-		 * http://www.alvestrand.no/pipermail/ietf-languages/2006-September/005017.html
-		 * 
-		 * "iqtelif" Latin orthography
-		 *
-		 * Bit of a mess really. Unsure if tt-Latn is sufficient, i.e. if this is
-		 * the default latin orghography in practice but a private code
-		 * doesn't hurt I guess
-		 */
-		{ "iqtelif", "iqtel" }
-	};
-	gsize i;
-
-	if (modifier) {
-		for (i = 0; i < sizeof (maps) / sizeof (gchar *[2]); i++) {
-			if (g_ascii_strcasecmp(modifier, maps[i][0]) == 0)
-				return maps[i][1];
-		}
+	lt_tag_t *retval;
 
-		g_warning("Unknown modifiers: %s", modifier);
+	g_return_val_if_fail (tag != NULL, NULL);
 
-		return modifier;
+	retval = lt_mem_alloc_object(sizeof (lt_tag_t));
+	if (retval) {
+		retval->wildcard_map = tag->wildcard_map;
+		retval->state = tag->state;
+		/* share the subtags until either of them is modified. */
+		lt_tag_set_storage(retval, lt_mem_ref(tag->storage));
+		retval->language = tag->language;
+		retval->extlang = tag->extlang;
+		retval->script = tag->script;
+		retval->region = tag->region;
+		retval->variants = tag->variants;
+		retval->extension = tag->extension;
+		retval->privateuse = tag->privateuse;
+		retval->grandfathered = tag->grandfathered;
 	}
 
-	return NULL;
+	return retval;
 }
 
-static lt_tag_t *
-_lt_tag_convert_from_locale_string(const gchar  *locale,
-				   GError      **error)
+/**
+ * lt_tag_truncate:
+ * @tag: a #lt_tag_t.
+ * @error: (allow-none): a #GError.
+ *
+ * Truncate the last subtag.
+ *
+ * Returns: %TRUE if a subtag was truncated, otherwise %FALSE.
+ */
+gboolean
+lt_tag_truncate(lt_tag_t  *tag,
+		GError   **error)
 {
-	gchar *s, *territory, *codeset, *modifier;
-	lt_tag_t *tag;
 	GError *err = NULL;
+	gboolean retval = TRUE;
 
-	s = g_strdup(locale);
-	tag = lt_tag_new();
-	g_print("%s\n", s);
-	if (!s || s[0] == 0 ||
-	    g_strcmp0(s, "C") == 0 ||
-	    g_strcmp0(s, "POSIX") == 0) {
-		if (!lt_tag_parse(tag, "en-US-u-va-posix", &err))
-			goto bail;
-	} else {
-		GString *tag_string;
-		const gchar *script = NULL, *variant = NULL, *privateuse = NULL;
+	g_return_val_if_fail (tag != NULL, FALSE);
 
-		modifier = strchr(s, '@');
-		if (modifier) {
-			*modifier = 0;
-			modifier++;
-		}
-		codeset = strchr(s, '.');
-		if (codeset) {
-			*codeset = 0;
-			codeset++;
-		}
-		territory = strchr(s, '_');
-		if (territory) {
-			*territory = 0;
-			territory++;
+	if (_lt_tag_is_frozen_with_error(tag, &err))
+		goto bail;
+	lt_tag_unshare(tag);
+	if (tag->grandfathered) {
+		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
+			    "Grandfathered subtag can't be truncated.");
+		goto bail;
+	}
+	while (1) {
+		if (tag->privateuse && tag->privateuse->len > 0) {
+			g_string_truncate(tag->privateuse, 0);
+			break;
 		}
-		if (codeset &&
-		    (g_ascii_strcasecmp(codeset, "utf-8") == 0 ||
-		     g_ascii_strcasecmp(codeset, "utf8") == 0)) {
-			codeset = NULL;
+		if (tag->extension) {
+			gint i;
+			gchar c;
+			gboolean has_tag = FALSE;
+
+			lt_extension_truncate(tag->extension);
+			for (i = 0; i < LT_MAX_EXT_MODULES; i++) {
+				c = lt_ext_module_singleton_int_to_char(i);
+
+				if (c == 'x')
+					continue;
+				has_tag = lt_extension_has_singleton(tag->extension, c);
+				if (has_tag)
+					break;
+			}
+			if (!has_tag) {
+				lt_tag_free_extension(tag);
+			}
+			break;
 		}
-		/* check if the language is a locale alias */
-		if (strlen(s) > 3 &&
-		    !territory &&
-		    !codeset &&
-		    !modifier) {
-			const gchar *loc = lt_tag_get_locale_from_locale_alias(s);
-			lt_tag_t *t;
+		if (tag->variants) {
+			GList *l = g_list_last(tag->variants);
+			lt_variant_t *v = l->data;
 
-			if (loc && (t = _lt_tag_convert_from_locale_string(loc, &err)) != NULL) {
-				lt_tag_unref(tag);
-				tag = t;
-				goto bail;
+			if (tag->variants == l) {
+				lt_mem_delete_ref(tag->storage, tag->variants);
+				tag->variants = g_list_delete_link(tag->variants, l);
+				if (tag->variants)
+					lt_mem_add_ref(tag->storage, tag->variants,
+						       (lt_destroy_func_t)_lt_tag_variants_list_free);
+			} else {
+				l = g_list_delete_link(l, l);
 			}
+			lt_variant_unref(v);
+			break;
 		}
-		if (!_lt_tag_convert_script_from_locale_modifier(modifier, &script))
-			if (!_lt_tag_convert_variant_from_locale_modifier(modifier, &variant))
-				privateuse = _lt_tag_convert_privaseuse_from_locale_modifier(modifier);
-
-		tag_string = g_string_new(s);
-		if (script)
-			g_string_append_printf(tag_string, "-%s", script);
-		if (territory)
-			g_string_append_printf(tag_string, "-%s", territory);
-		if (variant)
-			g_string_append_printf(tag_string, "-%s", variant);
-		if (codeset || privateuse) {
-			g_string_append(tag_string, "-x");
-			if (codeset)
-				g_string_append_printf(tag_string, "-codeset-%s", codeset);
-			if (privateuse)
-				g_string_append_printf(tag_string, "-%s", privateuse);
-		}
-		if (!lt_tag_parse(tag, tag_string->str, &err)) {
-			g_string_free(tag_string, TRUE);
-			goto bail;
+		if (tag->region) {
+			lt_tag_free_region(tag);
+			break;
+		}
+		if (tag->script) {
+			lt_tag_free_script(tag);
+			break;
+		}
+		if (tag->extlang) {
+			lt_tag_free_extlang(tag);
+			break;
+		}
+		if (tag->language) {
+			lt_tag_free_language(tag);
+			break;
 		}
-		g_string_free(tag_string, TRUE);
+		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
+			    "No tags to be truncated.");
+		goto bail;
 	}
+	lt_tag_free_tag_string(tag);
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		retval = FALSE;
+	}
+
+	return retval;
+}
+
+/**
+ * lt_tag_set_language:
+ * @tag: a #lt_tag_t.
+ * @lang: a #lt_lang_t.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Replace the language subtag in @tag with @lang without parsing
+ * the tag string. the grandfathered tag in @tag is discarded. only
+ * the relationships to @lang, i.e. the prefixes of the extlang
+ * and the variants, are validated. @tag isn't modified on error.
+ *
+ * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
+ */
+gboolean
+lt_tag_set_language(lt_tag_t   *tag,
+		    lt_lang_t  *lang,
+		    GError    **error)
+{
+	lt_lang_t *old = NULL;
+	GError *err = NULL;
+	gboolean retval = FALSE;
+
+	g_return_val_if_fail (tag != NULL, FALSE);
+	g_return_val_if_fail (lang != NULL, FALSE);
 
+	if (!_lt_tag_prepare_builder(tag, FALSE, &err))
+		goto bail;
+	if (tag->extlang) {
+		const gchar *prefix = lt_extlang_get_prefix(tag->extlang);
+
+		if (prefix &&
+		    g_ascii_strcasecmp(prefix, lt_lang_get_better_tag(lang)) != 0) {
+			g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+				    "extlang '%s' is supposed to be used with %s, but %s",
+				    lt_extlang_get_tag(tag->extlang), prefix,
+				    lt_lang_get_better_tag(lang));
+			goto bail;
+		}
+	}
+	if (tag->language)
+		old = lt_lang_ref(tag->language);
+	lt_tag_take_language(tag, lt_lang_ref(lang));
+	if (!_lt_tag_revalidate_variants(tag, &err)) {
+		lt_tag_take_language(tag, old);
+		goto bail;
+	}
+	lt_lang_unref(old);
+	/* a grandfathered tag has no variants to be validated */
+	lt_tag_free_grandfathered(tag);
+	_lt_tag_update_state(tag);
+	lt_tag_free_tag_string(tag);
+	retval = TRUE;
   bail:
-	g_free(s);
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+	}
+
+	return retval;
+}
+
+/**
+ * lt_tag_set_script:
+ * @tag: a #lt_tag_t.
+ * @script: (allow-none): a #lt_script_t or %NULL to remove the script subtag.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Replace the script subtag in @tag with @script without parsing
+ * the tag string. only the prefixes of the variants are validated again.
+ * @tag isn't modified on error.
+ *
+ * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
+ */
+gboolean
+lt_tag_set_script(lt_tag_t     *tag,
+		  lt_script_t  *script,
+		  GError      **error)
+{
+	lt_script_t *old;
+	GError *err = NULL;
+	gboolean retval = FALSE;
+
+	g_return_val_if_fail (tag != NULL, FALSE);
 
+	if (!_lt_tag_prepare_builder(tag, TRUE, &err))
+		goto bail;
+	old = tag->script ? lt_script_ref(tag->script) : NULL;
+	lt_tag_take_script(tag, script ? lt_script_ref(script) : NULL);
+	if (!_lt_tag_revalidate_variants(tag, &err)) {
+		lt_tag_take_script(tag, old);
+		goto bail;
+	}
+	lt_script_unref(old);
+	_lt_tag_update_state(tag);
+	lt_tag_free_tag_string(tag);
+	retval = TRUE;
+  bail:
 	if (err) {
 		if (error)
 			*error = g_error_copy(err);
 		else
 			g_warning(err->message);
 		g_error_free(err);
-		lt_tag_unref(tag);
-		tag = NULL;
 	}
 
-	return tag;
+	return retval;
 }
 
-/*< protected >*/
-lt_tag_state_t
-lt_tag_parse_wildcard(lt_tag_t     *tag,
-		      const gchar  *tag_string,
-		      GError      **error)
+/**
+ * lt_tag_set_region:
+ * @tag: a #lt_tag_t.
+ * @region: (allow-none): a #lt_region_t or %NULL to remove the region subtag.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Replace the region subtag in @tag with @region without parsing
+ * the tag string. only the prefixes of the variants are validated again.
+ * @tag isn't modified on error.
+ *
+ * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
+ */
+gboolean
+lt_tag_set_region(lt_tag_t     *tag,
+		  lt_region_t  *region,
+		  GError      **error)
 {
+	lt_region_t *old;
 	GError *err = NULL;
-	gboolean ret;
+	gboolean retval = FALSE;
 
-	lt_tag_parser_init(tag);
-	ret = _lt_tag_parse(tag, tag_string, TRUE, &err);
+	g_return_val_if_fail (tag != NULL, FALSE);
 
-	if (!ret && !err) {
-		g_set_error(&err, LT_ERROR, LT_ERR_FAIL_ON_SCANNER,
-			    "Unknown error during parsing a tag.");
+	if (!_lt_tag_prepare_builder(tag, TRUE, &err))
+		goto bail;
+	old = tag->region ? lt_region_ref(tag->region) : NULL;
+	lt_tag_take_region(tag, region ? lt_region_ref(region) : NULL);
+	if (!_lt_tag_revalidate_variants(tag, &err)) {
+		lt_tag_take_region(tag, old);
+		goto bail;
 	}
+	lt_region_unref(old);
+	_lt_tag_update_state(tag);
+	lt_tag_free_tag_string(tag);
+	retval = TRUE;
+  bail:
 	if (err) {
 		if (error)
 			*error = g_error_copy(err);
@@ -1252,467 +3272,765 @@ lt_tag_parse_wildcard(lt_tag_t     *tag,
 		g_error_free(err);
 	}
 
-	return tag->state;
+	return retval;
 }
 
-/*< public >*/
 /**
- * lt_tag_new:
+ * lt_tag_add_variant:
+ * @tag: a #lt_tag_t.
+ * @variant: a #lt_variant_t.
+ * @error: (allow-none): a #GError or %NULL.
  *
- * Create a new instance of #lt_tag_t.
+ * Append @variant to the variant subtags in @tag without parsing
+ * the tag string. @variant is validated against its prefixes and
+ * the variants in @tag. @tag isn't modified on error.
  *
- * Returns: (transfer full): a new instance of #lt_tag_t.
+ * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
  */
-lt_tag_t *
-lt_tag_new(void)
+gboolean
+lt_tag_add_variant(lt_tag_t      *tag,
+		   lt_variant_t  *variant,
+		   GError       **error)
 {
-	lt_tag_t *retval = lt_mem_alloc_object(sizeof (lt_tag_t));
+	lt_tag_state_t state;
+	GError *err = NULL;
+	gboolean retval = FALSE;
 
-	if (retval) {
-		retval->state = STATE_NONE;
-		retval->privateuse = g_string_new(NULL);
-		lt_mem_add_ref(&retval->parent, retval->privateuse,
-			       (lt_destroy_func_t)lt_mem_gstring_free);
+	g_return_val_if_fail (tag != NULL, FALSE);
+	g_return_val_if_fail (variant != NULL, FALSE);
+
+	if (!_lt_tag_prepare_builder(tag, TRUE, &err))
+		goto bail;
+	state = tag->state;
+	/* lt_tag_parse_variant() may fall back to the tag string */
+	lt_tag_get_string(tag);
+	if (!lt_tag_parse_variant(tag, lt_variant_ref(variant),
+				  lt_variant_get_tag(variant), &err)) {
+		tag->state = state;
+		goto bail;
+	}
+	_lt_tag_update_state(tag);
+	/* only raise the state, so that the extensions and the private use
+	 * subtags can't be parsed again after the variants.
+	 */
+	if (tag->state < state)
+		tag->state = state;
+	lt_tag_free_tag_string(tag);
+	retval = TRUE;
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
 	}
 
 	return retval;
 }
 
 /**
- * lt_tag_ref:
+ * lt_tag_get_string:
  * @tag: a #lt_tag_t.
  *
- * Increases the reference count of @tag.
+ * Obtains a language tag in string. the string is generated and cached
+ * in @tag at the first call unless @tag is frozen with lt_tag_freeze().
  *
- * Returns: (transfer none): the same @tag object.
+ * Returns: a language tag string.
  */
-lt_tag_t *
-lt_tag_ref(lt_tag_t *tag)
+const gchar *
+lt_tag_get_string(lt_tag_t *tag)
 {
-	g_return_val_if_fail (tag != NULL, NULL);
+	GString *string;
+	lt_tag_writer_t writer;
 
-	return lt_mem_ref(&tag->parent);
-}
+	if (tag->tag_string)
+		return tag->tag_string->str;
 
-/**
- * lt_tag_unref:
- * @tag: a #lt_tag_t.
- *
- * Decreases the reference count of @tag. when its reference count
- * drops to 0, the object is finalized (i.e. its memory is freed).
- */
-void
-lt_tag_unref(lt_tag_t *tag)
-{
-	if (tag)
-		lt_mem_unref(&tag->parent);
+	string = g_string_new(NULL);
+	lt_tag_writer_init(&writer, string, NULL, 0);
+	_lt_tag_write_string(tag, &writer);
+	if (writer.length == 0) {
+		g_string_free(string, TRUE);
+		return NULL;
+	}
+	tag->tag_string = string;
+	lt_mem_add_ref(&tag->parent, tag->tag_string,
+		       (lt_destroy_func_t)lt_mem_gstring_free);
+
+	return tag->tag_string->str;
 }
 
 /**
- * lt_tag_clear:
+ * lt_tag_get_string_to_buf:
  * @tag: a #lt_tag_t.
+ * @buf: (allow-none): the buffer to store the string.
+ * @cap: the size of @buf in bytes.
+ * @needed: (out) (allow-none): the location to store the size in bytes
+ *          required to store the whole string, including the nul terminator.
  *
- * (Re-)Initialize all of the subtag information stored in @tag.
+ * Same as lt_tag_get_string() but the string is written into @buf
+ * directly. the result is always nul-terminated and truncated
+ * if @cap isn't large enough. @buf can be %NULL with @cap 0 to obtain
+ * the required size only. this doesn't cache the string in @tag.
+ *
+ * Returns: %TRUE if the whole string is stored in @buf. otherwise %FALSE.
  */
-void
-lt_tag_clear(lt_tag_t *tag)
+gboolean
+lt_tag_get_string_to_buf(const lt_tag_t *tag,
+			 gchar          *buf,
+			 gsize           cap,
+			 gsize          *needed)
 {
-	g_return_if_fail (tag != NULL);
+	lt_tag_writer_t writer;
 
-	lt_tag_free_tag_string(tag);
-	lt_tag_free_language(tag);
-	lt_tag_free_extlang(tag);
-	lt_tag_free_script(tag);
-	lt_tag_free_region(tag);
-	lt_tag_free_variants(tag);
-	lt_tag_free_extension(tag);
-	if (tag->privateuse) {
-		g_string_truncate(tag->privateuse, 0);
+	g_return_val_if_fail (tag != NULL, FALSE);
+
+	lt_tag_writer_init(&writer, NULL, buf, cap);
+	_lt_tag_write_string(tag, &writer);
+	if (writer.length == 0) {
+		if (needed)
+			*needed = 0;
+		return FALSE;
 	}
-	lt_tag_free_grandfathered(tag);
+
+	return lt_tag_writer_finish(&writer, needed);
 }
 
 /**
- * lt_tag_parse:
+ * lt_tag_freeze:
  * @tag: a #lt_tag_t.
- * @tag_string: language tag to be parsed.
  * @error: (allow-none): a #GError or %NULL.
  *
- * Parse @tag_string and create appropriate instances for subtags.
+ * Make @tag immutable. the tag string and the canonicalized tag string are
+ * generated at once and any further attempts to modify @tag will fails.
+ * A frozen tag can be safely shared across threads for any read-only
+ * operations, such as lt_tag_get_string(), lt_tag_canonicalize(),
+ * lt_tag_compare(), lt_tag_match() and lt_tag_lookup().
+ * lt_tag_copy() still gives a modifiable copy of a frozen tag.
  *
- * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
+ * Returns: %TRUE if @tag is frozen, otherwise %FALSE.
  */
 gboolean
-lt_tag_parse(lt_tag_t     *tag,
-	     const gchar  *tag_string,
-	     GError      **error)
+lt_tag_freeze(lt_tag_t  *tag,
+	      GError   **error)
 {
-	lt_tag_parser_init(tag);
+	lt_tag_t *ctag;
+	gchar *s;
+	GError *err = NULL;
+
+	g_return_val_if_fail (tag != NULL, FALSE);
+
+	if (tag->frozen)
+		return TRUE;
+
+	if (!lt_tag_get_string(tag)) {
+		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
+			    "No tag to be frozen.");
+		goto bail;
+	}
+	/* lt_tag_canonicalize() may update subtags in the tag with
+	 * the preferred values in the redundant database.
+	 * do not change anything in the original one.
+	 */
+	ctag = lt_tag_copy(tag);
+	s = lt_tag_canonicalize(ctag, &err);
+	lt_tag_unref(ctag);
+	if (!s)
+		goto bail;
+	tag->canonical_string = s;
+	lt_mem_add_ref(&tag->parent, tag->canonical_string,
+		       (lt_destroy_func_t)g_free);
+	tag->frozen = TRUE;
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+
+		return FALSE;
+	}
 
-	return _lt_tag_parse(tag, tag_string, FALSE, error);
+	return TRUE;
 }
 
 /**
- * lt_tag_parse_with_extra_token:
+ * lt_tag_is_frozen:
  * @tag: a #lt_tag_t.
- * @tag_string: a language tag to be parsed much more.
- * @error: (allow-none): a #GError or %NULL.
  *
- * Continue to parse a language tag with @tag_string. please use lt_tag_parse()
- * at first.
+ * Check whether @tag is frozen with lt_tag_freeze().
  *
- * Returns: %TRUE if it's successfully completed, otherwise %FALSE.
+ * Returns: %TRUE if @tag is immutable, otherwise %FALSE.
  */
 gboolean
-lt_tag_parse_with_extra_token(lt_tag_t     *tag,
-			      const gchar  *tag_string,
-			      GError      **error)
+lt_tag_is_frozen(const lt_tag_t *tag)
 {
 	g_return_val_if_fail (tag != NULL, FALSE);
-	g_return_val_if_fail (tag->state != STATE_NONE, FALSE);
 
-	return _lt_tag_parse(tag, tag_string, FALSE, error);
+	return tag->frozen;
+}
+
+/* Create a frozen tag for @tag_string in the canonical form, so that
+ * the instance doesn't depend on which alias is given first.
+ */
+static lt_tag_t *
+_lt_tag_intern_new(const gchar  *tag_string,
+		   GError      **error)
+{
+	lt_tag_t *retval = lt_tag_new();
+	gchar *s;
+
+	if (!lt_tag_parse(retval, tag_string, error) ||
+	    !lt_tag_freeze(retval, error)) {
+		lt_tag_unref(retval);
+		return NULL;
+	}
+	if (strcmp(lt_tag_get_string(retval), retval->canonical_string) == 0)
+		return retval;
+	s = g_strdup(retval->canonical_string);
+	lt_tag_unref(retval);
+	retval = lt_tag_new();
+	if (!lt_tag_parse(retval, s, error) ||
+	    !lt_tag_freeze(retval, error)) {
+		lt_tag_unref(retval);
+		retval = NULL;
+	}
+	g_free(s);
+
+	return retval;
 }
 
 /**
- * lt_tag_copy:
- * @tag: a #lt_tag_t.
+ * lt_tag_intern:
+ * @tag_string: language tag to be parsed.
+ * @error: (allow-none): a #GError or %NULL.
  *
- * Create a copy instance of @tag.
+ * Obtain a shared instance of #lt_tag_t for @tag_string from the process-wide
+ * intern table. the tags are keyed by the canonicalized form, so any
+ * tag strings being canonicalized to the same tag gives the same instance,
+ * which is parsed from the canonicalized form, and they can be simply
+ * compared with the pointer. The recently given strings are remembered
+ * in the case-insensitive manner to skip parsing.
+ * The returned tag is frozen with lt_tag_freeze(). The intern table is
+ * cleared by lt_db_finalize(). While #lt_db_snapshot_t is used in the calling
+ * thread, the intern table isn't used and a new frozen tag is returned.
  *
- * Returns: (transfer full): a new instance of #lt_tag_t or %NULL if fails.
+ * Returns: (transfer full): a frozen #lt_tag_t or %NULL if fails.
  */
 lt_tag_t *
-lt_tag_copy(const lt_tag_t *tag)
+lt_tag_intern(const gchar  *tag_string,
+	      GError      **error)
 {
-	lt_tag_t *retval;
-	GList *l;
+	lt_tag_t *retval, *tag;
+	GError *err = NULL;
+	gint serial;
 
-	g_return_val_if_fail (tag != NULL, NULL);
+	g_return_val_if_fail (tag_string != NULL, NULL);
 
-	retval = lt_tag_new();
-	retval->wildcard_map = tag->wildcard_map;
-	retval->state = tag->state;
-	if (tag->language) {
-		lt_tag_set_language(retval, lt_lang_ref(tag->language));
-	}
-	if (tag->extlang) {
-		lt_tag_set_extlang(retval, lt_extlang_ref(tag->extlang));
-	}
-	if (tag->script) {
-		lt_tag_set_script(retval, lt_script_ref(tag->script));
+	if (lt_db_get_snapshot()) {
+		/* the tags in the table refer to the default database */
+		retval = _lt_tag_intern_new(tag_string, &err);
+		goto bail;
 	}
-	if (tag->region) {
-		lt_tag_set_region(retval, lt_region_ref(tag->region));
+
+	G_LOCK (lt_tag_intern);
+	retval = __lt_tag_intern_aliases ? g_hash_table_lookup(__lt_tag_intern_aliases, tag_string) : NULL;
+	if (retval)
+		lt_tag_ref(retval);
+	G_UNLOCK (lt_tag_intern);
+	if (retval)
+		return retval;
+
+	/* parse it without the lock. */
+	serial = g_atomic_int_get(&__lt_tag_intern_serial);
+	tag = _lt_tag_intern_new(tag_string, &err);
+	if (!tag)
+		goto bail;
+
+	G_LOCK (lt_tag_intern);
+	if (serial != g_atomic_int_get(&__lt_tag_intern_serial)) {
+		/* the databases were reloaded meanwhile */
+		G_UNLOCK (lt_tag_intern);
+
+		return tag;
 	}
-	l = tag->variants;
-	while (l != NULL) {
-		lt_tag_set_variant(retval, lt_variant_ref(l->data));
-		l = g_list_next(l);
+	if (!__lt_tag_intern_table) {
+		__lt_tag_intern_table = g_hash_table_new_full(g_str_hash,
+							      g_str_equal,
+							      g_free,
+							      (GDestroyNotify)lt_tag_unref);
+		__lt_tag_intern_aliases = g_hash_table_new_full(lt_strcase_hash,
+								lt_strcase_equal,
+								g_free,
+								(GDestroyNotify)lt_tag_unref);
 	}
-	if (tag->extension) {
-		lt_tag_set_extension(retval, lt_extension_copy(tag->extension));
+	retval = g_hash_table_lookup(__lt_tag_intern_table, tag->canonical_string);
+	if (retval) {
+		/* Someone else may have interned the same tag already */
+		lt_tag_unref(tag);
+	} else {
+		retval = tag;
+		g_hash_table_insert(__lt_tag_intern_table,
+				    g_strdup(retval->canonical_string),
+				    retval);
 	}
-	if (tag->privateuse) {
-		g_string_append(retval->privateuse, tag->privateuse->str);
+	if (!g_hash_table_lookup(__lt_tag_intern_aliases, tag_string)) {
+		/* start over rather than growing with the arbitrary input */
+		if (g_hash_table_size(__lt_tag_intern_aliases) >= LT_TAG_INTERN_ALIASES_MAX)
+			g_hash_table_remove_all(__lt_tag_intern_aliases);
+		g_hash_table_insert(__lt_tag_intern_aliases,
+				    g_strdup(tag_string),
+				    lt_tag_ref(retval));
 	}
-	if (tag->grandfathered) {
-		lt_tag_set_grandfathered(retval, lt_grandfathered_ref(tag->grandfathered));
+	lt_tag_ref(retval);
+	G_UNLOCK (lt_tag_intern);
+
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
 	}
 
 	return retval;
 }
 
 /**
- * lt_tag_truncate:
+ * lt_tag_canonicalize:
  * @tag: a #lt_tag_t.
- * @error: (allow-none): a #GError.
+ * @error: (allow-none): a #GError or %NULL.
  *
- * Truncate the last subtag.
+ * Canonicalize the language tag according to various information of subtags.
  *
- * Returns: %TRUE if a subtag was truncated, otherwise %FALSE.
+ * Returns: a language tag string.
  */
-gboolean
-lt_tag_truncate(lt_tag_t  *tag,
-		GError   **error)
+gchar *
+lt_tag_canonicalize(lt_tag_t  *tag,
+		    GError   **error)
 {
+	GString *string;
 	GError *err = NULL;
-	gboolean retval = TRUE;
+	lt_tag_writer_t writer;
 
-	g_return_val_if_fail (tag != NULL, FALSE);
-
-	if (tag->grandfathered) {
-		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
-			    "Grandfathered subtag can't be truncated.");
-		goto bail;
-	}
-	while (1) {
-		if (tag->privateuse && tag->privateuse->len > 0) {
-			g_string_truncate(tag->privateuse, 0);
-			break;
-		}
-		if (tag->extension) {
-			gint i;
-			gchar c;
-			gboolean has_tag = FALSE;
+	g_return_val_if_fail (tag != NULL, NULL);
 
-			lt_extension_truncate(tag->extension);
-			for (i = 0; i < LT_MAX_EXT_MODULES; i++) {
-				c = lt_ext_module_singleton_int_to_char(i);
+	if (tag->frozen)
+		return g_strdup(tag->canonical_string);
 
-				if (c == 'x')
-					continue;
-				has_tag = lt_extension_has_singleton(tag->extension, c);
-				if (has_tag)
-					break;
-			}
-			if (!has_tag) {
-				lt_tag_free_extension(tag);
-			}
-			break;
-		}
-		if (tag->variants) {
-			GList *l = g_list_last(tag->variants);
-			lt_variant_t *v = l->data;
+	string = g_string_new(NULL);
+	lt_tag_writer_init(&writer, string, NULL, 0);
+	if (!_lt_tag_write_canonical(tag, &writer, &err)) {
+		g_string_free(string, TRUE);
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
 
-			if (tag->variants == l) {
-				lt_mem_delete_ref(&tag->parent, tag->variants);
-				tag->variants = g_list_delete_link(tag->variants, l);
-				if (tag->variants)
-					lt_mem_add_ref(&tag->parent, tag->variants,
-						       (lt_destroy_func_t)_lt_tag_variants_list_free);
-			} else {
-				l = g_list_delete_link(l, l);
-			}
-			lt_variant_unref(v);
-			break;
-		}
-		if (tag->region) {
-			lt_tag_free_region(tag);
-			break;
-		}
-		if (tag->script) {
-			lt_tag_free_script(tag);
-			break;
-		}
-		if (tag->extlang) {
-			lt_tag_free_extlang(tag);
-			break;
-		}
-		if (tag->language) {
-			lt_tag_free_language(tag);
-			break;
-		}
-		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
-			    "No tags to be truncated.");
-		goto bail;
+		return NULL;
 	}
-	lt_tag_free_tag_string(tag);
-  bail:
-	if (err) {
+
+	return g_string_free(string, FALSE);
+}
+
+/**
+ * lt_tag_canonicalize_to_buf:
+ * @tag: a #lt_tag_t.
+ * @buf: (allow-none): the buffer to store the string.
+ * @cap: the size of @buf in bytes.
+ * @needed: (out) (allow-none): the location to store the size in bytes
+ *          required to store the whole string, including the nul terminator.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Same as lt_tag_canonicalize() but the string is written into @buf
+ * directly. see lt_tag_get_string_to_buf() for the details of
+ * @buf, @cap and @needed. @needed is set to 0 if fails.
+ *
+ * Returns: %TRUE if the whole string is stored in @buf. otherwise %FALSE.
+ */
+gboolean
+lt_tag_canonicalize_to_buf(const lt_tag_t  *tag,
+			   gchar           *buf,
+			   gsize            cap,
+			   gsize           *needed,
+			   GError         **error)
+{
+	GError *err = NULL;
+	lt_tag_writer_t writer;
+
+	g_return_val_if_fail (tag != NULL, FALSE);
+
+	lt_tag_writer_init(&writer, NULL, buf, cap);
+	if (tag->frozen) {
+		lt_tag_writer_append(&writer, tag->canonical_string,
+				     strlen(tag->canonical_string));
+	} else if (!_lt_tag_write_canonical(tag, &writer, &err)) {
+		if (needed)
+			*needed = 0;
 		if (error)
 			*error = g_error_copy(err);
 		else
 			g_warning(err->message);
 		g_error_free(err);
-		retval = FALSE;
+
+		return FALSE;
 	}
 
-	return retval;
+	return lt_tag_writer_finish(&writer, needed);
 }
 
 /**
- * lt_tag_get_string:
- * @tag: a #lt_tag_t.
+ * lt_tag_hash:
+ * @v: (type lt_tag_t): a #lt_tag_t.
  *
- * Obtains a language tag in string.
+ * Converts a #lt_tag_t to a hash value. the hash value is computed from
+ * the canonicalized form of the tag without allocating its string, so
+ * the tags being equivalent after canonicalization get the same value.
+ * It can be passed to g_hash_table_new() as the @hash_func parameter,
+ * along with lt_tag_equal().
  *
- * Returns: a language tag string.
+ * Returns: a hash value corresponding to the tag.
  */
-const gchar *
-lt_tag_get_string(lt_tag_t *tag)
+guint
+lt_tag_hash(gconstpointer v)
 {
-	GList *l;
+	const lt_tag_t *tag = v;
+	lt_tag_writer_t writer;
 
-	if (tag->tag_string)
-		return tag->tag_string->str;
+	g_return_val_if_fail (tag != NULL, 0);
 
-	if (tag->grandfathered)
-		lt_tag_add_tag_string(tag, lt_grandfathered_get_tag(tag->grandfathered));
-	else if (tag->language) {
-		lt_tag_add_tag_string(tag, lt_lang_get_tag(tag->language));
-		if (tag->extlang)
-			lt_tag_add_tag_string(tag, lt_extlang_get_tag(tag->extlang));
-		if (tag->script)
-			lt_tag_add_tag_string(tag, lt_script_get_tag(tag->script));
-		if (tag->region)
-			lt_tag_add_tag_string(tag, lt_region_get_tag(tag->region));
-		l = tag->variants;
-		while (l != NULL) {
-			lt_tag_add_tag_string(tag, lt_variant_get_tag(l->data));
-			l = g_list_next(l);
-		}
-		if (tag->extension)
-			lt_tag_add_tag_string(tag, lt_extension_get_tag(tag->extension));
-		if (tag->privateuse && tag->privateuse->len > 0)
-			lt_tag_add_tag_string(tag, tag->privateuse->str);
-	} else if (tag->privateuse && tag->privateuse->len > 0) {
-		lt_tag_add_tag_string(tag, tag->privateuse->str);
-	} else {
-		return NULL;
-	}
+	if (tag->frozen)
+		return lt_strcase_hash(tag->canonical_string);
 
-	return tag->tag_string->str;
+	lt_tag_writer_init(&writer, NULL, NULL, 0);
+	if (!_lt_tag_write_canonical(tag, &writer, NULL))
+		return lt_strcase_hash("");
+
+	return writer.hash;
 }
 
 /**
- * lt_tag_canonicalize:
+ * lt_tag_equal:
+ * @v1: (type lt_tag_t): a #lt_tag_t.
+ * @v2: (type lt_tag_t): a #lt_tag_t to compare with @v1.
+ *
+ * Compares two tags in the canonicalized form and returns %TRUE if they
+ * are equal. It can be passed to g_hash_table_new() as the
+ * @key_equal_func parameter, along with lt_tag_hash().
+ *
+ * Returns: %TRUE if the tags are equal.
+ */
+gboolean
+lt_tag_equal(gconstpointer v1,
+	     gconstpointer v2)
+{
+	gchar buf1[LT_TAG_WRITER_BUFSIZE], buf2[LT_TAG_WRITER_BUFSIZE];
+	gchar *a1 = NULL, *a2 = NULL;
+	const gchar *s1, *s2;
+	gboolean retval;
+
+	g_return_val_if_fail (v1 != NULL, FALSE);
+	g_return_val_if_fail (v2 != NULL, FALSE);
+
+	if (v1 == v2)
+		return TRUE;
+
+	s1 = _lt_tag_get_canonical_string(v1, buf1, sizeof (buf1), &a1);
+	s2 = _lt_tag_get_canonical_string(v2, buf2, sizeof (buf2), &a2);
+	retval = g_ascii_strcasecmp(s1, s2) == 0;
+	g_free(a1);
+	g_free(a2);
+
+	return retval;
+}
+
+/**
+ * lt_tag_encode:
  * @tag: a #lt_tag_t.
+ * @length: (out): the location to store the length of the result.
  * @error: (allow-none): a #GError or %NULL.
  *
- * Canonicalize the language tag according to various information of subtags.
+ * Encodes @tag into the compact binary form. the result starts with
+ * the version stamp of the subtag registry, followed by the 16-bit ids of
+ * the subtags in the canonicalized form of @tag. the extensions and the
+ * private use subtags are stored as is.
  *
- * Returns: a language tag string.
+ * The binary forms sort with memcmp() in the same order as the
+ * canonicalized tags compared case-insensitively, so they can be used as
+ * a sort key as is. The subtags that aren't in the registry, which only
+ * happens with some grandfathered tags, sort after any registered subtags.
+ *
+ * Returns: (array length=length) (transfer full): the encoded data or
+ *          %NULL if fails.
  */
-gchar *
-lt_tag_canonicalize(lt_tag_t  *tag,
-		    GError   **error)
+guchar *
+lt_tag_encode(const lt_tag_t  *tag,
+	      gsize           *length,
+	      GError         **error)
 {
-	gchar *retval = NULL;
-	GString *string = NULL;
+	gchar buffer[LT_TAG_WRITER_BUFSIZE], subtag[LT_TAG_ENCODING_SUBTAG_MAX + 1];
+	gchar *allocated = NULL;
+	const gchar *p, *e;
+	lt_subtag_index_t *sindex;
+	GByteArray *array = NULL;
+	guint32 version;
+	guchar c;
 	GError *err = NULL;
-	GList *l;
-	lt_redundant_db_t *rdb = NULL;
-	lt_redundant_t *r = NULL;
-	lt_tag_t *ctag = NULL;
 
 	g_return_val_if_fail (tag != NULL, NULL);
+	g_return_val_if_fail (length != NULL, NULL);
 
-	string = g_string_new(NULL);
-	if (tag->grandfathered) {
-		g_string_append(string, lt_grandfathered_get_better_tag(tag->grandfathered));
-		goto bail1;
+	if (tag->wildcard_map) {
+		g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+			    "Wildcard can't be encoded.");
+		goto bail;
 	}
-
-	ctag = lt_tag_copy(tag);
-	rdb = lt_db_get_redundant();
+	p = _lt_tag_get_canonical_string(tag, buffer, sizeof (buffer), &allocated);
+	if (*p == 0) {
+		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
+			    "No tag to encode.");
+		goto bail;
+	}
+	sindex = lt_db_get_subtag_index();
+	version = lt_subtag_index_get_version(sindex);
+	array = g_byte_array_sized_new(16);
+	c = (version >> 24) & 0xff;
+	g_byte_array_append(array, &c, 1);
+	c = (version >> 16) & 0xff;
+	g_byte_array_append(array, &c, 1);
+	c = (version >> 8) & 0xff;
+	g_byte_array_append(array, &c, 1);
+	c = version & 0xff;
+	g_byte_array_append(array, &c, 1);
 	while (1) {
-		const gchar *tag_string = lt_tag_get_string(ctag);
-
-		if (tag_string == NULL || tag_string[0] == 0)
+		gsize len, i;
+		guint id = 0;
+
+		e = strchr(p, '-');
+		len = e ? e - p : strlen(p);
+		if (len <= LT_TAG_ENCODING_SUBTAG_MAX) {
+			memcpy(subtag, p, len);
+			subtag[len] = 0;
+			id = lt_subtag_index_lookup(sindex, subtag);
+		}
+		if (id == 0) {
+			/* not registered. store the subtag as is */
+			c = (LT_TAG_ENCODING_LITERAL >> 8) & 0xff;
+			g_byte_array_append(array, &c, 1);
+			c = LT_TAG_ENCODING_LITERAL & 0xff;
+			g_byte_array_append(array, &c, 1);
+			for (i = 0; i < len; i++) {
+				c = g_ascii_tolower(p[i]);
+				g_byte_array_append(array, &c, 1);
+			}
+			c = 0;
+			g_byte_array_append(array, &c, 1);
+		} else {
+			c = (id >> 8) & 0xff;
+			g_byte_array_append(array, &c, 1);
+			c = id & 0xff;
+			g_byte_array_append(array, &c, 1);
+		}
+		if (!e) {
+			c = 0;
+			g_byte_array_append(array, &c, 1);
+			g_byte_array_append(array, &c, 1);
 			break;
-		if (r)
-			lt_redundant_unref(r);
-		r = lt_redundant_db_lookup(rdb, tag_string);
-		if (r) {
-			const gchar *preferred = lt_redundant_get_preferred_tag(r);
-
-			if (preferred) {
-				lt_tag_t *rtag = lt_tag_new();
-				lt_tag_t *ntag = lt_tag_new();
-
-				if (!lt_tag_parse(rtag, lt_redundant_get_tag(r), &err)) {
-					lt_tag_unref(rtag);
-					lt_tag_unref(ntag);
-					goto bail1;
-				}
-				if (!lt_tag_parse(ntag, preferred, &err)) {
-					lt_tag_unref(rtag);
-					lt_tag_unref(ntag);
-					goto bail1;
-				}
-				_lt_tag_subtract(tag, rtag);
-				_lt_tag_replace(tag, ntag);
-				lt_tag_unref(rtag);
-				lt_tag_unref(ntag);
+		}
+		p = e + 1;
+		if (len == 1) {
+			/* the rest is the extensions or the private use
+			 * subtags. they sort as strings.
+			 */
+			for (; *p; p++) {
+				c = g_ascii_tolower(*p);
+				g_byte_array_append(array, &c, 1);
 			}
+			c = 0;
+			g_byte_array_append(array, &c, 1);
 			break;
-		} else {
-			if (!lt_tag_truncate(ctag, &err))
-				goto bail1;
 		}
 	}
+	lt_subtag_index_unref(sindex);
+  bail:
+	g_free(allocated);
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
 
-	if (tag->language) {
-		gsize len;
-		lt_extlang_db_t *edb = lt_db_get_extlang();
-		lt_extlang_t *e;
+		return NULL;
+	}
+	*length = array->len;
 
-		/* If the language tag starts with a primary language subtag
-		 * that is also an extlang subtag, then the language tag is
-		 * prepended with the extlang's 'Prefix'.
-		 */
-		e = lt_extlang_db_lookup(edb, lt_lang_get_better_tag(tag->language));
-		if (e) {
-			const gchar *prefix = lt_extlang_get_prefix(e);
+	return g_byte_array_free(array, FALSE);
+}
 
-			if (prefix)
-				g_string_append_printf(string, "%s-", prefix);
-			lt_extlang_unref(e);
-		}
-		lt_extlang_db_unref(edb);
+/**
+ * lt_tag_decode:
+ * @data: (array length=length): the data encoded by lt_tag_encode().
+ * @length: the length of @data.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Decodes the binary form generated by lt_tag_encode() into #lt_tag_t.
+ * the registered subtags are looked up by their ids and no parsing is
+ * involved except for the extensions and the private use subtags.
+ * This fails if @data was encoded with the different version of the
+ * subtag registry.
+ *
+ * Returns: (transfer full): a new instance of #lt_tag_t, which is
+ *          the canonicalized form of the encoded tag, or %NULL if fails.
+ */
+lt_tag_t *
+lt_tag_decode(const guchar  *data,
+	      gsize          length,
+	      GError       **error)
+{
+	gchar buffer[LT_TAG_WRITER_BUFSIZE];
+	const gchar *subtags[LT_TAG_WRITER_MAX_SUBTAGS], *tail = NULL;
+	guint ids[LT_TAG_WRITER_MAX_SUBTAGS];
+	lt_subtag_index_t *sindex;
+	lt_grandfathered_db_t *gdb;
+	lt_tag_writer_t writer;
+	lt_tag_t *retval = NULL;
+	guint32 version;
+	gsize pos = 4;
+	gint i, n = 0, n_registered;
+	gboolean has_literal = FALSE, terminated = FALSE;
+	GError *err = NULL;
 
-		g_string_append(string, lt_lang_get_better_tag(tag->language));
-		if (tag->extlang) {
-			const gchar *preferred = lt_extlang_get_preferred_tag(tag->extlang);
+	g_return_val_if_fail (data != NULL, NULL);
 
-			if (preferred) {
-				g_string_truncate(string, 0);
-				g_string_append(string, preferred);
-			} else {
-				g_string_append_printf(string, "-%s",
-						       lt_extlang_get_tag(tag->extlang));
-			}
-		}
-		if (tag->script) {
-			const gchar *script = lt_script_get_tag(tag->script);
-			const gchar *suppress = lt_lang_get_suppress_script(tag->language);
+	sindex = lt_db_get_subtag_index();
+	if (length < 6) {
+		g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+			    "Too short to decode.");
+		goto bail;
+	}
+	version = ((guint32)data[0] << 24) | ((guint32)data[1] << 16) |
+		((guint32)data[2] << 8) | (guint32)data[3];
+	if (version != lt_subtag_index_get_version(sindex)) {
+		g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+			    "The data was encoded with the different registry: %u",
+			    version);
+		goto bail;
+	}
+	while (pos + 1 < length) {
+		guint id = (data[pos] << 8) | data[pos + 1];
+		const gchar *s;
 
-			if (!suppress ||
-			    g_ascii_strcasecmp(suppress, script))
-				g_string_append_printf(string, "-%s", script);
+		pos += 2;
+		if (id == 0) {
+			terminated = TRUE;
+			break;
 		}
-		if (tag->region) {
-			g_string_append_printf(string, "-%s", lt_region_get_better_tag(tag->region));
+		if (n >= LT_TAG_WRITER_MAX_SUBTAGS) {
+			g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+				    "Too many subtags to decode.");
+			goto bail;
 		}
-		l = tag->variants;
-		len = string->len;
-		while (l != NULL) {
-			lt_variant_t *variant = l->data;
-			const gchar *better = lt_variant_get_better_tag(variant);
-			const gchar *s = lt_variant_get_tag(variant);
-
-			if (better && g_ascii_strcasecmp(s, better) != 0) {
-				/* ignore all of variants prior to this one */
-				g_string_truncate(string, len);
+		if (id == LT_TAG_ENCODING_LITERAL) {
+			s = (const gchar *)&data[pos];
+			has_literal = TRUE;
+		} else {
+			s = lt_subtag_index_get_subtag(sindex, id);
+		}
+		if (!s ||
+		    (id == LT_TAG_ENCODING_LITERAL &&
+		     !memchr(s, 0, length - pos))) {
+			g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+				    "Invalid data to decode.");
+			goto bail;
+		}
+		if (id == LT_TAG_ENCODING_LITERAL)
+			pos += strlen(s) + 1;
+		ids[n] = id;
+		subtags[n++] = s;
+		if (id != LT_TAG_ENCODING_LITERAL && s[1] == 0) {
+			/* singleton. the rest is terminated with the nul */
+			tail = (const gchar *)&data[pos];
+			if (!memchr(tail, 0, length - pos)) {
+				g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+					    "Invalid data to decode.");
+				goto bail;
 			}
-			g_string_append_printf(string, "-%s", better ? better : s);
-			l = g_list_next(l);
+			pos += strlen(tail) + 1;
+			terminated = TRUE;
+			break;
 		}
-		if (tag->extension) {
-			gchar *s = lt_extension_get_canonicalized_tag(tag->extension);
+	}
+	if (n == 0 || !terminated) {
+		g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+			    "No terminator in the data to decode.");
+		goto bail;
+	}
+	if (pos != length) {
+		g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+			    "Trailing garbage in the data to decode.");
+		goto bail;
+	}
 
-			g_string_append_printf(string, "-%s", s);
-			g_free(s);
+	retval = lt_tag_new();
+	n_registered = tail ? n - 1 : n;
+	for (i = 0; i < n_registered && !has_literal; i++) {
+		if (!_lt_tag_set_indexed_subtag(retval,
+						lt_subtag_index_get_entry(sindex, ids[i]),
+						subtags[i]))
+			break;
+	}
+	if (tail || has_literal || i < n_registered) {
+		/* the string is needed for the grandfathered tags and
+		 * the extensions only.
+		 */
+		lt_tag_writer_init(&writer, NULL, buffer, sizeof (buffer));
+		for (i = 0; i < n; i++)
+			lt_tag_writer_append_subtag(&writer, subtags[i]);
+		if (tail)
+			lt_tag_writer_append_subtag(&writer, tail);
+		if (writer.length >= sizeof (buffer)) {
+			g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+				    "Invalid data to decode.");
+			goto bail;
 		}
 	}
-	if (tag->privateuse && tag->privateuse->len > 0) {
-		g_string_append_printf(string, "%s%s",
-				       string->len > 0 ? "-" : "",
-				       tag->privateuse->str);
+	if (has_literal || i < n_registered || (tail && n == 1)) {
+		gdb = lt_db_get_grandfathered();
+		lt_tag_unref(retval);
+		retval = lt_tag_new();
+		lt_tag_take_grandfathered(retval, lt_grandfathered_db_lookup(gdb, buffer));
+		lt_grandfathered_db_unref(gdb);
+		if (retval->grandfathered)
+			goto bail;
+		if (has_literal) {
+			g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+				    "Unknown subtag in the data: %s", buffer);
+			goto bail;
+		}
+		if (i < n_registered) {
+			g_set_error(&err, LT_ERROR, LT_ERR_INVALID,
+				    "Invalid subtag in the data: %s", subtags[i]);
+			goto bail;
+		}
 	}
-	if (string->len == 0) {
-		g_set_error(&err, LT_ERROR, LT_ERR_NO_TAG,
-			    "No tag to convert.");
+	if (tail) {
+		/* the tail is the same as the end of buffer */
+		const gchar *extra = &buffer[writer.length - strlen(tail) - 2];
+
+		if (retval->state == STATE_NONE) {
+			lt_tag_parse(retval, extra, &err);
+		} else {
+			lt_tag_get_string(retval);
+			lt_tag_parse_with_extra_token(retval, extra, &err);
+		}
 	}
-  bail1:
-	if (ctag)
-		lt_tag_unref(ctag);
-	if (rdb)
-		lt_redundant_db_unref(rdb);
-	if (r)
-		lt_redundant_unref(r);
-	retval = g_string_free(string, FALSE);
+  bail:
+	lt_subtag_index_unref(sindex);
 	if (err) {
 		if (error)
 			*error = g_error_copy(err);
@@ -1720,7 +4038,7 @@ lt_tag_canonicalize(lt_tag_t  *tag,
 			g_warning(err->message);
 		g_error_free(err);
 		if (retval)
-			g_free(retval);
+			lt_tag_unref(retval);
 		retval = NULL;
 	}
 
@@ -1746,6 +4064,63 @@ lt_tag_convert_from_locale(GError **error)
 	return _lt_tag_convert_from_locale_string(locale, error);
 }
 
+/**
+ * lt_tag_get_thread_locale:
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Obtain the language tag for the locale effective in the calling thread,
+ * including the one set by uselocale(). The result is cached per thread
+ * and the locale is converted again only when it's changed, unless
+ * #lt_db_snapshot_t is used in the calling thread.
+ * The returned tag is frozen with lt_tag_freeze().
+ *
+ * Returns: (transfer full): a frozen #lt_tag_t, %NULL if fails.
+ */
+lt_tag_t *
+lt_tag_get_thread_locale(GError **error)
+{
+	lt_tag_locale_cache_t *cache = g_private_get(&__lt_tag_locale_cache);
+	const gchar *locale = _lt_tag_get_thread_locale_name();
+	gint serial = g_atomic_int_get(&__lt_tag_locale_serial);
+	gboolean cacheable = lt_db_get_snapshot() == NULL;
+	lt_tag_t *tag;
+	GError *err = NULL;
+
+	if (cacheable &&
+	    cache &&
+	    cache->serial == serial &&
+	    g_strcmp0(cache->locale, locale) == 0)
+		return lt_tag_ref(cache->tag);
+
+	tag = _lt_tag_convert_from_locale_string(locale, &err);
+	if (tag && !lt_tag_freeze(tag, &err)) {
+		lt_tag_unref(tag);
+		tag = NULL;
+	}
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+
+		return NULL;
+	}
+	if (!cacheable)
+		return tag;
+	if (!cache) {
+		cache = g_new0(lt_tag_locale_cache_t, 1);
+		g_private_set(&__lt_tag_locale_cache, cache);
+	}
+	lt_tag_unref(cache->tag);
+	g_free(cache->locale);
+	cache->serial = serial;
+	cache->locale = g_strdup(locale);
+	cache->tag = lt_tag_ref(tag);
+
+	return tag;
+}
+
 /**
  * lt_tag_convert_to_locale:
  * @tag: a #lt_tag_t.
@@ -1759,51 +4134,69 @@ gchar *
 lt_tag_convert_to_locale(lt_tag_t  *tag,
 			 GError   **error)
 {
-	gchar *retval = NULL;
-	GString *string = NULL;
+	GString *string;
 	GError *err = NULL;
-	const gchar *mod = NULL;
-	gchar *canonical_tag = NULL;
-	lt_tag_t *ctag;
+	lt_tag_writer_t writer;
 
 	g_return_val_if_fail (tag != NULL, NULL);
 
-	canonical_tag = lt_tag_canonicalize(tag, &err);
-	if (!canonical_tag)
-		goto bail;
-	ctag = lt_tag_new();
-	if (!lt_tag_parse(ctag, canonical_tag, &err)) {
-		lt_tag_unref(ctag);
-		goto bail;
-	}
 	string = g_string_new(NULL);
-	g_string_append(string, lt_lang_get_better_tag(ctag->language));
-	if (ctag->region)
-		g_string_append_printf(string, "_%s",
-				       lt_region_get_tag(ctag->region));
-	if (ctag->script) {
-		mod = lt_script_convert_to_modifier(ctag->script);
-		if (mod)
-			g_string_append_printf(string, "@%s", mod);
+	lt_tag_writer_init(&writer, string, NULL, 0);
+	if (!_lt_tag_write_locale(tag, &writer, &err)) {
+		g_string_free(string, TRUE);
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+
+		return NULL;
 	}
-	lt_tag_unref(ctag);
 
-  bail:
-	g_free(canonical_tag);
-	if (string)
-		retval = g_string_free(string, FALSE);
-	if (err) {
+	return g_string_free(string, FALSE);
+}
+
+/**
+ * lt_tag_convert_to_locale_to_buf:
+ * @tag: a #lt_tag_t.
+ * @buf: (allow-none): the buffer to store the string.
+ * @cap: the size of @buf in bytes.
+ * @needed: (out) (allow-none): the location to store the size in bytes
+ *          required to store the whole string, including the nul terminator.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Same as lt_tag_convert_to_locale() but the string is written into @buf
+ * directly. see lt_tag_get_string_to_buf() for the details of
+ * @buf, @cap and @needed. @needed is set to 0 if fails.
+ *
+ * Returns: %TRUE if the whole string is stored in @buf. otherwise %FALSE.
+ */
+gboolean
+lt_tag_convert_to_locale_to_buf(const lt_tag_t  *tag,
+				gchar           *buf,
+				gsize            cap,
+				gsize           *needed,
+				GError         **error)
+{
+	GError *err = NULL;
+	lt_tag_writer_t writer;
+
+	g_return_val_if_fail (tag != NULL, FALSE);
+
+	lt_tag_writer_init(&writer, NULL, buf, cap);
+	if (!_lt_tag_write_locale(tag, &writer, &err)) {
+		if (needed)
+			*needed = 0;
 		if (error)
 			*error = g_error_copy(err);
 		else
 			g_warning(err->message);
 		g_error_free(err);
-		if (retval)
-			g_free(retval);
-		retval = NULL;
+
+		return FALSE;
 	}
 
-	return retval;
+	return lt_tag_writer_finish(&writer, needed);
 }
 
 /**
@@ -1905,6 +4298,50 @@ gboolean
 lt_tag_match(const lt_tag_t  *v1,
 	     const gchar     *v2,
 	     GError         **error)
+{
+	return lt_tag_match_len(v1, v2, -1, error);
+}
+
+/**
+ * lt_tag_match_len:
+ * @v1: a #lt_tag_t.
+ * @v2: (array length=length): a language range string.
+ * @length: the length of @v2 in bytes, or -1 if it's nul-terminated.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Same as lt_tag_match() but @v2 doesn't need to be nul-terminated.
+ *
+ * Returns: %TRUE if it matches, otherwise %FALSE.
+ */
+gboolean
+lt_tag_match_len(const lt_tag_t  *v1,
+		 const gchar     *v2,
+		 gssize           length,
+		 GError         **error)
+{
+	return lt_tag_match_full(v1, v2, length, LT_TAG_MATCH_DEFAULT, error);
+}
+
+/**
+ * lt_tag_match_full:
+ * @v1: a #lt_tag_t.
+ * @v2: (array length=length): a language range string.
+ * @length: the length of @v2 in bytes, or -1 if it's nul-terminated.
+ * @flags: a bitwise OR of #lt_tag_match_flags_t.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Same as lt_tag_match_len() but the matching can be extended with @flags.
+ * with %LT_TAG_MATCH_REGION_CONTAINMENT, "es-419" matches "es-MX" because
+ * Mexico is within Latin America.
+ *
+ * Returns: %TRUE if it matches, otherwise %FALSE.
+ */
+gboolean
+lt_tag_match_full(const lt_tag_t        *v1,
+		  const gchar           *v2,
+		  gssize                 length,
+		  lt_tag_match_flags_t   flags,
+		  GError               **error)
 {
 	gboolean retval = FALSE;
 	lt_tag_t *t2 = NULL;
@@ -1915,10 +4352,10 @@ lt_tag_match(const lt_tag_t  *v1,
 	g_return_val_if_fail (v2 != NULL, FALSE);
 
 	t2 = lt_tag_new();
-	state = lt_tag_parse_wildcard(t2, v2, &err);
+	state = lt_tag_parse_wildcard(t2, v2, length, &err);
 	if (err)
 		goto bail;
-	retval = _lt_tag_match(v1, t2, state);
+	retval = _lt_tag_match(v1, t2, state, flags);
   bail:
 	if (err) {
 		if (error)
@@ -1950,6 +4387,26 @@ gchar *
 lt_tag_lookup(const lt_tag_t  *tag,
 	      const gchar     *pattern,
 	      GError         **error)
+{
+	return lt_tag_lookup_len(tag, pattern, -1, error);
+}
+
+/**
+ * lt_tag_lookup_len:
+ * @tag: a #lt_tag_t.
+ * @pattern: (array length=length): a language range string.
+ * @length: the length of @pattern in bytes, or -1 if it's nul-terminated.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Same as lt_tag_lookup() but @pattern doesn't need to be nul-terminated.
+ *
+ * Returns: a language tag string if any matches, otherwise %NULL.
+ */
+gchar *
+lt_tag_lookup_len(const lt_tag_t  *tag,
+		  const gchar     *pattern,
+		  gssize           length,
+		  GError         **error)
 {
 	lt_tag_t *t2 = NULL;
 	lt_tag_state_t state = STATE_NONE;
@@ -1961,41 +4418,41 @@ lt_tag_lookup(const lt_tag_t  *tag,
 	g_return_val_if_fail (pattern != NULL, NULL);
 
 	t2 = lt_tag_new();
-	state = lt_tag_parse_wildcard(t2, pattern, &err);
+	state = lt_tag_parse_wildcard(t2, pattern, length, &err);
 	if (err)
 		goto bail;
-	if (_lt_tag_match(tag, t2, state)) {
+	if (_lt_tag_match(tag, t2, state, LT_TAG_MATCH_DEFAULT)) {
 		gint32 i;
 
 		for (i = 0; i < (STATE_END - 1); i++) {
 			if (t2->wildcard_map & (1 << i)) {
 				switch (i + 1) {
 				    case STATE_LANG:
-					    lt_tag_set_language(t2, lt_lang_ref(tag->language));
+					    lt_tag_take_language(t2, lt_lang_ref(tag->language));
 					    break;
 				    case STATE_EXTLANG:
 					    lt_tag_free_extlang(t2);
 					    if (tag->extlang) {
-						    lt_tag_set_extlang(t2, lt_extlang_ref(tag->extlang));
+						    lt_tag_take_extlang(t2, lt_extlang_ref(tag->extlang));
 					    }
 					    break;
 				    case STATE_SCRIPT:
 					    lt_tag_free_script(t2);
 					    if (tag->script) {
-						    lt_tag_set_script(t2, lt_script_ref(tag->script));
+						    lt_tag_take_script(t2, lt_script_ref(tag->script));
 					    }
 					    break;
 				    case STATE_REGION:
 					    lt_tag_free_region(t2);
 					    if (tag->region) {
-						    lt_tag_set_region(t2, lt_region_ref(tag->region));
+						    lt_tag_take_region(t2, lt_region_ref(tag->region));
 					    }
 					    break;
 				    case STATE_VARIANT:
 					    lt_tag_free_variants(t2);
 					    l = tag->variants;
 					    while (l != NULL) {
-						    lt_tag_set_variant(t2, lt_variant_ref(l->data));
+						    lt_tag_take_variant(t2, lt_variant_ref(l->data));
 						    l = g_list_next(l);
 					    }
 					    break;
@@ -2004,7 +4461,7 @@ lt_tag_lookup(const lt_tag_t  *tag,
 				    case STATE_EXTENSIONTOKEN2:
 					    lt_tag_free_extension(t2);
 					    if (tag->extension) {
-						    lt_tag_set_extension(t2, lt_extension_ref(tag->extension));
+						    lt_tag_take_extension(t2, lt_extension_ref(tag->extension));
 					    }
 					    break;
 				    case STATE_PRIVATEUSE:
@@ -31,6 +31,7 @@
 #include <liblangtag/lt-extlang.h>
 #include <liblangtag/lt-script.h>
 #include <liblangtag/lt-region.h>
+#include <liblangtag/lt-variant.h>
 #include <liblangtag/lt-extension.h>
 #include <liblangtag/lt-grandfathered.h>
 
@@ -44,13 +45,82 @@ G_BEGIN_DECLS
  */
 typedef struct _lt_tag_t	lt_tag_t;
 
+/**
+ * lt_validation_level_t:
+ * @LT_VALIDATION_WELL_FORMED: the tag is well-formed according to
+ *                             the syntax in RFC 5646.
+ * @LT_VALIDATION_VALID_SUBTAGS: the tag is well-formed and all of subtags
+ *                               are registered.
+ * @LT_VALIDATION_STRICT: the tag is valid as lt_tag_parse() validates,
+ *                        including the variant prefixes and the extensions.
+ *
+ * The level of the validation used in lt_tag_validate().
+ */
+enum _lt_validation_level_t {
+	LT_VALIDATION_WELL_FORMED = 0,
+	LT_VALIDATION_VALID_SUBTAGS,
+	LT_VALIDATION_STRICT
+};
+
+typedef enum _lt_validation_level_t	lt_validation_level_t;
+
+/**
+ * lt_tag_parser_t:
+ * @LT_TAG_PARSER_DEFAULT: the state machine with the fast path for
+ *                         the common tags like "ll-RR" or "ll-Ssss-RR".
+ * @LT_TAG_PARSER_STATE_MACHINE: the state machine only, which looks up
+ *                               the database per subtag.
+ * @LT_TAG_PARSER_DFA: the automaton compiled from the whole of
+ *                     the registry.
+ *
+ * The engine used to parse the tags.
+ */
+enum _lt_tag_parser_t {
+	LT_TAG_PARSER_DEFAULT = 0,
+	LT_TAG_PARSER_STATE_MACHINE,
+	LT_TAG_PARSER_DFA
+};
+
+typedef enum _lt_tag_parser_t		lt_tag_parser_t;
 
+/**
+ * lt_tag_match_flags_t:
+ * @LT_TAG_MATCH_DEFAULT: the extended filtering in RFC 4647.
+ * @LT_TAG_MATCH_REGION_CONTAINMENT: the region in the language range
+ *                                   matches the regions within it as well,
+ *                                   such as "es-419" against "es-MX".
+ *
+ * The options for lt_tag_match_full().
+ */
+enum _lt_tag_match_flags_t {
+	LT_TAG_MATCH_DEFAULT            = 0,
+	LT_TAG_MATCH_REGION_CONTAINMENT = 1 << 0
+};
+
+typedef enum _lt_tag_match_flags_t	lt_tag_match_flags_t;
+
+
+void                      lt_tag_set_parser            (lt_tag_parser_t  parser);
+lt_tag_parser_t           lt_tag_get_parser            (void);
 lt_tag_t                 *lt_tag_new                   (void);
 lt_tag_t                 *lt_tag_ref                   (lt_tag_t        *tag);
 void                      lt_tag_unref                 (lt_tag_t        *tag);
 gboolean                  lt_tag_parse                 (lt_tag_t        *tag,
                                                         const gchar     *tag_string,
                                                         GError         **error);
+gboolean                  lt_tag_parse_len             (lt_tag_t        *tag,
+                                                        const gchar     *tag_string,
+                                                        gssize           length,
+                                                        GError         **error);
+gboolean                  lt_tag_validate              (const gchar     *tag_string,
+                                                        gssize           length,
+                                                        lt_validation_level_t  level,
+                                                        GError         **error);
+gsize                     lt_tag_validate_bulk         (const gchar * const *tag_strings,
+                                                        const gssize    *lengths,
+                                                        gsize            n,
+                                                        lt_validation_level_t  level,
+                                                        gboolean        *results);
 gboolean                  lt_tag_parse_with_extra_token(lt_tag_t        *tag,
                                                         const gchar     *tag_string,
                                                         GError         **error);
@@ -58,21 +128,75 @@ void                      lt_tag_clear                 (lt_tag_t        *tag);
 lt_tag_t                 *lt_tag_copy                  (const lt_tag_t  *tag);
 gboolean                  lt_tag_truncate              (lt_tag_t        *tag,
                                                         GError         **error);
+gboolean                  lt_tag_set_language          (lt_tag_t        *tag,
+                                                        lt_lang_t       *lang,
+                                                        GError         **error);
+gboolean                  lt_tag_set_script            (lt_tag_t        *tag,
+                                                        lt_script_t     *script,
+                                                        GError         **error);
+gboolean                  lt_tag_set_region            (lt_tag_t        *tag,
+                                                        lt_region_t     *region,
+                                                        GError         **error);
+gboolean                  lt_tag_add_variant           (lt_tag_t        *tag,
+                                                        lt_variant_t    *variant,
+                                                        GError         **error);
 const gchar              *lt_tag_get_string            (lt_tag_t        *tag);
+gboolean                  lt_tag_get_string_to_buf     (const lt_tag_t  *tag,
+                                                        gchar           *buf,
+                                                        gsize            cap,
+                                                        gsize           *needed);
+gboolean                  lt_tag_freeze                (lt_tag_t        *tag,
+                                                        GError         **error);
+gboolean                  lt_tag_is_frozen             (const lt_tag_t  *tag);
+lt_tag_t                 *lt_tag_intern                (const gchar     *tag_string,
+                                                        GError         **error);
 gchar                    *lt_tag_canonicalize          (lt_tag_t        *tag,
                                                         GError         **error);
+gboolean                  lt_tag_canonicalize_to_buf   (const lt_tag_t  *tag,
+                                                        gchar           *buf,
+                                                        gsize            cap,
+                                                        gsize           *needed,
+                                                        GError         **error);
+guint                     lt_tag_hash                  (gconstpointer    v);
+gboolean                  lt_tag_equal                 (gconstpointer    v1,
+                                                        gconstpointer    v2);
+guchar                   *lt_tag_encode                (const lt_tag_t  *tag,
+                                                        gsize           *length,
+                                                        GError         **error);
+lt_tag_t                 *lt_tag_decode                (const guchar    *data,
+                                                        gsize            length,
+                                                        GError         **error);
 gchar                    *lt_tag_convert_to_locale     (lt_tag_t        *tag,
                                                         GError         **error);
+gboolean                  lt_tag_convert_to_locale_to_buf(const lt_tag_t  *tag,
+                                                        gchar           *buf,
+                                                        gsize            cap,
+                                                        gsize           *needed,
+                                                        GError         **error);
 lt_tag_t                 *lt_tag_convert_from_locale   (GError         **error);
+lt_tag_t                 *lt_tag_get_thread_locale     (GError         **error);
 void                      lt_tag_dump                  (const lt_tag_t  *tag);
 gboolean                  lt_tag_compare               (const lt_tag_t  *v1,
                                                         const lt_tag_t  *v2);
 gboolean                  lt_tag_match                 (const lt_tag_t  *v1,
                                                         const gchar     *v2,
                                                         GError         **error);
+gboolean                  lt_tag_match_len             (const lt_tag_t  *v1,
+                                                        const gchar     *v2,
+                                                        gssize           length,
+                                                        GError         **error);
+gboolean                  lt_tag_match_full            (const lt_tag_t  *v1,
+                                                        const gchar     *v2,
+                                                        gssize           length,
+                                                        lt_tag_match_flags_t  flags,
+                                                        GError         **error);
 gchar                    *lt_tag_lookup                (const lt_tag_t  *tag,
                                                         const gchar     *pattern,
                                                         GError         **error);
+gchar                    *lt_tag_lookup_len            (const lt_tag_t  *tag,
+                                                        const gchar     *pattern,
+                                                        gssize           length,
+                                                        GError         **error);
 gchar                    *lt_tag_transform             (lt_tag_t        *tag,
                                                         GError         **error);
 const lt_lang_t          *lt_tag_get_language          (const lt_tag_t  *tag);
@@ -24,6 +24,11 @@
 #endif
 
 #include <string.h>
+#if defined (__AVX2__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "lt-utils.h"
 
 
@@ -47,3 +52,189 @@ lt_strlower(gchar *string)
 
 	return string;
 }
+
+/* the same algorithm as g_str_hash() but case-insensitive for ASCII */
+guint
+lt_strcase_hash_update(guint        hash,
+		       const gchar *string,
+		       gsize        length)
+{
+	gsize i;
+
+	for (i = 0; i < length; i++)
+		hash = (hash << 5) + hash + g_ascii_tolower(string[i]);
+
+	return hash;
+}
+
+guint
+lt_strcase_hash(gconstpointer v)
+{
+	const gchar *s = v;
+
+	return lt_strcase_hash_update(5381, s, strlen(s));
+}
+
+gboolean
+lt_strcase_equal(gconstpointer v1,
+		 gconstpointer v2)
+{
+	return g_ascii_strcasecmp(v1, v2) == 0;
+}
+
+/* the portable version of lt_ascii_classify(), which is also used to
+ * verify the results of the SIMD version.
+ */
+gboolean
+lt_ascii_classify_scalar(const gchar *string,
+			 gsize        length,
+			 guint64     *alpha,
+			 guint64     *digit,
+			 guint64     *hyphen)
+{
+	guint64 mask, a = 0, d = 0, h = 0;
+	gsize i;
+
+	if (length > LT_ASCII_CLASSIFY_MAX)
+		return FALSE;
+	mask = length == 64 ? G_MAXUINT64 : (G_GUINT64_CONSTANT (1) << length) - 1;
+
+	for (i = 0; i < length; i++) {
+		guint64 bit = G_GUINT64_CONSTANT (1) << i;
+
+		if (g_ascii_isalpha(string[i]))
+			a |= bit;
+		else if (g_ascii_isdigit(string[i]))
+			d |= bit;
+		else if (string[i] == '-')
+			h |= bit;
+	}
+	*alpha = a;
+	*digit = d;
+	*hyphen = h;
+
+	return (a | d | h) == mask;
+}
+
+/* Classify the characters in @string into the bitmasks, where the bit N
+ * represents string[N]. This works on up to %LT_ASCII_CLASSIFY_MAX bytes.
+ * Returns %FALSE if any characters other than alphabets, digits and hyphen
+ * are found, or @string is too long.
+ */
+gboolean
+lt_ascii_classify(const gchar *string,
+		  gsize        length,
+		  guint64     *alpha,
+		  guint64     *digit,
+		  guint64     *hyphen)
+{
+#if defined (__AVX2__) || defined (__SSE2__)
+	guint64 mask, a = 0, d = 0, h = 0;
+	/* copy into the buffer padded with 0 to not read beyond @length */
+	union {
+		gchar   c[LT_ASCII_CLASSIFY_MAX];
+# if defined (__AVX2__)
+		__m256i v[LT_ASCII_CLASSIFY_MAX / 32];
+# else
+		__m128i v[LT_ASCII_CLASSIFY_MAX / 16];
+# endif
+	} buffer;
+	gsize i;
+
+	if (length > LT_ASCII_CLASSIFY_MAX)
+		return FALSE;
+	mask = length == 64 ? G_MAXUINT64 : (G_GUINT64_CONSTANT (1) << length) - 1;
+
+	memset(&buffer, 0, sizeof (buffer));
+	memcpy(buffer.c, string, length);
+# if defined (__AVX2__)
+	for (i = 0; i * 32 < length; i++) {
+		__m256i v = buffer.v[i];
+		__m256i l = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+		__m256i va, vd, vh;
+
+		va = _mm256_and_si256(_mm256_cmpgt_epi8(l, _mm256_set1_epi8('a' - 1)),
+				      _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), l));
+		vd = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+				      _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+		vh = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-'));
+		a |= (guint64)(guint32)_mm256_movemask_epi8(va) << (i * 32);
+		d |= (guint64)(guint32)_mm256_movemask_epi8(vd) << (i * 32);
+		h |= (guint64)(guint32)_mm256_movemask_epi8(vh) << (i * 32);
+	}
+# else
+	for (i = 0; i * 16 < length; i++) {
+		__m128i v = buffer.v[i];
+		__m128i l = _mm_or_si128(v, _mm_set1_epi8(0x20));
+		__m128i va, vd, vh;
+
+		va = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+				   _mm_cmplt_epi8(l, _mm_set1_epi8('z' + 1)));
+		vd = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+				   _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+		vh = _mm_cmpeq_epi8(v, _mm_set1_epi8('-'));
+		a |= (guint64)_mm_movemask_epi8(va) << (i * 16);
+		d |= (guint64)_mm_movemask_epi8(vd) << (i * 16);
+		h |= (guint64)_mm_movemask_epi8(vh) << (i * 16);
+	}
+# endif
+	*alpha = a & mask;
+	*digit = d & mask;
+	*hyphen = h & mask;
+
+	return (*alpha | *digit | *hyphen) == mask;
+#else
+	return lt_ascii_classify_scalar(string, length, alpha, digit, hyphen);
+#endif
+}
+
+/* Prepend @value to the list for @key in @table, which maps the keys to
+ * the lists of values. call lt_multimap_reverse() once all of the values
+ * are added to have them in the order they were added.
+ */
+void
+lt_multimap_prepend(GHashTable  *table,
+		    const gchar *key,
+		    gpointer     value)
+{
+	gpointer orig_key, l;
+
+	g_return_if_fail (table != NULL);
+	g_return_if_fail (key != NULL);
+
+	if (g_hash_table_lookup_extended(table, key, &orig_key, &l)) {
+		/* don't let @table free the list being updated */
+		g_hash_table_steal(table, key);
+		g_hash_table_insert(table, orig_key, g_list_prepend(l, value));
+	} else {
+		g_hash_table_insert(table, g_strdup(key), g_list_prepend(NULL, value));
+	}
+}
+
+static gboolean
+_lt_multimap_steal_reversed(gpointer key,
+			    gpointer value,
+			    gpointer user_data)
+{
+	GPtrArray *pairs = user_data;
+
+	g_ptr_array_add(pairs, key);
+	g_ptr_array_add(pairs, g_list_reverse(value));
+
+	return TRUE;
+}
+
+void
+lt_multimap_reverse(GHashTable *table)
+{
+	GPtrArray *pairs;
+	guint i;
+
+	g_return_if_fail (table != NULL);
+
+	pairs = g_ptr_array_new();
+	g_hash_table_foreach_steal(table, _lt_multimap_steal_reversed, pairs);
+	for (i = 0; i < pairs->len; i += 2)
+		g_hash_table_insert(table, pairs->pdata[i], pairs->pdata[i + 1]);
+	g_ptr_array_free(pairs, TRUE);
+}
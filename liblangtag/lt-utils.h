@@ -28,8 +28,30 @@ G_BEGIN_DECLS
 
 /* maybe 512 should be enough */
 #define LT_PATH_MAX	512
+/* the maximum length of the string for lt_ascii_classify() */
+#define LT_ASCII_CLASSIFY_MAX	64
 
-gchar *lt_strlower(gchar *string);
+gchar    *lt_strlower              (gchar         *string);
+guint     lt_strcase_hash_update   (guint          hash,
+                                    const gchar   *string,
+                                    gsize          length);
+guint     lt_strcase_hash          (gconstpointer  v);
+gboolean  lt_strcase_equal         (gconstpointer  v1,
+                                    gconstpointer  v2);
+gboolean  lt_ascii_classify        (const gchar   *string,
+                                    gsize          length,
+                                    guint64       *alpha,
+                                    guint64       *digit,
+                                    guint64       *hyphen);
+gboolean  lt_ascii_classify_scalar (const gchar   *string,
+                                    gsize          length,
+                                    guint64       *alpha,
+                                    guint64       *digit,
+                                    guint64       *hyphen);
+void      lt_multimap_prepend      (GHashTable    *table,
+                                    const gchar   *key,
+                                    gpointer       value);
+void      lt_multimap_reverse      (GHashTable    *table);
 
 G_END_DECLS
 
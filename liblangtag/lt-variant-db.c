@@ -24,6 +24,8 @@
 #endif
 
 #include <libxml/xpath.h>
+#include "lt-database-private.h"
+#include "lt-description-index.h"
 #include "lt-error.h"
 #include "lt-variant.h"
 #include "lt-variant-private.h"
@@ -42,11 +44,14 @@
  * registered with IANA.
  */
 struct _lt_variant_db_t {
-	lt_mem_t    parent;
-	lt_xml_t   *xml;
-	GHashTable *variant_entries;
+	lt_mem_t                parent;
+	lt_xml_t               *xml;
+	GHashTable             *variant_entries;
+	lt_description_index_t *search_index;
 };
 
+G_LOCK_DEFINE_STATIC (lt_variant_db_search);
+
 /*< private >*/
 static gboolean
 lt_variant_db_parse(lt_variant_db_t  *variantdb,
@@ -149,6 +154,7 @@ lt_variant_db_parse(lt_variant_db_t  *variantdb,
 		if (preferred)
 			lt_variant_set_preferred_tag(le, (const gchar *)preferred);
 
+		le = lt_db_share_entry(ent, le);
 		s = g_strdup(lt_variant_get_tag(le));
 		g_hash_table_replace(variantdb->variant_entries,
 				     lt_strlower(s),
@@ -197,8 +203,8 @@ lt_variant_db_new(void)
 		GError *err = NULL;
 		lt_variant_t *le;
 
-		retval->variant_entries = g_hash_table_new_full(g_str_hash,
-								g_str_equal,
+		retval->variant_entries = g_hash_table_new_full(lt_strcase_hash,
+								lt_strcase_equal,
 								g_free,
 								(GDestroyNotify)lt_variant_unref);
 		lt_mem_add_ref(&retval->parent, retval->variant_entries,
@@ -284,17 +290,52 @@ lt_variant_db_lookup(lt_variant_db_t *variantdb,
 		     const gchar     *subtag)
 {
 	lt_variant_t *retval;
-	gchar *s;
 
 	g_return_val_if_fail (variantdb != NULL, NULL);
 	g_return_val_if_fail (subtag != NULL, NULL);
 
-	s = g_strdup(subtag);
-	retval = g_hash_table_lookup(variantdb->variant_entries,
-				     lt_strlower(s));
-	g_free(s);
+	retval = g_hash_table_lookup(variantdb->variant_entries, subtag);
 	if (retval)
 		return lt_variant_ref(retval);
 
 	return NULL;
 }
+
+/**
+ * lt_variant_db_search:
+ * @variantdb: a #lt_variant_db_t.
+ * @query: the words to search for in the descriptions, such as "Rozaj".
+ * @prefix: %TRUE to match the words starting with the words in @query,
+ *          otherwise only the whole words match.
+ *
+ * Search #lt_variant_t whose description contains all of the words in @query.
+ * the words are compared case-insensitively. the index for the search is
+ * built from the database at the first call.
+ *
+ * Returns: (element-type lt_variant_t) (transfer full): a list of #lt_variant_t
+ *          in the order of the registry, or %NULL if nothing matched.
+ *          the elements have to be freed with lt_variant_unref() and
+ *          the list with g_list_free().
+ */
+GList *
+lt_variant_db_search(lt_variant_db_t *variantdb,
+		     const gchar     *query,
+		     gboolean         prefix)
+{
+	g_return_val_if_fail (variantdb != NULL, NULL);
+	g_return_val_if_fail (query != NULL, NULL);
+
+	G_LOCK (lt_variant_db_search);
+	if (!variantdb->search_index) {
+		variantdb->search_index = lt_description_index_new(variantdb->xml, "variant");
+		if (variantdb->search_index)
+			lt_mem_add_ref(&variantdb->parent, variantdb->search_index,
+				       (lt_destroy_func_t)lt_description_index_unref);
+	}
+	G_UNLOCK (lt_variant_db_search);
+	if (!variantdb->search_index)
+		return NULL;
+
+	return lt_description_index_search(variantdb->search_index, query, prefix,
+					   variantdb->variant_entries);
+}
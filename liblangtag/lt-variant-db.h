@@ -45,6 +45,9 @@ lt_variant_db_t *lt_variant_db_ref   (lt_variant_db_t *variantdb);
 void             lt_variant_db_unref (lt_variant_db_t *variantdb);
 lt_variant_t    *lt_variant_db_lookup(lt_variant_db_t *variantdb,
                                       const gchar     *subtag);
+GList           *lt_variant_db_search(lt_variant_db_t *variantdb,
+                                      const gchar     *query,
+                                      gboolean         prefix);
 
 G_END_DECLS
 
@@ -28,6 +28,7 @@
 #include "lt-error.h"
 #include "lt-mem.h"
 #include "lt-database.h"
+#include "lt-database-private.h"
 #include "lt-xml.h"
 
 
@@ -42,6 +43,8 @@ struct _lt_xml_t {
 	xmlDocPtr cldr_bcp47_transform;
 	xmlDocPtr cldr_bcp47_variant;
 	xmlDocPtr cldr_supplemental_likelysubtags;
+	xmlDocPtr cldr_supplemental_data;
+	xmlDocPtr cldr_supplemental_languageinfo;
 };
 
 static lt_xml_t *__xml = NULL;
@@ -166,11 +169,12 @@ lt_xml_read_cldr_bcp47(lt_xml_t     *xml,
 static gboolean
 lt_xml_read_cldr_supplemental(lt_xml_t     *xml,
 			      const gchar  *filename,
+			      gboolean      optional,
 			      xmlDocPtr    *doc,
 			      GError      **error)
 {
 	gchar *regfile = NULL;
-	xmlParserCtxtPtr xmlparser;
+	xmlParserCtxtPtr xmlparser = NULL;
 	GError *err = NULL;
 
 	g_return_val_if_fail (xml != NULL, FALSE);
@@ -184,6 +188,10 @@ lt_xml_read_cldr_supplemental(lt_xml_t     *xml,
 #ifdef GNOME_ENABLE_DEBUG
 	}
 #endif
+	if (optional && !g_file_test(regfile, G_FILE_TEST_EXISTS)) {
+		*doc = NULL;
+		goto bail;
+	}
 	xmlparser = xmlNewParserCtxt();
 	if (!xmlparser) {
 		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
@@ -220,11 +228,90 @@ lt_xml_read_cldr_supplemental(lt_xml_t     *xml,
 	return TRUE;
 }
 
+/*< protected >*/
+/* Load a new instance from the files in lt_db_get_datadir(). */
+lt_xml_t *
+lt_xml_load(GError **error)
+{
+	lt_xml_t *retval = lt_mem_alloc_object(sizeof (lt_xml_t));
+	GError *err = NULL;
+
+	if (!retval) {
+		g_set_error(&err, LT_ERROR, LT_ERR_OOM,
+			    "Unable to allocate memory for lt_xml_t.");
+		goto bail;
+	}
+	if (!lt_xml_read_subtag_registry(retval, &err))
+		goto bail;
+	if (!lt_xml_read_cldr_bcp47(retval, "calendar.xml",
+				    &retval->cldr_bcp47_calendar,
+				    &err))
+		goto bail;
+	if (!lt_xml_read_cldr_bcp47(retval, "collation.xml",
+				    &retval->cldr_bcp47_collation,
+				    &err))
+		goto bail;
+	if (!lt_xml_read_cldr_bcp47(retval, "currency.xml",
+				    &retval->cldr_bcp47_currency,
+				    &err))
+		goto bail;
+	if (!lt_xml_read_cldr_bcp47(retval, "number.xml",
+				    &retval->cldr_bcp47_number,
+				    &err))
+		goto bail;
+	if (!lt_xml_read_cldr_bcp47(retval, "timezone.xml",
+				    &retval->cldr_bcp47_timezone,
+				    &err))
+		goto bail;
+	if (!lt_xml_read_cldr_bcp47(retval, "transform.xml",
+				    &retval->cldr_bcp47_transform,
+				    &err))
+		goto bail;
+	if (!lt_xml_read_cldr_bcp47(retval, "variant.xml",
+				    &retval->cldr_bcp47_variant,
+				    &err))
+		goto bail;
+	if (!lt_xml_read_cldr_supplemental(retval, "likelySubtags.xml", FALSE,
+					   &retval->cldr_supplemental_likelysubtags,
+					   &err))
+		goto bail;
+	/* only the region containment and the parent locales are in it */
+	if (!lt_xml_read_cldr_supplemental(retval, "supplementalData.xml", TRUE,
+					   &retval->cldr_supplemental_data,
+					   &err))
+		goto bail;
+	if (!lt_xml_read_cldr_supplemental(retval, "languageInfo.xml", FALSE,
+					   &retval->cldr_supplemental_languageinfo,
+					   &err))
+		goto bail;
+
+  bail:
+	if (err) {
+		if (error)
+			*error = g_error_copy(err);
+		else
+			g_warning(err->message);
+		g_error_free(err);
+		lt_xml_unref(retval);
+		retval = NULL;
+	}
+
+	return retval;
+}
+
 /*< public >*/
 lt_xml_t *
 lt_xml_new(void)
 {
-	GError *err = NULL;
+	lt_db_snapshot_t *snapshot = lt_db_ref_snapshot();
+	lt_xml_t *retval;
+
+	if (snapshot) {
+		retval = lt_db_snapshot_get_xml(snapshot);
+		lt_db_snapshot_unref(snapshot);
+
+		return retval;
+	}
 
 	G_LOCK (lt_xml);
 
@@ -234,51 +321,9 @@ lt_xml_new(void)
 		return lt_xml_ref(__xml);
 	}
 
-	__xml = lt_mem_alloc_object(sizeof (lt_xml_t));
-	if (__xml) {
+	__xml = lt_xml_load(NULL);
+	if (__xml)
 		lt_mem_add_weak_pointer(&__xml->parent, (gpointer *)&__xml);
-		if (!lt_xml_read_subtag_registry(__xml, &err))
-			goto bail;
-		if (!lt_xml_read_cldr_bcp47(__xml, "calendar.xml",
-					    &__xml->cldr_bcp47_calendar,
-					    &err))
-			goto bail;
-		if (!lt_xml_read_cldr_bcp47(__xml, "collation.xml",
-					    &__xml->cldr_bcp47_collation,
-					    &err))
-			goto bail;
-		if (!lt_xml_read_cldr_bcp47(__xml, "currency.xml",
-					    &__xml->cldr_bcp47_currency,
-					    &err))
-			goto bail;
-		if (!lt_xml_read_cldr_bcp47(__xml, "number.xml",
-					    &__xml->cldr_bcp47_number,
-					    &err))
-			goto bail;
-		if (!lt_xml_read_cldr_bcp47(__xml, "timezone.xml",
-					    &__xml->cldr_bcp47_timezone,
-					    &err))
-			goto bail;
-		if (!lt_xml_read_cldr_bcp47(__xml, "transform.xml",
-					    &__xml->cldr_bcp47_transform,
-					    &err))
-			goto bail;
-		if (!lt_xml_read_cldr_bcp47(__xml, "variant.xml",
-					    &__xml->cldr_bcp47_variant,
-					    &err))
-			goto bail;
-		if (!lt_xml_read_cldr_supplemental(__xml, "likelySubtags.xml",
-						   &__xml->cldr_supplemental_likelysubtags,
-						   &err))
-			goto bail;
-	}
-
-  bail:
-	if (err) {
-		g_warning(err->message);
-		g_error_free(err);
-		lt_xml_unref(__xml);
-	}
 
 	G_UNLOCK (lt_xml);
 
@@ -331,6 +376,10 @@ lt_xml_get_cldr(lt_xml_t      *xml,
 		    return xml->cldr_bcp47_variant;
 	    case LT_XML_CLDR_SUPPLEMENTAL_LIKELY_SUBTAGS:
 		    return xml->cldr_supplemental_likelysubtags;
+	    case LT_XML_CLDR_SUPPLEMENTAL_DATA:
+		    return xml->cldr_supplemental_data;
+	    case LT_XML_CLDR_SUPPLEMENTAL_LANGUAGE_INFO:
+		    return xml->cldr_supplemental_languageinfo;
 	    default:
 		    break;
 	}
@@ -40,11 +40,14 @@ typedef enum _lt_xml_cldr_t {
 	LT_XML_CLDR_BCP47_BEGIN = LT_XML_CLDR_BCP47_CALENDAR,
 	LT_XML_CLDR_BCP47_END = LT_XML_CLDR_BCP47_VARIANT,
 	LT_XML_CLDR_SUPPLEMENTAL_LIKELY_SUBTAGS,
+	LT_XML_CLDR_SUPPLEMENTAL_DATA,
+	LT_XML_CLDR_SUPPLEMENTAL_LANGUAGE_INFO,
 	LT_XML_CLDR_SUPPLEMENTAL_BEGIN = LT_XML_CLDR_SUPPLEMENTAL_LIKELY_SUBTAGS,
-	LT_XML_CLDR_SUPPLEMENTAL_END = LT_XML_CLDR_SUPPLEMENTAL_LIKELY_SUBTAGS,
+	LT_XML_CLDR_SUPPLEMENTAL_END = LT_XML_CLDR_SUPPLEMENTAL_LANGUAGE_INFO,
 	LT_XML_CLDR_END
 } lt_xml_cldr_t;
 
+lt_xml_t        *lt_xml_load               (GError       **error);
 lt_xml_t        *lt_xml_new                (void);
 lt_xml_t        *lt_xml_ref                (lt_xml_t      *xml);
 void             lt_xml_unref              (lt_xml_t      *xml);
@@ -0,0 +1,336 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * check-database.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <liblangtag/langtag.h>
+#include "main.h"
+
+/* protected in liblangtag; pinned by lt_tag_parse() and so on */
+lt_db_snapshot_t *lt_db_pin_snapshot  (void);
+void              lt_db_unpin_snapshot(lt_db_snapshot_t *snapshot);
+
+/************************************************************/
+/* common functions                                         */
+/************************************************************/
+void
+setup(void)
+{
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+}
+
+void
+teardown(void)
+{
+	lt_db_finalize();
+}
+
+/* Write the registry in TEST_DATADIR into @datadir, with the description
+ * of "en" replaced with @name.
+ */
+static gboolean
+_write_registry(const gchar *datadir,
+		const gchar *name)
+{
+	static const gchar *desc = "<description>English</description>";
+	gchar *path, *contents, *p, *s;
+	gboolean retval = FALSE;
+
+	path = g_build_filename(TEST_DATADIR, "language-subtag-registry.xml", NULL);
+	if (!g_file_get_contents(path, &contents, NULL, NULL)) {
+		g_free(path);
+		return FALSE;
+	}
+	g_free(path);
+	p = strstr(contents, desc);
+	if (p) {
+		*p = 0;
+		s = g_strdup_printf("%s<description>%s</description>%s",
+				    contents, name, p + strlen(desc));
+		path = g_build_filename(datadir, "language-subtag-registry.xml", NULL);
+		retval = g_file_set_contents(path, s, -1, NULL);
+		g_free(path);
+		g_free(s);
+	}
+	g_free(contents);
+
+	return retval;
+}
+
+/* Create the data directory which refers to TEST_DATADIR except
+ * the registry, where the description of "en" is @name.
+ */
+static gchar *
+_create_datadir(const gchar *name)
+{
+	gchar *datadir = g_build_filename(g_get_tmp_dir(), "check-database-XXXXXX", NULL);
+	gchar *path, *src;
+
+	if (!mkdtemp(datadir)) {
+		g_free(datadir);
+		return NULL;
+	}
+	src = g_build_filename(TEST_DATADIR, "common", NULL);
+	path = g_build_filename(datadir, "common", NULL);
+	if (symlink(src, path) != 0)
+		g_warning("Unable to create a symlink: %s", path);
+	g_free(path);
+	g_free(src);
+	if (!_write_registry(datadir, name))
+		g_warning("Unable to write the registry into %s", datadir);
+
+	return datadir;
+}
+
+static void
+_remove_datadir(gchar *datadir)
+{
+	gchar *path;
+
+	path = g_build_filename(datadir, "language-subtag-registry.xml", NULL);
+	g_unlink(path);
+	g_free(path);
+	path = g_build_filename(datadir, "common", NULL);
+	g_unlink(path);
+	g_free(path);
+	g_rmdir(datadir);
+	g_free(datadir);
+}
+
+static lt_lang_t *
+_lookup_lang(lt_db_snapshot_t *snapshot,
+	     const gchar      *subtag)
+{
+	lt_lang_db_t *db;
+	lt_lang_t *retval;
+
+	lt_db_set_snapshot(snapshot);
+	db = lt_db_get_lang();
+	retval = lt_lang_db_lookup(db, subtag);
+	lt_lang_db_unref(db);
+	lt_db_set_snapshot(NULL);
+
+	return retval;
+}
+
+/************************************************************/
+/* Test cases                                               */
+TDEF (lt_db_snapshot_new) {
+	lt_db_snapshot_t *snapshot;
+	GError *err = NULL;
+
+	snapshot = lt_db_snapshot_new(TEST_DATADIR, &err);
+	fail_unless(snapshot != NULL, "Unable to load the snapshot: %s", err ? err->message : "");
+	fail_unless(g_strcmp0(lt_db_snapshot_get_datadir(snapshot), TEST_DATADIR) == 0,
+		    "Unexpected datadir: '%s'", lt_db_snapshot_get_datadir(snapshot));
+	fail_unless(lt_db_get_snapshot() == NULL, "No snapshot is expected to be used after loading.");
+	lt_db_snapshot_unref(snapshot);
+
+	snapshot = lt_db_snapshot_new(TEST_DATADIR "/nonexistent", &err);
+	fail_unless(snapshot == NULL, "Loading from the nonexistent directory is expected to fail.");
+	fail_unless(err != NULL, "No error is reported.");
+	g_error_free(err);
+} TEND
+
+TDEF (lt_db_set_snapshot) {
+	lt_db_snapshot_t *snapshot = lt_db_snapshot_new(TEST_DATADIR, NULL);
+	lt_tag_t *t;
+	gchar *s;
+
+	fail_unless(snapshot != NULL, "Unable to load the snapshot.");
+	lt_db_set_snapshot(snapshot);
+	fail_unless(lt_db_get_snapshot() == snapshot, "The snapshot isn't used.");
+	fail_unless(g_strcmp0(lt_db_get_datadir(), TEST_DATADIR) == 0,
+		    "Unexpected datadir: '%s'", lt_db_get_datadir());
+	t = lt_tag_new();
+	fail_unless(lt_tag_parse(t, "iw-Hebr-IL", NULL), "Unable to parse 'iw-Hebr-IL'.");
+	s = lt_tag_canonicalize(t, NULL);
+	fail_unless(g_strcmp0(s, "he-IL") == 0, "Unexpected canonicalized tag: '%s'", s);
+	g_free(s);
+	lt_tag_unref(t);
+	lt_db_set_snapshot(NULL);
+	fail_unless(lt_db_get_snapshot() == NULL, "The default database isn't used.");
+	lt_db_snapshot_unref(snapshot);
+} TEND
+
+TDEF (lt_db_snapshot_share_entries) {
+	gchar *datadir = _create_datadir("English (modified)");
+	lt_db_snapshot_t *s1, *s2;
+	lt_lang_t *l1, *l2;
+
+	fail_unless(datadir != NULL, "Unable to create the data directory.");
+	s1 = lt_db_snapshot_new(TEST_DATADIR, NULL);
+	s2 = lt_db_snapshot_new(datadir, NULL);
+	fail_unless(s1 != NULL && s2 != NULL, "Unable to load the snapshots.");
+	l1 = _lookup_lang(s1, "ja");
+	l2 = _lookup_lang(s2, "ja");
+	fail_unless(l1 != NULL && l1 == l2, "The identical entries are expected to be shared.");
+	lt_lang_unref(l1);
+	lt_lang_unref(l2);
+	l1 = _lookup_lang(s1, "en");
+	l2 = _lookup_lang(s2, "en");
+	fail_unless(l1 != NULL && l2 != NULL && l1 != l2, "The modified entry isn't expected to be shared.");
+	fail_unless(g_strcmp0(lt_lang_get_name(l1), "English") == 0,
+		    "Unexpected name: '%s'", lt_lang_get_name(l1));
+	fail_unless(g_strcmp0(lt_lang_get_name(l2), "English (modified)") == 0,
+		    "Unexpected name: '%s'", lt_lang_get_name(l2));
+	lt_lang_unref(l1);
+	lt_lang_unref(l2);
+	lt_db_snapshot_unref(s1);
+	lt_db_snapshot_unref(s2);
+	_remove_datadir(datadir);
+} TEND
+
+TDEF (lt_db_reload) {
+	lt_lang_db_t *db1, *db2;
+	lt_tag_t *t;
+	GError *err = NULL;
+
+	db1 = lt_db_get_lang();
+	fail_unless(lt_db_reload(&err), "Unable to reload the databases: %s", err ? err->message : "");
+	db2 = lt_db_get_lang();
+	fail_unless(db1 != db2, "The databases are expected to be replaced.");
+	lt_lang_db_unref(db1);
+	lt_lang_db_unref(db2);
+	t = lt_tag_new();
+	fail_unless(lt_tag_parse(t, "ja-JP", NULL), "Unable to parse 'ja-JP' after reloading.");
+	lt_tag_unref(t);
+#ifdef HAVE_SYS_INOTIFY_H
+	fail_unless(lt_db_enable_auto_reload(NULL), "Unable to watch the databases.");
+	fail_unless(lt_db_enable_auto_reload(NULL), "Enabling twice is expected to succeed.");
+	lt_db_disable_auto_reload();
+#endif
+} TEND
+
+TDEF (lt_db_pin_snapshot) {
+	gchar *datadir = _create_datadir("English");
+	lt_db_snapshot_t *pinned;
+	lt_lang_db_t *db1, *db2;
+	lt_tag_t *t;
+
+	fail_unless(datadir != NULL, "Unable to create the data directory.");
+	lt_db_finalize();
+	lt_db_set_datadir(datadir);
+	lt_db_initialize();
+	fail_unless(lt_db_reload(NULL), "Unable to reload the databases.");
+	pinned = lt_db_pin_snapshot();
+	fail_unless(pinned != NULL, "Unable to pin the published databases.");
+	fail_unless(lt_db_pin_snapshot() == NULL, "Pinning twice isn't expected to take another snapshot.");
+	db1 = lt_db_get_lang();
+	fail_unless(_write_registry(datadir, "English (reloaded)"), "Unable to update the registry.");
+	fail_unless(lt_db_reload(NULL), "Unable to reload the databases.");
+	db2 = lt_db_get_lang();
+	fail_unless(db1 == db2, "The pinned databases are expected to be kept over reloading.");
+	lt_lang_db_unref(db2);
+	t = lt_tag_new();
+	fail_unless(lt_tag_parse(t, "en-US", NULL), "Unable to parse 'en-US'.");
+	fail_unless(g_strcmp0(lt_lang_get_name(lt_tag_get_language(t)), "English") == 0,
+		    "The tag is expected to be parsed with the pinned databases: '%s'",
+		    lt_lang_get_name(lt_tag_get_language(t)));
+	lt_db_unpin_snapshot(pinned);
+	fail_unless(g_strcmp0(lt_lang_get_name(lt_tag_get_language(t)), "English") == 0,
+		    "The parsed tag is expected to keep the entries: '%s'",
+		    lt_lang_get_name(lt_tag_get_language(t)));
+	lt_tag_unref(t);
+	db2 = lt_db_get_lang();
+	fail_unless(db1 != db2, "The databases reloaded meanwhile are expected to be used after unpinning.");
+	t = lt_tag_new();
+	fail_unless(lt_tag_parse(t, "en-US", NULL), "Unable to parse 'en-US'.");
+	fail_unless(g_strcmp0(lt_lang_get_name(lt_tag_get_language(t)), "English (reloaded)") == 0,
+		    "The tag is expected to be parsed with the reloaded databases: '%s'",
+		    lt_lang_get_name(lt_tag_get_language(t)));
+	lt_tag_unref(t);
+	lt_lang_db_unref(db1);
+	lt_lang_db_unref(db2);
+	lt_db_finalize();
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+	_remove_datadir(datadir);
+} TEND
+
+#ifdef HAVE_SYS_INOTIFY_H
+TDEF (lt_db_auto_reload) {
+	gchar *datadir = _create_datadir("English");
+	lt_lang_db_t *db1, *db2 = NULL;
+	lt_lang_t *l;
+	gint i;
+
+	fail_unless(datadir != NULL, "Unable to create the data directory.");
+	lt_db_finalize();
+	lt_db_set_datadir(datadir);
+	lt_db_initialize();
+	fail_unless(lt_db_enable_auto_reload(NULL), "Unable to watch the databases.");
+	db1 = lt_db_get_lang();
+	fail_unless(_write_registry(datadir, "English (reloaded)"), "Unable to update the registry.");
+	/* the reload is delayed until the files are settled down */
+	for (i = 0; i < 100; i++) {
+		db2 = lt_db_get_lang();
+		if (db2 != db1)
+			break;
+		lt_lang_db_unref(db2);
+		db2 = NULL;
+		g_usleep(100000);
+	}
+	fail_unless(db2 != NULL, "The databases aren't reloaded.");
+	l = lt_lang_db_lookup(db2, "en");
+	fail_unless(g_strcmp0(lt_lang_get_name(l), "English (reloaded)") == 0,
+		    "Unexpected name: '%s'", lt_lang_get_name(l));
+	lt_lang_unref(l);
+	lt_lang_db_unref(db1);
+	lt_lang_db_unref(db2);
+	lt_db_finalize();
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+	_remove_datadir(datadir);
+} TEND
+#endif
+
+/************************************************************/
+Suite *
+tester_suite(void)
+{
+	Suite *s = suite_create("lt_db_snapshot_t");
+	TCase *tc = tcase_create("Basic functionality");
+
+	tcase_add_checked_fixture(tc, setup, teardown);
+
+	T (lt_db_snapshot_new);
+	T (lt_db_set_snapshot);
+	T (lt_db_snapshot_share_entries);
+	T (lt_db_reload);
+	T (lt_db_pin_snapshot);
+#ifdef HAVE_SYS_INOTIFY_H
+	T (lt_db_auto_reload);
+#endif
+
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -70,6 +70,19 @@ TDEF (lt_extlang_compare) {
 	lt_extlang_unref(e1);
 } TEND
 
+TDEF (lt_extlang_db_lookup_by_prefix) {
+	const GList *l;
+	gboolean found = FALSE;
+
+	for (l = lt_extlang_db_lookup_by_prefix(db, "zh"); l != NULL; l = g_list_next(l)) {
+		if (g_strcmp0(lt_extlang_get_tag(l->data), "yue") == 0)
+			found = TRUE;
+		fail_unless(g_strcmp0(lt_extlang_get_tag(l->data), "hks") != 0, "'hks' has 'sgn' as the prefix");
+	}
+	fail_unless(found, "No expected extlang found: 'yue'");
+	fail_unless(lt_extlang_db_lookup_by_prefix(db, "en") == NULL, "No extlangs expected for 'en'");
+} TEND
+
 /************************************************************/
 Suite *
 tester_suite(void)
@@ -80,6 +93,7 @@ tester_suite(void)
 	tcase_add_checked_fixture(tc, setup, teardown);
 
 	T (lt_extlang_compare);
+	T (lt_extlang_db_lookup_by_prefix);
 
 	suite_add_tcase(s, tc);
 
@@ -0,0 +1,94 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * check-fallback-iter.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <liblangtag/langtag.h>
+#include "main.h"
+
+/************************************************************/
+/* common functions                                         */
+/************************************************************/
+void
+setup(void)
+{
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+}
+
+void
+teardown(void)
+{
+	lt_db_finalize();
+}
+
+/************************************************************/
+/* Test cases                                               */
+/************************************************************/
+TDEF (lt_fallback_iter_next) {
+	static const struct {
+		const gchar *tag;
+		const gchar *chain[8];
+	} tests[] = {
+		{ "zh-Hant-HK", { "zh-Hant-HK", "zh-Hant", "root", NULL } },
+		{ "pt-AO", { "pt-AO", "pt-PT", "pt", "root", NULL } },
+		{ "en_US", { "en-US", "en", "root", NULL } },
+		{ "de-DE-u-co-phonebk-x-foo", { "de-DE", "de", "root", NULL } },
+		{ "", { "root", NULL } },
+		{ NULL, { NULL } }
+	};
+	lt_fallback_iter_t iter;
+	const gchar *s;
+	gint i, j;
+
+	for (i = 0; tests[i].tag != NULL; i++) {
+		lt_fallback_iter_init(&iter, tests[i].tag);
+		for (j = 0; tests[i].chain[j] != NULL; j++) {
+			s = lt_fallback_iter_next(&iter);
+			fail_unless(g_strcmp0(s, tests[i].chain[j]) == 0,
+				    "Unexpected fallback for '%s' at %d: expected '%s' but '%s'",
+				    tests[i].tag, j, tests[i].chain[j], s);
+		}
+		s = lt_fallback_iter_next(&iter);
+		fail_unless(s == NULL, "No more fallbacks expected for '%s': '%s'", tests[i].tag, s);
+		lt_fallback_iter_finish(&iter);
+	}
+} TEND
+
+/************************************************************/
+Suite *
+tester_suite(void)
+{
+	Suite *s = suite_create("lt_fallback_iter_t");
+	TCase *tc = tcase_create("Basic functionality");
+
+	tcase_add_checked_fixture(tc, setup, teardown);
+
+	T (lt_fallback_iter_next);
+
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -69,6 +69,63 @@ TDEF (lt_lang_compare) {
 	lt_lang_unref(e1);
 } TEND
 
+TDEF (lt_lang_db_search) {
+	GList *l, *ll;
+	gboolean found = FALSE;
+
+	l = lt_lang_db_search(db, "swiss GERMAN", FALSE);
+	fail_unless(l != NULL, "No expected lang found: 'Swiss German'");
+	for (ll = l; ll != NULL; ll = g_list_next(ll)) {
+		if (g_strcmp0(lt_lang_get_tag(ll->data), "gsw") == 0)
+			found = TRUE;
+		lt_lang_unref(ll->data);
+	}
+	g_list_free(l);
+	fail_unless(found, "No expected lang found: 'gsw'");
+
+	/* not only the first description */
+	l = lt_lang_db_search(db, "alsat", TRUE);
+	fail_unless(l != NULL, "No expected lang found: 'alsat'");
+	fail_unless(g_strcmp0(lt_lang_get_tag(l->data), "gsw") == 0, "Unexpected lang found: '%s'", lt_lang_get_tag(l->data));
+	for (ll = l; ll != NULL; ll = g_list_next(ll))
+		lt_lang_unref(ll->data);
+	g_list_free(l);
+
+	l = lt_lang_db_search(db, "alsat", FALSE);
+	fail_unless(l == NULL, "No lang expected for the partial word without prefix search");
+	l = lt_lang_db_search(db, "", TRUE);
+	fail_unless(l == NULL, "No lang expected for the empty query");
+} TEND
+
+TDEF (lt_lang_db_lookup_macrolanguage_members) {
+	const GList *l;
+	gboolean cmn = FALSE, yue = FALSE;
+
+	for (l = lt_lang_db_lookup_macrolanguage_members(db, "ZH"); l != NULL; l = g_list_next(l)) {
+		const gchar *tag = lt_lang_get_tag(l->data);
+
+		fail_unless(g_strcmp0(lt_lang_get_macro_language(l->data), "zh") == 0, "Unexpected macrolanguage for '%s'", tag);
+		if (g_strcmp0(tag, "cmn") == 0)
+			cmn = TRUE;
+		if (g_strcmp0(tag, "yue") == 0)
+			yue = TRUE;
+	}
+	fail_unless(cmn && yue, "No expected members found: 'cmn', 'yue'");
+	fail_unless(lt_lang_db_lookup_macrolanguage_members(db, "ja") == NULL, "'ja' isn't a macrolanguage");
+} TEND
+
+TDEF (lt_lang_db_lookup_by_suppress_script) {
+	const GList *l;
+	gboolean found = FALSE;
+
+	for (l = lt_lang_db_lookup_by_suppress_script(db, "latn"); l != NULL; l = g_list_next(l)) {
+		if (g_strcmp0(lt_lang_get_tag(l->data), "en") == 0)
+			found = TRUE;
+		fail_unless(g_strcmp0(lt_lang_get_tag(l->data), "ja") != 0, "'ja' doesn't suppress 'Latn'");
+	}
+	fail_unless(found, "No expected lang found: 'en'");
+} TEND
+
 /************************************************************/
 Suite *
 tester_suite(void)
@@ -79,6 +136,9 @@ tester_suite(void)
 	tcase_add_checked_fixture(tc, setup, teardown);
 
 	T (lt_lang_compare);
+	T (lt_lang_db_lookup_macrolanguage_members);
+	T (lt_lang_db_lookup_by_suppress_script);
+	T (lt_lang_db_search);
 
 	suite_add_tcase(s, tc);
 
@@ -0,0 +1,135 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * check-lookup-table.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <liblangtag/langtag.h>
+#include "main.h"
+
+/************************************************************/
+/* common functions                                         */
+/************************************************************/
+void
+setup(void)
+{
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+}
+
+void
+teardown(void)
+{
+	lt_db_finalize();
+}
+
+/************************************************************/
+/* Test cases                                               */
+/************************************************************/
+TDEF (lt_lookup_table_add) {
+	lt_lookup_table_t *t = lt_lookup_table_new();
+	GError *err = NULL;
+
+	fail_unless(t != NULL, "Unable to create the instance.");
+	fail_unless(lt_lookup_table_add(t, "zh-Hant", NULL), "Unable to add 'zh-Hant'");
+	fail_unless(lt_lookup_table_add(t, "ZH-hant", NULL), "Unable to add 'ZH-hant'");
+	fail_unless(lt_lookup_table_size(t) == 1, "The tags differing in case only are expected to be the same.");
+	fail_unless(!lt_lookup_table_add(t, "en-US-Latn", &err), "'en-US-Latn' is expected to be invalid.");
+	fail_unless(err != NULL, "No errors for 'en-US-Latn'");
+	g_error_free(err);
+	fail_unless(lt_lookup_table_size(t) == 1, "Invalid tags aren't expected to be added.");
+	fail_unless(lt_lookup_table_add(t, "iw", NULL), "Unable to add 'iw'");
+	fail_unless(lt_lookup_table_add(t, "he", NULL), "Unable to add 'he'");
+	fail_unless(lt_lookup_table_size(t) == 2, "The tags canonicalized to the same one are expected to be the same.");
+	lt_lookup_table_unref(t);
+} TEND
+
+TDEF (lt_lookup_table_lookup) {
+	static const gchar *supported[] = { "zh", "zh-Hant", "de-DE", "en", "fr-CA", "iw", NULL };
+	static const gchar *ranges1[] = { "zh-Hant-CN-x-private1-private2", NULL };
+	static const gchar *ranges2[] = { "de-CH-1996", "fr-CA-u-ca-gregory", NULL };
+	static const gchar *ranges3[] = { "*", "DE-de", NULL };
+	static const gchar *ranges4[] = { "ja-JP", "ko", NULL };
+	static const gchar *ranges5[] = { "en-*-US", NULL };
+	static const gchar *ranges6[] = { "he-IL", NULL };
+	lt_lookup_table_t *t = lt_lookup_table_new();
+	const gchar *s;
+	gint i;
+
+	for (i = 0; supported[i] != NULL; i++) {
+		fail_unless(lt_lookup_table_add(t, supported[i], NULL), "Unable to add '%s'", supported[i]);
+	}
+	s = lt_lookup_table_lookup(t, ranges1, NULL);
+	fail_unless(g_strcmp0(s, "zh-Hant") == 0, "Unexpected result: '%s'", s);
+	s = lt_lookup_table_lookup(t, ranges2, NULL);
+	fail_unless(g_strcmp0(s, "fr-CA") == 0, "Unexpected result: '%s'", s);
+	s = lt_lookup_table_lookup(t, ranges3, NULL);
+	fail_unless(g_strcmp0(s, "de-DE") == 0, "Unexpected result: '%s'", s);
+	s = lt_lookup_table_lookup(t, ranges4, "en");
+	fail_unless(g_strcmp0(s, "en") == 0, "The default value is expected: '%s'", s);
+	s = lt_lookup_table_lookup(t, ranges4, NULL);
+	fail_unless(s == NULL, "No matches are expected: '%s'", s);
+	s = lt_lookup_table_lookup(t, ranges5, NULL);
+	fail_unless(g_strcmp0(s, "en") == 0, "Unexpected result: '%s'", s);
+	s = lt_lookup_table_lookup(t, ranges6, NULL);
+	fail_unless(g_strcmp0(s, "iw") == 0, "Unexpected result: '%s'", s);
+	lt_lookup_table_unref(t);
+} TEND
+
+TDEF (lt_lookup_table_lookup_canonical) {
+	static const gchar *ranges1[] = { "iw-IL", NULL };
+	static const gchar *ranges2[] = { "en-Latn-US", NULL };
+	static const gchar *ranges3[] = { "en-Latn-*", NULL };
+	lt_lookup_table_t *t = lt_lookup_table_new();
+	const gchar *s;
+
+	fail_unless(lt_lookup_table_add(t, "he", NULL), "Unable to add 'he'");
+	fail_unless(lt_lookup_table_add(t, "en-Latn-US", NULL), "Unable to add 'en-Latn-US'");
+	/* the ranges are canonicalized as the supported tags are */
+	s = lt_lookup_table_lookup(t, ranges1, NULL);
+	fail_unless(g_strcmp0(s, "he") == 0, "Unexpected result for 'iw-IL': '%s'", s);
+	s = lt_lookup_table_lookup(t, ranges2, NULL);
+	fail_unless(g_strcmp0(s, "en-Latn-US") == 0, "Unexpected result for 'en-Latn-US': '%s'", s);
+	s = lt_lookup_table_lookup(t, ranges3, NULL);
+	fail_unless(s == NULL, "No matches are expected for 'en-Latn-*': '%s'", s);
+	lt_lookup_table_unref(t);
+} TEND
+
+/************************************************************/
+Suite *
+tester_suite(void)
+{
+	Suite *s = suite_create("lt_lookup_table_t");
+	TCase *tc = tcase_create("Basic functionality");
+
+	tcase_add_checked_fixture(tc, setup, teardown);
+
+	T (lt_lookup_table_add);
+	T (lt_lookup_table_lookup);
+	T (lt_lookup_table_lookup_canonical);
+
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,221 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * check-matcher.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <liblangtag/langtag.h>
+#include "main.h"
+
+/************************************************************/
+/* common functions                                         */
+/************************************************************/
+void
+setup(void)
+{
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+}
+
+void
+teardown(void)
+{
+	lt_db_finalize();
+}
+
+static const gchar *__datadir_files[] = {
+	"language-subtag-registry.xml",
+	"common/bcp47",
+	"common/supplemental/likelySubtags.xml",
+	"common/supplemental/supplementalData.xml",
+	NULL
+};
+
+/* Create the data directory which refers to TEST_DATADIR except
+ * languageInfo.xml, which is replaced with @language_info.
+ */
+static gchar *
+_create_datadir(const gchar *language_info)
+{
+	gchar *datadir = g_build_filename(g_get_tmp_dir(), "check-matcher-XXXXXX", NULL);
+	gchar *path, *src;
+	gint i;
+
+	if (!mkdtemp(datadir)) {
+		g_free(datadir);
+		return NULL;
+	}
+	path = g_build_filename(datadir, "common", "supplemental", NULL);
+	g_mkdir_with_parents(path, 0755);
+	g_free(path);
+	for (i = 0; __datadir_files[i] != NULL; i++) {
+		src = g_build_filename(TEST_DATADIR, __datadir_files[i], NULL);
+		path = g_build_filename(datadir, __datadir_files[i], NULL);
+		if (symlink(src, path) != 0)
+			g_warning("Unable to create a symlink: %s", path);
+		g_free(path);
+		g_free(src);
+	}
+	path = g_build_filename(datadir, "common", "supplemental", "languageInfo.xml", NULL);
+	g_file_set_contents(path, language_info, -1, NULL);
+	g_free(path);
+
+	return datadir;
+}
+
+static void
+_remove_datadir(gchar *datadir)
+{
+	gchar *path;
+	gint i;
+
+	for (i = 0; __datadir_files[i] != NULL; i++) {
+		path = g_build_filename(datadir, __datadir_files[i], NULL);
+		g_unlink(path);
+		g_free(path);
+	}
+	path = g_build_filename(datadir, "common", "supplemental", "languageInfo.xml", NULL);
+	g_unlink(path);
+	g_free(path);
+	path = g_build_filename(datadir, "common", "supplemental", NULL);
+	g_rmdir(path);
+	g_free(path);
+	path = g_build_filename(datadir, "common", NULL);
+	g_rmdir(path);
+	g_free(path);
+	g_rmdir(datadir);
+	g_free(datadir);
+}
+
+/************************************************************/
+/* Test cases                                               */
+/************************************************************/
+TDEF (lt_matcher_get_distance) {
+	lt_matcher_t *m = lt_matcher_new();
+	guint d;
+
+	fail_unless(m != NULL, "Unable to create the instance.");
+	d = lt_matcher_get_distance(m, "en", "en-Latn-US");
+	fail_unless(d == 0, "'en' and 'en-Latn-US' are expected to be equivalent: %u", d);
+	d = lt_matcher_get_distance(m, "zh-TW", "zh-Hant");
+	fail_unless(d == 0, "'zh-TW' and 'zh-Hant' are expected to be equivalent: %u", d);
+	fail_unless(lt_matcher_get_distance(m, "en-AU", "en-GB") < lt_matcher_get_distance(m, "en-AU", "en-US"),
+		    "'en-GB' is expected to be closer to 'en-AU' than 'en-US'.");
+	d = lt_matcher_get_distance(m, "nb", "no");
+	fail_unless(d < LT_MATCHER_DEFAULT_THRESHOLD, "'no' is expected to be close to 'nb': %u", d);
+	d = lt_matcher_get_distance(m, "en", "ja");
+	fail_unless(d >= LT_MATCHER_DEFAULT_THRESHOLD, "'ja' isn't expected to be close to 'en': %u", d);
+	fail_unless(lt_matcher_get_distance(m, "qqq", "en") == G_MAXUINT, "Unknown language is expected to fail.");
+	lt_matcher_unref(m);
+} TEND
+
+TDEF (lt_matcher_get_best_match) {
+	static const gchar *supported[] = { "en-US", "en-GB", "fr", "no", NULL };
+	static const gchar *desired1[] = { "en-AU", NULL };
+	static const gchar *desired2[] = { "ja", "fr-CA", NULL };
+	static const gchar *desired3[] = { "ja", "ko", NULL };
+	static const gchar *desired4[] = { "nb-NO", "en", NULL };
+	lt_matcher_t *m = lt_matcher_new();
+	GError *err = NULL;
+	const gchar *s;
+	guint d;
+	gint i;
+
+	for (i = 0; supported[i] != NULL; i++) {
+		fail_unless(lt_matcher_add_supported(m, supported[i], NULL), "Unable to add '%s'", supported[i]);
+	}
+	fail_unless(!lt_matcher_add_supported(m, "x-foo", &err), "Unexpected result for 'x-foo'");
+	fail_unless(err != NULL, "No errors for 'x-foo'");
+	g_error_free(err);
+
+	s = lt_matcher_get_best_match(m, desired1, &d);
+	fail_unless(g_strcmp0(s, "en-GB") == 0, "Unexpected result for 'en-AU': '%s'", s);
+	s = lt_matcher_get_best_match(m, desired2, &d);
+	fail_unless(g_strcmp0(s, "fr") == 0, "Unexpected result for 'ja, fr-CA': '%s'", s);
+	fail_unless(d > 0, "The distance is expected to be demoted.");
+	s = lt_matcher_get_best_match(m, desired3, &d);
+	fail_unless(s == NULL, "Unexpected result for 'ja, ko': '%s'", s);
+	s = lt_matcher_get_best_match(m, desired4, NULL);
+	fail_unless(g_strcmp0(s, "no") == 0, "Unexpected result for 'nb-NO, en': '%s'", s);
+	lt_matcher_set_threshold(m, 0);
+	s = lt_matcher_get_best_match(m, desired4, NULL);
+	fail_unless(s == NULL, "Unexpected result with the threshold 0: '%s'", s);
+	lt_matcher_unref(m);
+} TEND
+
+TDEF (lt_matcher_rule_order) {
+	static const gchar language_info[] =
+		"<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+		"<supplementalData>\n"
+		"  <languageMatching>\n"
+		"    <languageMatches type=\"written_new\">\n"
+		"      <languageMatch desired=\"nl\" supported=\"en\" distance=\"5\"/>\n"
+		"      <languageMatch desired=\"*\" supported=\"en\" distance=\"30\"/>\n"
+		"      <languageMatch desired=\"fr\" supported=\"en\" distance=\"5\"/>\n"
+		"    </languageMatches>\n"
+		"  </languageMatching>\n"
+		"</supplementalData>\n";
+	gchar *datadir = _create_datadir(language_info);
+	lt_matcher_t *m;
+	guint d1, d2, d3;
+
+	fail_unless(datadir != NULL, "Unable to create the data directory.");
+	lt_db_finalize();
+	lt_db_set_datadir(datadir);
+	lt_db_initialize();
+	m = lt_matcher_new();
+	fail_unless(m != NULL, "Unable to create the instance.");
+	/* the first rule matched in the document order wins */
+	d1 = lt_matcher_get_distance(m, "fr", "en");
+	d2 = lt_matcher_get_distance(m, "it", "en");
+	d3 = lt_matcher_get_distance(m, "nl", "en");
+	fail_unless(d1 == d2, "The wildcard rule is expected to precede the exact rule for 'fr': %u, %u", d1, d2);
+	fail_unless(d3 < d1, "The exact rule is expected to precede the wildcard rule for 'nl': %u, %u", d3, d1);
+	lt_matcher_unref(m);
+	lt_db_finalize();
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+	_remove_datadir(datadir);
+} TEND
+
+/************************************************************/
+Suite *
+tester_suite(void)
+{
+	Suite *s = suite_create("lt_matcher_t");
+	TCase *tc = tcase_create("Basic functionality");
+
+	tcase_add_checked_fixture(tc, setup, teardown);
+
+	T (lt_matcher_get_distance);
+	T (lt_matcher_get_best_match);
+	T (lt_matcher_rule_order);
+
+	suite_add_tcase(s, tc);
+
+	return s;
+}
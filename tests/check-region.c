@@ -74,6 +74,19 @@ TDEF (lt_region_compare) {
 	lt_region_unref(e1);
 } TEND
 
+TDEF (lt_region_db_contains) {
+	fail_unless(lt_region_db_contains(db, "419", "MX"), "Mexico is in Latin America.");
+	fail_unless(lt_region_db_contains(db, "419", "mx"), "Region codes are case-insensitive.");
+	fail_unless(lt_region_db_contains(db, "001", "JP"), "Japan is in the world.");
+	fail_unless(lt_region_db_contains(db, "150", "DE"), "Germany is in Europe.");
+	fail_unless(lt_region_db_contains(db, "MX", "MX"), "Any region contains itself.");
+	fail_unless(!lt_region_db_contains(db, "419", "ES"), "Spain isn't in Latin America.");
+	fail_unless(!lt_region_db_contains(db, "MX", "419"), "Latin America isn't in Mexico.");
+	fail_unless(!lt_region_db_contains(db, "419", "*"), "Wildcard isn't a region.");
+	fail_unless(!lt_region_db_contains(db, "EU", "FR"), "The groupings out of UN M.49 aren't containers.");
+	fail_unless(!lt_region_db_contains(db, "UN", "JP"), "The groupings out of UN M.49 aren't containers.");
+} TEND
+
 /************************************************************/
 Suite *
 tester_suite(void)
@@ -84,6 +97,7 @@ tester_suite(void)
 	tcase_add_checked_fixture(tc, setup, teardown);
 
 	T (lt_region_compare);
+	T (lt_region_db_contains);
 
 	suite_add_tcase(s, tc);
 
@@ -70,6 +70,25 @@ TDEF (lt_script_compare) {
 	lt_script_unref(e1);
 } TEND
 
+TDEF (lt_script_db_search) {
+	GList *l, *ll;
+
+	l = lt_script_db_search(db, "cyrillic", FALSE);
+	fail_unless(l != NULL, "No expected script found: 'Cyrillic'");
+	fail_unless(g_strcmp0(lt_script_get_tag(l->data), "Cyrl") == 0, "Unexpected script found: '%s'", lt_script_get_tag(l->data));
+	for (ll = l; ll != NULL; ll = g_list_next(ll))
+		lt_script_unref(ll->data);
+	g_list_free(l);
+
+	l = lt_script_db_search(db, "cyr old church", TRUE);
+	fail_unless(l != NULL, "No expected script found: 'cyr old church'");
+	fail_unless(g_strcmp0(lt_script_get_tag(l->data), "Cyrs") == 0, "Unexpected script found: '%s'", lt_script_get_tag(l->data));
+	fail_unless(g_list_next(l) == NULL, "Too many scripts found.");
+	for (ll = l; ll != NULL; ll = g_list_next(ll))
+		lt_script_unref(ll->data);
+	g_list_free(l);
+} TEND
+
 /************************************************************/
 Suite *
 tester_suite(void)
@@ -80,6 +99,7 @@ tester_suite(void)
 	tcase_add_checked_fixture(tc, setup, teardown);
 
 	T (lt_script_compare);
+	T (lt_script_db_search);
 
 	suite_add_tcase(s, tc);
 
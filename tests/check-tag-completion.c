@@ -0,0 +1,141 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * check-tag-completion.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <liblangtag/langtag.h>
+#include "main.h"
+
+/************************************************************/
+/* common functions                                         */
+/************************************************************/
+void
+setup(void)
+{
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+}
+
+void
+teardown(void)
+{
+	lt_db_finalize();
+}
+
+/************************************************************/
+/* Test cases                                               */
+/************************************************************/
+TDEF (lt_tag_completion_is_viable) {
+	static const struct {
+		const gchar *partial;
+		gboolean     viable;
+	} tests[] = {
+		{ "", TRUE },
+		{ "z", TRUE },
+		{ "zh-Ha", TRUE },
+		{ "zh-Hant-", TRUE },
+		{ "zh-Hant-T", TRUE },
+		{ "en-US-u", TRUE },
+		{ "en-US-u-ca-", TRUE },
+		{ "en-x-foo-b", TRUE },
+		{ "x", TRUE },
+		{ "i-def", TRUE },
+		{ "en-US-Latn", FALSE },
+		{ "en--", FALSE },
+		{ "en_US", FALSE },
+		{ "en-u-c", TRUE },
+		{ "en-u-x", TRUE },
+		{ "en-u-a-", FALSE },
+		{ "en-x-abcdefghi", FALSE },
+		{ "zzzz", FALSE },
+		{ NULL, FALSE }
+	};
+	lt_tag_completion_t *c;
+	gint i;
+
+	for (i = 0; tests[i].partial != NULL; i++) {
+		c = lt_tag_completion_new(tests[i].partial, -1);
+		fail_unless(c != NULL, "Unable to create the instance.");
+		fail_unless(lt_tag_completion_is_viable(c) == tests[i].viable,
+			    "Unexpected viability for '%s': expected %d",
+			    tests[i].partial, tests[i].viable);
+		lt_tag_completion_unref(c);
+	}
+} TEND
+
+TDEF (lt_tag_completion_next) {
+	lt_tag_completion_t *c;
+	const gchar *s;
+	gboolean hans = FALSE, hant = FALSE;
+	gsize len = 0;
+
+	c = lt_tag_completion_new("zh-Ha", -1);
+	while ((s = lt_tag_completion_next(c)) != NULL) {
+		fail_unless(g_ascii_strncasecmp(s, "zh-Ha", 5) == 0, "Unexpected candidate: '%s'", s);
+		fail_unless(strlen(s) >= len, "Shorter candidates have to come first: '%s'", s);
+		len = strlen(s);
+		if (g_strcmp0(s, "zh-Hans") == 0)
+			hans = TRUE;
+		if (g_strcmp0(s, "zh-Hant") == 0)
+			hant = TRUE;
+	}
+	fail_unless(hans && hant, "No expected candidates found: 'zh-Hans', 'zh-Hant'");
+	lt_tag_completion_unref(c);
+
+	c = lt_tag_completion_new("i-def", -1);
+	s = lt_tag_completion_next(c);
+	fail_unless(g_strcmp0(s, "i-default") == 0, "Unexpected candidate: '%s'", s);
+	fail_unless(lt_tag_completion_next(c) == NULL, "No more candidates expected.");
+	lt_tag_completion_unref(c);
+
+	c = lt_tag_completion_new("en-US-Latn", 7);
+	fail_unless(lt_tag_completion_is_viable(c), "'en-US-L' is expected to be viable.");
+	while ((s = lt_tag_completion_next(c)) != NULL) {
+		fail_unless(g_ascii_strncasecmp(s, "en-US-L", 7) == 0, "Unexpected candidate: '%s'", s);
+	}
+	lt_tag_completion_unref(c);
+
+	c = lt_tag_completion_new("en-US-Latn", -1);
+	fail_unless(lt_tag_completion_next(c) == NULL, "No candidates expected.");
+	lt_tag_completion_unref(c);
+} TEND
+
+/************************************************************/
+Suite *
+tester_suite(void)
+{
+	Suite *s = suite_create("lt_tag_completion_t");
+	TCase *tc = tcase_create("Basic functionality");
+
+	tcase_add_checked_fixture(tc, setup, teardown);
+
+	T (lt_tag_completion_is_viable);
+	T (lt_tag_completion_next);
+
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,116 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/* 
+ * check-tag-map.c
+ * Copyright (C) 2012 Akira TAGOH
+ * 
+ * Authors:
+ *   Akira TAGOH  <akira@tagoh.org>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <liblangtag/langtag.h>
+#include "main.h"
+
+/************************************************************/
+/* common functions                                         */
+/************************************************************/
+void
+setup(void)
+{
+	lt_db_set_datadir(TEST_DATADIR);
+	lt_db_initialize();
+}
+
+void
+teardown(void)
+{
+	lt_db_finalize();
+}
+
+/************************************************************/
+/* Test cases                                               */
+/************************************************************/
+TDEF (lt_tag_map_insert) {
+	lt_tag_map_t *m = lt_tag_map_new(g_free);
+	const gchar *k = NULL;
+	GError *err = NULL;
+
+	fail_unless(m != NULL, "Unable to create the instance.");
+	fail_unless(lt_tag_map_insert(m, "iw", g_strdup("he"), NULL), "Unable to insert 'iw'");
+	fail_unless(lt_tag_map_insert(m, "he", g_strdup("he2"), NULL), "Unable to insert 'he'");
+	fail_unless(lt_tag_map_size(m) == 1, "The keys are expected to be canonicalized.");
+	fail_unless(g_strcmp0(lt_tag_map_lookup(m, "he-IL", &k), "he2") == 0, "The value is expected to be replaced.");
+	fail_unless(g_strcmp0(k, "he") == 0, "Unexpected key: '%s'", k);
+	fail_unless(!lt_tag_map_insert(m, "en-US-Latn", g_strdup("en"), &err), "'en-US-Latn' is expected to be invalid.");
+	fail_unless(err != NULL, "No errors for 'en-US-Latn'");
+	g_error_free(err);
+	lt_tag_map_unref(m);
+} TEND
+
+TDEF (lt_tag_map_lookup) {
+	lt_tag_map_t *m = lt_tag_map_new(NULL);
+	const gchar *k = NULL;
+
+	lt_tag_map_insert(m, "zh", "zh", NULL);
+	lt_tag_map_insert(m, "zh-Hant", "zh-Hant", NULL);
+	lt_tag_map_insert(m, "pt", "pt", NULL);
+	lt_tag_map_insert(m, "pt-PT", "pt-PT", NULL);
+	fail_unless(g_strcmp0(lt_tag_map_lookup(m, "zh-Hant-HK", NULL), "zh-Hant") == 0, "Unexpected value for 'zh-Hant-HK'");
+	fail_unless(g_strcmp0(lt_tag_map_lookup(m, "ZH-CN", NULL), "zh") == 0, "Unexpected value for 'ZH-CN'");
+	fail_unless(g_strcmp0(lt_tag_map_lookup(m, "pt-AO", &k), "pt-PT") == 0, "Unexpected value for 'pt-AO'");
+	fail_unless(g_strcmp0(k, "pt-PT") == 0, "Unexpected key: '%s'", k);
+	fail_unless(lt_tag_map_lookup(m, "ja", &k) == NULL, "No values are expected for 'ja'");
+	fail_unless(k == NULL, "No keys are expected for 'ja'");
+	lt_tag_map_insert(m, "root", "root", NULL);
+	fail_unless(g_strcmp0(lt_tag_map_lookup(m, "ja", NULL), "root") == 0, "Unexpected value for 'ja'");
+	lt_tag_map_unref(m);
+} TEND
+
+TDEF (lt_tag_map_lookup_canonical) {
+	lt_tag_map_t *m = lt_tag_map_new(NULL);
+	const gchar *k = NULL;
+
+	lt_tag_map_insert(m, "he", "he", NULL);
+	lt_tag_map_insert(m, "en-US", "en-US", NULL);
+	/* the requests are canonicalized as the keys are */
+	fail_unless(g_strcmp0(lt_tag_map_lookup(m, "iw-IL", &k), "he") == 0, "Unexpected value for 'iw-IL'");
+	fail_unless(g_strcmp0(k, "he") == 0, "Unexpected key: '%s'", k);
+	fail_unless(g_strcmp0(lt_tag_map_lookup(m, "en-Latn-US", &k), "en-US") == 0, "Unexpected value for 'en-Latn-US'");
+	fail_unless(g_strcmp0(k, "en-US") == 0, "Unexpected key: '%s'", k);
+	lt_tag_map_unref(m);
+} TEND
+
+/************************************************************/
+Suite *
+tester_suite(void)
+{
+	Suite *s = suite_create("lt_tag_map_t");
+	TCase *tc = tcase_create("Basic functionality");
+
+	tcase_add_checked_fixture(tc, setup, teardown);
+
+	T (lt_tag_map_insert);
+	T (lt_tag_map_lookup);
+	T (lt_tag_map_lookup_canonical);
+
+	suite_add_tcase(s, tc);
+
+	return s;
+}
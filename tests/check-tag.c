@@ -25,7 +25,11 @@
 #include "config.h"
 #endif
 
+#include <locale.h>
+#include <string.h>
 #include <liblangtag/langtag.h>
+#include <liblangtag/lt-error.h>
+#include "lt-utils.h"
 #include "main.h"
 
 /************************************************************/
@@ -242,6 +246,573 @@ TDEF (lt_tag_match) {
 	lt_tag_unref(t1);
 } TEND
 
+TDEF (lt_tag_match_full) {
+	lt_tag_t *t1;
+
+	t1 = lt_tag_new();
+	fail_unless(t1 != NULL, "OOM");
+	fail_unless(lt_tag_parse(t1, "es-MX", NULL), "should be valid langtag.");
+	fail_unless(!lt_tag_match_full(t1, "es-419", -1, LT_TAG_MATCH_DEFAULT, NULL), "shouldn't match without the region containment.");
+	fail_unless(lt_tag_match_full(t1, "es-419", -1, LT_TAG_MATCH_REGION_CONTAINMENT, NULL), "should match because Mexico is in Latin America.");
+	fail_unless(lt_tag_match_full(t1, "es-MX", -1, LT_TAG_MATCH_REGION_CONTAINMENT, NULL), "should match.");
+	fail_unless(!lt_tag_match_full(t1, "pt-419", -1, LT_TAG_MATCH_REGION_CONTAINMENT, NULL), "shouldn't match because the language is different.");
+	fail_unless(lt_tag_parse(t1, "es-ES", NULL), "should be valid langtag.");
+	fail_unless(!lt_tag_match_full(t1, "es-419", -1, LT_TAG_MATCH_REGION_CONTAINMENT, NULL), "shouldn't match because Spain isn't in Latin America.");
+	fail_unless(lt_tag_parse(t1, "es-419", NULL), "should be valid langtag.");
+	fail_unless(!lt_tag_match_full(t1, "es-MX", -1, LT_TAG_MATCH_REGION_CONTAINMENT, NULL), "shouldn't match because the range is narrower.");
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_copy) {
+	lt_tag_t *t1, *t2;
+
+	t1 = lt_tag_new();
+	fail_unless(t1 != NULL, "OOM");
+	fail_unless(lt_tag_parse(t1, "de-Latn-DE-1996-x-foo", NULL), "should be valid langtag.");
+	t2 = lt_tag_copy(t1);
+	fail_unless(t2 != NULL, "OOM");
+	fail_unless(lt_tag_compare(t1, t2), "a copy should be the same tag.");
+	fail_unless(lt_tag_truncate(t2, NULL), "should be truncated.");
+	fail_unless(lt_tag_truncate(t2, NULL), "should be truncated.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t2), "de-Latn-DE") == 0, "Unexpected result to be truncated.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "de-Latn-DE-1996-x-foo") == 0, "the original tag shouldn't be changed.");
+	fail_unless(lt_tag_get_privateuse(t1)->len > 0, "the original tag shouldn't be changed.");
+	lt_tag_unref(t2);
+
+	t2 = lt_tag_copy(t1);
+	fail_unless(lt_tag_truncate(t1, NULL), "should be truncated.");
+	fail_unless(lt_tag_get_privateuse(t2)->len > 0, "the copy shouldn't be changed.");
+	fail_unless(lt_tag_parse(t1, "ja", NULL), "should be valid langtag.");
+	fail_unless(lt_tag_get_region(t2) != NULL, "the copy shouldn't be changed.");
+	fail_unless(lt_tag_get_variants(t2) != NULL, "the copy shouldn't be changed.");
+
+	lt_tag_unref(t2);
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_freeze) {
+	lt_tag_t *t1, *t2;
+	gchar *s;
+
+	t1 = lt_tag_new();
+	fail_unless(t1 != NULL, "OOM");
+	fail_unless(!lt_tag_freeze(t1, NULL), "an empty tag can't be frozen.");
+	fail_unless(lt_tag_parse(t1, "en-Latn-US", NULL), "should be valid langtag.");
+	fail_unless(lt_tag_freeze(t1, NULL), "should be frozen.");
+	fail_unless(lt_tag_is_frozen(t1), "should be frozen.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "en-Latn-US") == 0, "Unexpected tag string.");
+	s = lt_tag_canonicalize(t1, NULL);
+	fail_unless(g_strcmp0(s, "en-US") == 0, "Unexpected result to be canonicalized.");
+	g_free(s);
+	fail_unless(!lt_tag_parse(t1, "ja", NULL), "frozen tag shouldn't be modified.");
+	fail_unless(!lt_tag_truncate(t1, NULL), "frozen tag shouldn't be truncated.");
+	fail_unless(lt_tag_match(t1, "en-*-US", NULL), "should match.");
+	t2 = lt_tag_copy(t1);
+	fail_unless(!lt_tag_is_frozen(t2), "a copy of the frozen tag should be modifiable.");
+	fail_unless(lt_tag_truncate(t2, NULL), "should be truncated.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "en-Latn-US") == 0, "the frozen tag shouldn't be changed.");
+
+	lt_tag_unref(t2);
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_intern) {
+	lt_tag_t *t1, *t2, *t3, *t4;
+
+	t1 = lt_tag_intern("en-Latn-US", NULL);
+	fail_unless(t1 != NULL, "should be valid langtag.");
+	fail_unless(lt_tag_is_frozen(t1), "interned tag should be frozen.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "en-US") == 0, "interned tag should be in the canonical form.");
+	fail_unless(lt_tag_get_script(t1) == NULL, "interned tag should be in the canonical form.");
+	t2 = lt_tag_intern("en-US", NULL);
+	fail_unless(t1 == t2, "the same canonical tag should be the same instance.");
+	lt_tag_unref(t2);
+	/* the result shouldn't depend on the order */
+	t2 = lt_tag_intern("de-DE", NULL);
+	fail_unless(t2 != NULL, "should be valid langtag.");
+	t4 = lt_tag_intern("de-Latn-DE", NULL);
+	fail_unless(t2 == t4, "the same canonical tag should be the same instance.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t4), "de-DE") == 0, "interned tag should be in the canonical form.");
+	lt_tag_unref(t4);
+	t3 = lt_tag_intern("en-GB", NULL);
+	fail_unless(t3 != NULL, "should be valid langtag.");
+	fail_unless(t1 != t3, "different tags should be different instances.");
+	t4 = lt_tag_intern("EN-us", NULL);
+	fail_unless(t1 == t4, "the tags differing in case only should be the same instance.");
+	lt_tag_unref(t4);
+	fail_unless(lt_tag_intern("blahblahblah", NULL) == NULL, "should be an unknown tag.");
+
+	lt_tag_unref(t3);
+	lt_tag_unref(t2);
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_get_thread_locale) {
+	lt_tag_t *t1, *t2;
+
+	setlocale(LC_ALL, "C");
+	t1 = lt_tag_get_thread_locale(NULL);
+	fail_unless(t1 != NULL, "should be converted.");
+	fail_unless(lt_tag_is_frozen(t1), "cached tag should be frozen.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "en-US-u-va-posix") == 0, "Unexpected result: %s", lt_tag_get_string(t1));
+	t2 = lt_tag_get_thread_locale(NULL);
+	fail_unless(t1 == t2, "should be cached for the same locale.");
+
+	lt_tag_unref(t2);
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_builder) {
+	lt_lang_db_t *langdb = lt_db_get_lang();
+	lt_script_db_t *scriptdb = lt_db_get_script();
+	lt_region_db_t *regiondb = lt_db_get_region();
+	lt_variant_db_t *variantdb = lt_db_get_variant();
+	lt_lang_t *sr = lt_lang_db_lookup(langdb, "sr");
+	lt_lang_t *sl = lt_lang_db_lookup(langdb, "sl");
+	lt_lang_t *de = lt_lang_db_lookup(langdb, "de");
+	lt_script_t *latn = lt_script_db_lookup(scriptdb, "Latn");
+	lt_region_t *rs = lt_region_db_lookup(regiondb, "RS");
+	lt_region_t *me = lt_region_db_lookup(regiondb, "ME");
+	lt_variant_t *rozaj = lt_variant_db_lookup(variantdb, "rozaj");
+	lt_tag_t *t1;
+
+	t1 = lt_tag_new();
+	fail_unless(!lt_tag_set_region(t1, rs, NULL), "no language subtag to build on.");
+	fail_unless(lt_tag_set_language(t1, sr, NULL), "should be set.");
+	fail_unless(lt_tag_set_script(t1, latn, NULL), "should be set.");
+	fail_unless(lt_tag_set_region(t1, rs, NULL), "should be set.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "sr-Latn-RS") == 0, "Unexpected result: %s", lt_tag_get_string(t1));
+	fail_unless(lt_tag_set_region(t1, me, NULL), "should be replaced.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "sr-Latn-ME") == 0, "Unexpected result: %s", lt_tag_get_string(t1));
+	fail_unless(lt_tag_set_script(t1, NULL, NULL), "should be removed.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "sr-ME") == 0, "Unexpected result: %s", lt_tag_get_string(t1));
+	lt_tag_clear(t1);
+	fail_unless(lt_tag_set_language(t1, sl, NULL), "should be set.");
+	fail_unless(lt_tag_add_variant(t1, rozaj, NULL), "should be added.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "sl-rozaj") == 0, "Unexpected result: %s", lt_tag_get_string(t1));
+	fail_unless(!lt_tag_set_language(t1, de, NULL), "rozaj isn't valid for de.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "sl-rozaj") == 0, "shouldn't be modified on error: %s", lt_tag_get_string(t1));
+	fail_unless(!lt_tag_add_variant(t1, rozaj, NULL), "duplicate variants should be an error.");
+	lt_tag_clear(t1);
+	fail_unless(lt_tag_parse(t1, "sl-x-foo", NULL), "should be valid langtag.");
+	fail_unless(lt_tag_add_variant(t1, rozaj, NULL), "should be added.");
+	fail_unless(lt_tag_parse_with_extra_token(t1, "u-co", NULL), "should be the private use subtags.");
+	fail_unless(lt_tag_get_extension(t1) == NULL, "extension shouldn't be added after the private use subtags.");
+	fail_unless(g_strcmp0(lt_tag_get_privateuse(t1)->str, "x-foo-u-co") == 0, "Unexpected result: %s", lt_tag_get_privateuse(t1)->str);
+	lt_tag_unref(t1);
+
+	lt_variant_unref(rozaj);
+	lt_region_unref(me);
+	lt_region_unref(rs);
+	lt_script_unref(latn);
+	lt_lang_unref(de);
+	lt_lang_unref(sl);
+	lt_lang_unref(sr);
+	lt_variant_db_unref(variantdb);
+	lt_region_db_unref(regiondb);
+	lt_script_db_unref(scriptdb);
+	lt_lang_db_unref(langdb);
+} TEND
+
+TDEF (lt_tag_hash) {
+	lt_tag_t *t1, *t2, *t3;
+	GHashTable *table;
+
+	t1 = lt_tag_new();
+	t2 = lt_tag_new();
+	t3 = lt_tag_new();
+	fail_unless(lt_tag_parse(t1, "en-Latn-US", NULL), "should be valid langtag.");
+	fail_unless(lt_tag_parse(t2, "EN-us", NULL), "should be valid langtag.");
+	fail_unless(lt_tag_parse(t3, "en-GB", NULL), "should be valid langtag.");
+	fail_unless(lt_tag_hash(t1) == lt_tag_hash(t2), "canonically equivalent tags should have the same hash.");
+	fail_unless(lt_tag_equal(t1, t2), "canonically equivalent tags should be equal.");
+	fail_unless(!lt_tag_equal(t1, t3), "different tags shouldn't be equal.");
+	fail_unless(lt_tag_freeze(t2, NULL), "should be frozen.");
+	fail_unless(lt_tag_hash(t1) == lt_tag_hash(t2), "frozen tag should have the same hash.");
+
+	table = g_hash_table_new(lt_tag_hash, lt_tag_equal);
+	g_hash_table_insert(table, t1, t1);
+	fail_unless(g_hash_table_lookup(table, t2) == t1, "should be found with the equivalent tag.");
+	fail_unless(g_hash_table_lookup(table, t3) == NULL, "shouldn't be found with the different tag.");
+	g_hash_table_destroy(table);
+
+	lt_tag_unref(t3);
+	lt_tag_unref(t2);
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_encode) {
+	static const gchar *tags[] = {
+		"de", "de-AT", "de-CH-1996", "en", "en-GB", "en-US", "en-US-x-foo", "ja", NULL
+	};
+	lt_tag_t *t1, *t2;
+	guchar *d1, *d2, odd[16];
+	gsize l1, l2;
+	gchar *s;
+	gint i;
+	GError *err = NULL;
+
+	t1 = lt_tag_new();
+	t2 = lt_tag_new();
+	fail_unless(lt_tag_parse(t1, "en-Latn-US", NULL), "should be valid langtag.");
+	fail_unless(lt_tag_parse(t2, "en-US", NULL), "should be valid langtag.");
+	d1 = lt_tag_encode(t1, &l1, NULL);
+	d2 = lt_tag_encode(t2, &l2, NULL);
+	fail_unless(d1 != NULL, "should be encoded.");
+	fail_unless(l1 == l2 && memcmp(d1, d2, l1) == 0, "canonically equivalent tags should be encoded to the same data.");
+	lt_tag_unref(t1);
+	t1 = lt_tag_decode(d1, l1, NULL);
+	fail_unless(t1 != NULL, "should be decoded.");
+	s = lt_tag_canonicalize(t1, NULL);
+	fail_unless(g_strcmp0(s, "en-US") == 0, "Unexpected result to decode: %s", s);
+	g_free(s);
+	lt_tag_unref(t1);
+	t1 = lt_tag_decode(d1, l1 - 2, &err);
+	fail_unless(t1 == NULL, "the data without the terminator shouldn't be decoded.");
+	fail_unless(err != NULL && err->code == LT_ERR_INVALID, "LT_ERR_INVALID is expected for no terminator.");
+	g_clear_error(&err);
+	memcpy(odd, d1, l1);
+	odd[l1] = 0;
+	t1 = lt_tag_decode(odd, l1 + 1, &err);
+	fail_unless(t1 == NULL, "the data with the trailing byte shouldn't be decoded.");
+	fail_unless(err != NULL && err->code == LT_ERR_INVALID, "LT_ERR_INVALID is expected for the trailing byte.");
+	g_clear_error(&err);
+	g_free(d1);
+	g_free(d2);
+	lt_tag_unref(t2);
+
+	t1 = lt_tag_new();
+	fail_unless(lt_tag_parse(t1, tags[0], NULL), "should be valid langtag.");
+	d1 = lt_tag_encode(t1, &l1, NULL);
+	for (i = 1; tags[i] != NULL; i++) {
+		t2 = lt_tag_new();
+		fail_unless(lt_tag_parse(t2, tags[i], NULL), "should be valid langtag.");
+		d2 = lt_tag_encode(t2, &l2, NULL);
+		fail_unless(d2 != NULL, "should be encoded.");
+		fail_unless(memcmp(d1, d2, MIN (l1, l2)) < 0, "should be sorted in the same order: %s, %s", tags[i - 1], tags[i]);
+		lt_tag_unref(t1);
+		g_free(d1);
+		t1 = lt_tag_decode(d2, l2, NULL);
+		fail_unless(t1 != NULL, "should be decoded.");
+		s = lt_tag_canonicalize(t1, NULL);
+		fail_unless(g_strcmp0(s, tags[i]) == 0, "Unexpected result to decode: expected %s, but %s", tags[i], s);
+		g_free(s);
+		lt_tag_unref(t2);
+		d1 = d2;
+		l1 = l2;
+	}
+	g_free(d1);
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_canonicalize_to_buf) {
+	lt_tag_t *t1;
+	gchar buf[32], small[4];
+	gsize needed;
+
+	t1 = lt_tag_new();
+	fail_unless(lt_tag_parse(t1, "en-Latn-US", NULL), "should be valid langtag.");
+	fail_unless(lt_tag_get_string_to_buf(t1, buf, sizeof (buf), &needed), "should be stored.");
+	fail_unless(g_strcmp0(buf, "en-Latn-US") == 0, "Unexpected result: %s", buf);
+	fail_unless(needed == 11, "Unexpected size: %" G_GSIZE_FORMAT, needed);
+	fail_unless(lt_tag_canonicalize_to_buf(t1, buf, sizeof (buf), &needed, NULL), "should be stored.");
+	fail_unless(g_strcmp0(buf, "en-US") == 0, "Unexpected result: %s", buf);
+	fail_unless(needed == 6, "Unexpected size: %" G_GSIZE_FORMAT, needed);
+	fail_unless(!lt_tag_canonicalize_to_buf(t1, small, sizeof (small), &needed, NULL), "shouldn't be stored.");
+	fail_unless(g_strcmp0(small, "en-") == 0, "Unexpected result to be truncated: %s", small);
+	fail_unless(needed == 6, "Unexpected size: %" G_GSIZE_FORMAT, needed);
+	fail_unless(!lt_tag_canonicalize_to_buf(t1, NULL, 0, &needed, NULL), "shouldn't be stored.");
+	fail_unless(needed == 6, "Unexpected size: %" G_GSIZE_FORMAT, needed);
+	fail_unless(lt_tag_convert_to_locale_to_buf(t1, buf, sizeof (buf), &needed, NULL), "should be stored.");
+	fail_unless(g_strcmp0(buf, "en_US") == 0, "Unexpected result: %s", buf);
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_convert_to_locale) {
+	static const struct {
+		const gchar *tag;
+		const gchar *locale;
+	} tests[] = {
+		{"en-US", "en_US"},
+		{"en-Latn-US", "en_US"},
+		{"sr-Latn-RS", "sr_RS@latin"},
+		{"iw-IL", "he_IL"},
+		{"zh-yue", "yue"},
+		{NULL, NULL}
+	};
+	lt_tag_t *t1;
+	gchar *s;
+	gint i;
+
+	t1 = lt_tag_new();
+	for (i = 0; tests[i].tag != NULL; i++) {
+		fail_unless(lt_tag_parse(t1, tests[i].tag, NULL), "should be valid langtag: %s", tests[i].tag);
+		s = lt_tag_convert_to_locale(t1, NULL);
+		fail_unless(g_strcmp0(s, tests[i].locale) == 0, "Unexpected result for %s: %s", tests[i].tag, s);
+		g_free(s);
+	}
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_parse_len) {
+	static const gchar buffer[] = "en-US,ja-JP;q=0.8";
+	lt_tag_t *t1;
+	gchar *s;
+
+	t1 = lt_tag_new();
+	fail_unless(lt_tag_parse_len(t1, buffer, 5, NULL), "should be valid langtag.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "en-US") == 0, "Unexpected tag string: %s", lt_tag_get_string(t1));
+	fail_unless(lt_tag_match_len(t1, buffer, 5, NULL), "should be matched.");
+	fail_unless(!lt_tag_match_len(t1, &buffer[6], 5, NULL), "shouldn't be matched.");
+	fail_unless(lt_tag_match_len(t1, "en-*-foo", 4, NULL), "should be matched.");
+	s = lt_tag_lookup_len(t1, "en-*-foo", 4, NULL);
+	fail_unless(g_strcmp0(s, "en-US") == 0, "Unexpected result to lookup: %s", s);
+	g_free(s);
+	fail_unless(lt_tag_parse_len(t1, &buffer[6], 5, NULL), "should be valid langtag.");
+	fail_unless(g_strcmp0(lt_tag_get_string(t1), "ja-JP") == 0, "Unexpected tag string: %s", lt_tag_get_string(t1));
+	fail_unless(!lt_tag_parse_len(t1, &buffer[6], 6, NULL), "should be invalid langtag.");
+	lt_tag_unref(t1);
+} TEND
+
+TDEF (lt_tag_validate) {
+	fail_unless(lt_tag_validate("en-US", -1, LT_VALIDATION_WELL_FORMED, NULL), "should be well-formed.");
+	fail_unless(lt_tag_validate("zz-Zzzz-ZZ", -1, LT_VALIDATION_WELL_FORMED, NULL), "should be well-formed.");
+	fail_unless(lt_tag_validate("i-default", -1, LT_VALIDATION_WELL_FORMED, NULL), "should be well-formed.");
+	fail_unless(lt_tag_validate("x-foo-bar", -1, LT_VALIDATION_WELL_FORMED, NULL), "should be well-formed.");
+	fail_unless(lt_tag_validate("de-CH-1996-a-bbb-x-foo", -1, LT_VALIDATION_WELL_FORMED, NULL), "should be well-formed.");
+	fail_unless(!lt_tag_validate("en-", -1, LT_VALIDATION_WELL_FORMED, NULL), "shouldn't be well-formed.");
+	fail_unless(!lt_tag_validate("en-a", -1, LT_VALIDATION_WELL_FORMED, NULL), "shouldn't be well-formed.");
+	fail_unless(!lt_tag_validate("en-a-x-foo", -1, LT_VALIDATION_WELL_FORMED, NULL), "shouldn't be well-formed.");
+	fail_unless(!lt_tag_validate("en-a-b-foo", -1, LT_VALIDATION_WELL_FORMED, NULL), "shouldn't be well-formed.");
+	fail_unless(!lt_tag_validate("en-US-Latn", -1, LT_VALIDATION_WELL_FORMED, NULL), "shouldn't be well-formed.");
+	fail_unless(!lt_tag_validate("en_US", -1, LT_VALIDATION_WELL_FORMED, NULL), "shouldn't be well-formed.");
+	fail_unless(lt_tag_validate("en-US;q=0.8", 5, LT_VALIDATION_WELL_FORMED, NULL), "should be well-formed.");
+	fail_unless(!lt_tag_validate("zz-Zzzz-ZZ", -1, LT_VALIDATION_VALID_SUBTAGS, NULL), "should be unknown subtags.");
+	fail_unless(lt_tag_validate("zh-min-nan", -1, LT_VALIDATION_VALID_SUBTAGS, NULL), "should be valid.");
+	fail_unless(lt_tag_validate("en-Latn-US", -1, LT_VALIDATION_VALID_SUBTAGS, NULL), "should be valid.");
+	fail_unless(lt_tag_validate("en-Latn-US", -1, LT_VALIDATION_STRICT, NULL), "should be valid.");
+	fail_unless(!lt_tag_validate("en-1996", -1, LT_VALIDATION_STRICT, NULL), "should be invalid prefix.");
+	fail_unless(lt_tag_validate("en-1996", -1, LT_VALIDATION_VALID_SUBTAGS, NULL), "prefix shouldn't be checked.");
+} TEND
+
+TDEF (lt_tag_validate_bulk) {
+	const gchar *tags[] = {
+		"en-US", "en_US", "zh-Hant-TW", "en-", "en-US;q=0.5",
+		"en-x-aaaaaaaa-bbbbbbbb-cccccccc-dddddddd-eeeeeeee-ffffffff-gggggggg-hhhhhhhh"
+	};
+	gssize lengths[] = { -1, -1, -1, -1, 5, -1 };
+	gboolean results[6];
+
+	fail_unless(lt_tag_validate_bulk(tags, lengths, 6, LT_VALIDATION_WELL_FORMED, results) == 4, "Unexpected number of well-formed tags.");
+	fail_unless(results[0] && !results[1] && results[2] && !results[3] && results[4] && results[5], "Unexpected result.");
+	fail_unless(lt_tag_validate_bulk(tags, NULL, 3, LT_VALIDATION_WELL_FORMED, NULL) == 2, "Unexpected number of well-formed tags.");
+	fail_unless(lt_tag_validate_bulk(tags, lengths, 6, LT_VALIDATION_VALID_SUBTAGS, results) == 4, "Unexpected number of valid tags.");
+} TEND
+
+TDEF (lt_tag_validate_bulk_many) {
+	static const gchar * const samples[] = {
+		"en", "en-US", "zh-Hant-TW", "ja-JP-u-ca-japanese", "de-CH-1996",
+		"en_US", "en-", "-en", "en--US", "i-default", "x-foo", "qqq-QQ",
+		"en-a-bbb-x-a-ccc", "sl-rozaj-biske-1994", "EN-us", "en-US@foo",
+		"en-x-aaaaaaaa-bbbbbbbb-cccccccc-dddddddd-eeeeeeee-ffffffff-gggggggg-hhhhhhhh",
+		"", NULL
+	};
+	const gchar *tags[100];
+	gboolean results[100];
+	lt_validation_level_t level;
+	gsize i, n = G_N_ELEMENTS (tags), count;
+
+	/* more tags than fit into one classification window */
+	for (i = 0; i < n; i++)
+		tags[i] = samples[(i * 7) % G_N_ELEMENTS (samples)];
+	for (level = LT_VALIDATION_WELL_FORMED; level <= LT_VALIDATION_STRICT; level++) {
+		count = lt_tag_validate_bulk(tags, NULL, n, level, results);
+		for (i = 0; i < n; i++) {
+			gboolean expected = tags[i] && lt_tag_validate(tags[i], -1, level, NULL);
+
+			fail_unless(results[i] == expected, "Unexpected result for '%s' at the level %d", tags[i], level);
+			if (expected)
+				count--;
+		}
+		fail_unless(count == 0, "Unexpected number of valid tags at the level %d", level);
+	}
+} TEND
+
+TDEF (lt_ascii_classify) {
+	gchar s[LT_ASCII_CLASSIFY_MAX + 1];
+	static const gchar chars[] = "aZz09-@[`{/:_ \x80\xff";
+	gsize i, len;
+
+	/* the SIMD version has to give the same bitmasks as the scalar one */
+	for (len = 0; len <= LT_ASCII_CLASSIFY_MAX + 1; len++) {
+		for (i = 0; i < sizeof (chars) - 1; i++) {
+			guint64 a1 = 0, d1 = 0, h1 = 0, a2 = 0, d2 = 0, h2 = 0;
+			gboolean r1, r2;
+			gsize j;
+
+			for (j = 0; j < len; j++)
+				s[j] = chars[(i + j * 5) % (sizeof (chars) - 1)];
+			r1 = lt_ascii_classify(s, len, &a1, &d1, &h1);
+			r2 = lt_ascii_classify_scalar(s, len, &a2, &d2, &h2);
+			fail_unless(r1 == r2, "Unexpected result for the length %" G_GSIZE_FORMAT, len);
+			if (len <= LT_ASCII_CLASSIFY_MAX)
+				fail_unless(a1 == a2 && d1 == d2 && h1 == h2, "Unexpected bitmasks for the length %" G_GSIZE_FORMAT, len);
+			/* all of the valid characters */
+			for (j = 0; j < len; j++)
+				s[j] = chars[(i + j) % 6];
+			r1 = lt_ascii_classify(s, len, &a1, &d1, &h1);
+			r2 = lt_ascii_classify_scalar(s, len, &a2, &d2, &h2);
+			fail_unless(r1 == r2 && r1 == (len <= LT_ASCII_CLASSIFY_MAX), "Unexpected result for the length %" G_GSIZE_FORMAT, len);
+			if (len <= LT_ASCII_CLASSIFY_MAX)
+				fail_unless(a1 == a2 && d1 == d2 && h1 == h2, "Unexpected bitmasks for the length %" G_GSIZE_FORMAT, len);
+		}
+	}
+} TEND
+
+TDEF (lt_tag_set_parser) {
+	static const gchar * const tags[] = {
+		"en", "EN-us", "en-Latn-US", "zh-yue-Hant-TW", "zh-Hant", "zh-cmn-Hans",
+		"de-CH-1996", "de-DE-1901-1901", "de-DE-1901-1996", "sl-rozaj-biske-1994",
+		"ja-JP-u-ca-japanese", "en-a-bbb-x-a-ccc", "en-x-foo", "x-foo",
+		"i-default", "En-gb-OeD", "zh-min-nan", "en-US-Latn", "en-", "en--US",
+		"en_US", "blahblahblah", "ar-aao", "es-419", NULL
+	};
+	lt_tag_t *t1, *t2;
+	gint i;
+
+	fail_unless(lt_tag_get_parser() == LT_TAG_PARSER_DEFAULT, "Unexpected default parser.");
+	t1 = lt_tag_new();
+	t2 = lt_tag_new();
+	for (i = 0; tags[i] != NULL; i++) {
+		gboolean r1, r2;
+		gchar *s1, *s2;
+
+		lt_tag_set_parser(LT_TAG_PARSER_STATE_MACHINE);
+		r1 = lt_tag_parse(t1, tags[i], NULL);
+		lt_tag_set_parser(LT_TAG_PARSER_DFA);
+		r2 = lt_tag_parse(t2, tags[i], NULL);
+		fail_unless(r1 == r2, "Unexpected result for %s: %d vs %d", tags[i], r1, r2);
+		if (!r1)
+			continue;
+		fail_unless(lt_tag_compare(t1, t2), "Unexpected tag for %s", tags[i]);
+		s1 = lt_tag_canonicalize(t1, NULL);
+		s2 = lt_tag_canonicalize(t2, NULL);
+		fail_unless(g_strcmp0(s1, s2) == 0, "Unexpected canonicalized tag for %s: %s vs %s", tags[i], s1, s2);
+		g_free(s1);
+		g_free(s2);
+	}
+	lt_tag_set_parser(LT_TAG_PARSER_DEFAULT);
+	lt_tag_unref(t1);
+	lt_tag_unref(t2);
+} TEND
+
+static void
+_check_parse_fast_path(lt_tag_t    *t1,
+		       lt_tag_t    *t2,
+		       const gchar *tag_string)
+{
+	gboolean r1, r2;
+	GError *e1 = NULL, *e2 = NULL;
+
+	lt_tag_set_parser(LT_TAG_PARSER_DEFAULT);
+	r1 = lt_tag_parse(t1, tag_string, &e1);
+	lt_tag_set_parser(LT_TAG_PARSER_STATE_MACHINE);
+	r2 = lt_tag_parse(t2, tag_string, &e2);
+	g_clear_error(&e1);
+	g_clear_error(&e2);
+	fail_unless(r1 == r2, "Unexpected result for %s: %d vs %d", tag_string, r1, r2);
+	if (r1) {
+		fail_unless(lt_tag_compare(t1, t2), "Unexpected tag for %s", tag_string);
+		fail_unless(g_strcmp0(lt_tag_get_string(t1), lt_tag_get_string(t2)) == 0,
+			    "Unexpected tag string for %s: %s vs %s",
+			    tag_string, lt_tag_get_string(t1), lt_tag_get_string(t2));
+	}
+}
+
+TDEF (lt_tag_parse_fast_path) {
+	static const gchar * const extra[] = {
+		"zz", "ZZ-Zzzz-ZZ", "en-ZZZ", "en-Latn-", "en-Latn-US-", "en-US-Latn",
+		"eng-Latn", "e1-US", "en-U1", "en-1234", "en-Latn-999", "abcd",
+		"no-bok", "i-ami", "zh-min", "en-GB-oed", NULL
+	};
+	gchar *contents = NULL, **lines, *type = NULL, *subtag = NULL;
+	GPtrArray *langs = g_ptr_array_new(), *scripts = g_ptr_array_new(), *regions = g_ptr_array_new();
+	lt_tag_t *t1, *t2;
+	gint i;
+
+	fail_unless(g_file_get_contents(TEST_DATADIR "/language-subtag-registry", &contents, NULL, NULL),
+		    "Unable to read the registry.");
+	lines = g_strsplit(contents, "\n", -1);
+	for (i = 0; ; i++) {
+		if (!lines[i] || strcmp(lines[i], "%%") == 0) {
+			if (type && subtag && !strstr(subtag, "..")) {
+				if (strcmp(type, "language") == 0)
+					g_ptr_array_add(langs, subtag);
+				else if (strcmp(type, "script") == 0)
+					g_ptr_array_add(scripts, subtag);
+				else if (strcmp(type, "region") == 0)
+					g_ptr_array_add(regions, subtag);
+			}
+			type = subtag = NULL;
+			if (!lines[i])
+				break;
+		} else if (strncmp(lines[i], "Type: ", 6) == 0) {
+			type = lines[i] + 6;
+		} else if (strncmp(lines[i], "Subtag: ", 8) == 0) {
+			subtag = lines[i] + 8;
+		}
+	}
+	fail_unless(langs->len > 0 && scripts->len > 0 && regions->len > 0, "No subtags in the registry.");
+
+	t1 = lt_tag_new();
+	t2 = lt_tag_new();
+	for (i = 0; i < langs->len; i++) {
+		gchar *s = g_ptr_array_index(langs, i);
+		gchar *tags[] = {
+			g_strdup(s),
+			g_strdup_printf("%s-US", s),
+			g_strdup_printf("%s-Latn", s),
+			g_strdup_printf("%s-Latn-419", s),
+			NULL
+		};
+		gint j;
+
+		for (j = 0; tags[j] != NULL; j++) {
+			_check_parse_fast_path(t1, t2, tags[j]);
+			g_free(tags[j]);
+		}
+	}
+	for (i = 0; i < scripts->len; i++) {
+		gchar *s1 = g_strdup_printf("en-%s", (gchar *)g_ptr_array_index(scripts, i));
+		gchar *s2 = g_strdup_printf("zh-%s-TW", (gchar *)g_ptr_array_index(scripts, i));
+
+		_check_parse_fast_path(t1, t2, s1);
+		_check_parse_fast_path(t1, t2, s2);
+		g_free(s1);
+		g_free(s2);
+	}
+	for (i = 0; i < regions->len; i++) {
+		gchar *s1 = g_strdup_printf("en-%s", (gchar *)g_ptr_array_index(regions, i));
+		gchar *s2 = g_strdup_printf("sr-Latn-%s", (gchar *)g_ptr_array_index(regions, i));
+
+		_check_parse_fast_path(t1, t2, s1);
+		_check_parse_fast_path(t1, t2, s2);
+		g_free(s1);
+		g_free(s2);
+	}
+	for (i = 0; extra[i] != NULL; i++)
+		_check_parse_fast_path(t1, t2, extra[i]);
+	lt_tag_set_parser(LT_TAG_PARSER_DEFAULT);
+
+	lt_tag_unref(t1);
+	lt_tag_unref(t2);
+	g_ptr_array_free(langs, TRUE);
+	g_ptr_array_free(scripts, TRUE);
+	g_ptr_array_free(regions, TRUE);
+	g_strfreev(lines);
+	g_free(contents);
+} TEND
+
 /************************************************************/
 Suite *
 tester_suite(void)
@@ -253,8 +824,25 @@ tester_suite(void)
 
 	T (lt_tag_parse);
 	T (lt_tag_parse_with_extra_token);
+	T (lt_tag_parse_len);
+	T (lt_tag_validate);
+	T (lt_tag_validate_bulk);
+	T (lt_tag_validate_bulk_many);
+	T (lt_ascii_classify);
 	T (lt_tag_canonicalize);
 	T (lt_tag_match);
+	T (lt_tag_match_full);
+	T (lt_tag_copy);
+	T (lt_tag_freeze);
+	T (lt_tag_intern);
+	T (lt_tag_get_thread_locale);
+	T (lt_tag_builder);
+	T (lt_tag_hash);
+	T (lt_tag_encode);
+	T (lt_tag_canonicalize_to_buf);
+	T (lt_tag_convert_to_locale);
+	T (lt_tag_set_parser);
+	T (lt_tag_parse_fast_path);
 
 	suite_add_tcase(s, tc);
 
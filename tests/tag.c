@@ -24,6 +24,7 @@
 #endif
 
 #include <locale.h>
+#include <stdlib.h>
 #include "langtag.h"
 
 int
@@ -40,7 +41,7 @@ main(int    argc,
 	if (g_strcmp0(argv[1], "help") == 0) {
 	  help:
 		g_print("Usage: %s <command> ...\n"
-			"commands: canonicalize, dump, from_locale, lookup, match, to_locale, transform\n",
+			"commands: canonicalize, dump, from_locale, lookup, match, to_locale, transform, validate\n",
 			argv[0]);
 	} else if (g_strcmp0(argv[1], "canonicalize") == 0) {
 		gchar *s;
@@ -94,9 +95,72 @@ main(int    argc,
 			g_print("%s -> %s\n", argv[2], r);
 			g_free(r);
 		}
+	} else if (g_strcmp0(argv[1], "validate") == 0) {
+		static const gchar * const levels[] = {
+			"well-formed", "valid-subtags", "strict"
+		};
+		gchar *contents = NULL, **lines;
+		gboolean *results;
+		GTimer *timer;
+		gsize i, n, count = 0;
+		gint j, l, repeat = argc > 3 ? atoi(argv[3]) : 1;
+
+		/* compare the bulk validation with the full parser */
+		if (!argv[2] || !g_file_get_contents(argv[2], &contents, NULL, NULL)) {
+			g_printerr("Unable to read %s\n", argv[2]);
+			goto bail;
+		}
+		lines = g_strsplit(contents, "\n", -1);
+		n = g_strv_length(lines);
+		results = g_new0(gboolean, n);
+		timer = g_timer_new();
+		for (l = LT_VALIDATION_WELL_FORMED; l <= LT_VALIDATION_STRICT; l++) {
+			g_timer_start(timer);
+			for (j = 0; j < repeat; j++)
+				count = lt_tag_validate_bulk((const gchar * const *)lines, NULL, n,
+							     l, results);
+			g_print("lt_tag_validate_bulk (%s): %" G_GSIZE_FORMAT "/%" G_GSIZE_FORMAT " tags in %f sec\n",
+				levels[l], count, n, g_timer_elapsed(timer, NULL));
+		}
+		g_timer_start(timer);
+		for (j = 0; j < repeat; j++) {
+			for (i = 0, count = 0; i < n; i++) {
+				GError *err = NULL;
+
+				if (lt_tag_parse(tag, lines[i], &err))
+					count++;
+				if (err)
+					g_error_free(err);
+			}
+		}
+		g_print("lt_tag_parse: %" G_GSIZE_FORMAT "/%" G_GSIZE_FORMAT " tags in %f sec\n",
+			count, n, g_timer_elapsed(timer, NULL));
+		/* the bulk validation as the pre-filter for the full parser */
+		g_timer_start(timer);
+		for (j = 0; j < repeat; j++) {
+			lt_tag_validate_bulk((const gchar * const *)lines, NULL, n,
+					     LT_VALIDATION_WELL_FORMED, results);
+			for (i = 0, count = 0; i < n; i++) {
+				GError *err = NULL;
+
+				if (!results[i])
+					continue;
+				if (lt_tag_parse(tag, lines[i], &err))
+					count++;
+				if (err)
+					g_error_free(err);
+			}
+		}
+		g_print("lt_tag_validate_bulk + lt_tag_parse: %" G_GSIZE_FORMAT "/%" G_GSIZE_FORMAT " tags in %f sec\n",
+			count, n, g_timer_elapsed(timer, NULL));
+		g_timer_destroy(timer);
+		g_free(results);
+		g_strfreev(lines);
+		g_free(contents);
 	} else {
 		goto help;
 	}
+  bail:
 	if (tag)
 		lt_tag_unref(tag);
 	lt_db_finalize();